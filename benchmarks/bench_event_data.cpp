@@ -0,0 +1,144 @@
+#include "event_data.hpp"
+#include "event_generator.hpp"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+// Serialization kernels of the sender's per-entry loop. Each benchmark
+// reports time per event (per_event) and throughput of serialized bytes.
+
+// ── Inputs ───────────────────────────────────────────────────────────────────
+
+namespace {
+
+constexpr size_t SAMPLE_EVENTS = 4096;   // cycled through; fits in L2
+
+const std::vector<DalitzEventData>& dalitzSample() {
+    static const std::vector<DalitzEventData> events = [] {
+        PiPiGGGenerator gen(1);
+        std::vector<DalitzEventData> v;
+        for (size_t i = 0; i < SAMPLE_EVENTS; ++i)
+            v.push_back(gen.nextDalitz());
+        return v;
+    }();
+    return events;
+}
+
+// (mag, theta, phi) of the four toy particles, as the toy tree stores them,
+// so the createLorentzVector benchmark times only the conversion
+struct SphericalTracks {
+    double mag[4], theta[4], phi[4];
+};
+
+const std::vector<SphericalTracks>& sphericalSample() {
+    static const std::vector<SphericalTracks> tracks = [] {
+        std::vector<SphericalTracks> v;
+        for (const auto& ev : dalitzSample()) {
+            SphericalTracks t;
+            const TLorentzVector* p[4] = {&ev.pi_plus, &ev.pi_minus, &ev.gamma1, &ev.gamma2};
+            for (size_t k = 0; k < 4; ++k) {
+                t.mag[k]   = p[k]->P();
+                t.theta[k] = p[k]->Theta();
+                t.phi[k]   = p[k]->Phi();
+            }
+            v.push_back(t);
+        }
+        return v;
+    }();
+    return tracks;
+}
+
+const std::vector<double>& gluexSample() {
+    static const std::vector<double> buf = [] {
+        PiPiGGGenerator gen(2);
+        std::vector<double> v;
+        for (size_t i = 0; i < SAMPLE_EVENTS; ++i)
+            gen.next().appendToBuffer(v);
+        return v;
+    }();
+    return buf;
+}
+
+void reportPerEvent(benchmark::State& state, size_t events_per_iter, size_t event_bytes) {
+    const int64_t events = static_cast<int64_t>(state.iterations() * events_per_iter);
+    state.SetItemsProcessed(events);
+    state.SetBytesProcessed(events * static_cast<int64_t>(event_bytes));
+    state.counters["per_event"] = benchmark::Counter(
+        static_cast<double>(events), benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+} // namespace
+
+// ── createLorentzVector ──────────────────────────────────────────────────────
+
+// The toy processor's four calls per entry (spherical → Cartesian)
+void BM_CreateLorentzVector(benchmark::State& state) {
+    const auto& tracks = sphericalSample();
+    size_t i = 0;
+    for (auto _ : state) {
+        const SphericalTracks& t = tracks[i++ % SAMPLE_EVENTS];
+        benchmark::DoNotOptimize(createLorentzVector(t.mag[0], t.theta[0], t.phi[0], 0.139));
+        benchmark::DoNotOptimize(createLorentzVector(t.mag[1], t.theta[1], t.phi[1], 0.139));
+        benchmark::DoNotOptimize(createLorentzVector(t.mag[2], t.theta[2], t.phi[2], 0.0));
+        benchmark::DoNotOptimize(createLorentzVector(t.mag[3], t.theta[3], t.phi[3], 0.0));
+    }
+    reportPerEvent(state, 1, DalitzEventData{}.size());
+}
+BENCHMARK(BM_CreateLorentzVector);
+
+// ── appendToBuffer ───────────────────────────────────────────────────────────
+
+// Fill one batch of range(0) events into a reserved buffer, as process() does
+void BM_DalitzAppendToBuffer(benchmark::State& state) {
+    const auto&  events = dalitzSample();
+    const size_t n      = static_cast<size_t>(state.range(0));
+    std::vector<double> batch;
+    batch.reserve(n * DalitzEventData::NUM_DOUBLES);
+    for (auto _ : state) {
+        batch.clear();
+        for (size_t i = 0; i < n; ++i)
+            events[i % SAMPLE_EVENTS].appendToBuffer(batch);
+        benchmark::DoNotOptimize(batch.data());
+        benchmark::ClobberMemory();
+    }
+    reportPerEvent(state, n, DalitzEventData{}.size());
+}
+BENCHMARK(BM_DalitzAppendToBuffer)->RangeMultiplier(8)->Range(64, 64 << 12);
+
+// ── fromBuffer ───────────────────────────────────────────────────────────────
+
+// Decode range(0) serialized GlueX events, as the validator and converter do
+void BM_GluexFromBuffer(benchmark::State& state) {
+    const auto&  buf = gluexSample();
+    const size_t n   = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            GluexEventData ev = GluexEventData::fromBuffer(
+                buf.data() + (i % SAMPLE_EVENTS) * GluexEventData::NUM_DOUBLES);
+            sum += ev.kfit_prob;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    reportPerEvent(state, n, GluexEventData{}.size());
+}
+BENCHMARK(BM_GluexFromBuffer)->RangeMultiplier(8)->Range(64, 64 << 12);
+
+// ── Batch allocation ─────────────────────────────────────────────────────────
+
+// One sender batch of range(0) MB: allocate and reserve, fill with toy
+// events, free (newBatch / appendEntry / deleteBatch without a segmenter).
+void BM_BatchAllocation(benchmark::State& state) {
+    const auto&  events     = dalitzSample();
+    const size_t batch_size = static_cast<size_t>(state.range(0)) * 1024 * 1024;
+    const size_t n          = batch_size / DalitzEventData{}.size();
+    for (auto _ : state) {
+        auto* batch = new std::vector<double>();
+        batch->reserve(batch_size / sizeof(double));
+        for (size_t i = 0; i < n; ++i)
+            events[i % SAMPLE_EVENTS].appendToBuffer(*batch);
+        benchmark::DoNotOptimize(batch->data());
+        delete batch;
+    }
+    reportPerEvent(state, n, DalitzEventData{}.size());
+}
+BENCHMARK(BM_BatchAllocation)->Arg(1)->Arg(10)->Arg(64)->Unit(benchmark::kMillisecond);
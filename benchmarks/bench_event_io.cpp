@@ -0,0 +1,50 @@
+#include "event_io.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Receiver-side output kernels: naming and writing one .dat file per event.
+
+// ── formatFilename ───────────────────────────────────────────────────────────
+
+void BM_FormatFilename(benchmark::State& state) {
+    uint64_t n = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(formatFilename("event_{:08d}.dat", n++));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_FormatFilename);
+
+// ── writeMemoryMappedFile ────────────────────────────────────────────────────
+
+// Write range(0) KB per file into a scratch directory under $TMPDIR (or
+// /tmp). Page cache speed unless that is a disk-backed filesystem; msync
+// makes each write durable either way.
+void BM_WriteMemoryMappedFile(benchmark::State& state) {
+    const char* tmp = std::getenv("TMPDIR");
+    std::string tmpl = std::string(tmp ? tmp : "/tmp") + "/e2sar_bench_XXXXXX";
+    if (!mkdtemp(tmpl.data())) {
+        state.SkipWithError("cannot create a scratch directory");
+        return;
+    }
+
+    const size_t size = static_cast<size_t>(state.range(0)) * 1024;
+    std::vector<uint8_t> data(size, 0x5a);
+    uint64_t n = 0;
+    for (auto _ : state) {
+        if (!writeMemoryMappedFile(formatFilename(tmpl + "/event_{:08d}.dat", n++ % 16),
+                                   data.data(), size)) {
+            state.SkipWithError("write failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * size));
+
+    std::error_code ec;
+    std::filesystem::remove_all(tmpl, ec);
+}
+BENCHMARK(BM_WriteMemoryMappedFile)->RangeMultiplier(16)->Range(64, 64 << 8)
+    ->Unit(benchmark::kMicrosecond);
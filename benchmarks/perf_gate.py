@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+"""Performance regression gate (meson test --suite perf).
+
+Runs the microbenchmarks and e2sar-bench on a fixed generated dataset,
+reduces them to one number per metric and compares those against the
+committed baseline. Exits 1 if any metric is worse than its tolerance, and
+77 (reported by meson as SKIP) if the baseline file does not exist yet or
+any measured metric has no value in it, since those were not checked.
+
+With --update the measured values are written back to the baseline instead,
+creating it if needed (tolerances and directions already in the file are
+kept), e.g. via
+    meson compile -C build perf-baseline
+"""
+
+import argparse
+import json
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import tempfile
+
+# Fixed loopback workload: toy schema, generated once with a fixed seed into
+# --data-dir, so every run sends the same bytes.
+LOOPBACK_ARGS = ['--toy', '-n', '200000', '--seed', '1', '-j', '2',
+                 '--bufsize-mb', '10', '--mtu', '9000', '--passes', '3']
+
+# Defaults for metrics not yet in the baseline. Relative tolerances are a
+# fraction of the baseline value; absolute ones are added to it.
+DEFAULTS = {
+    'kernels':        {'better': 'lower',  'tolerance': 0.15,  'mode': 'relative'},
+    'gbps':           {'better': 'higher', 'tolerance': 0.15,  'mode': 'relative'},
+    'events_per_s':   {'better': 'higher', 'tolerance': 0.15,  'mode': 'relative'},
+    'latency_p99_ns': {'better': 'lower',  'tolerance': 0.50,  'mode': 'relative'},
+    'loss':           {'better': 'lower',  'tolerance': 0.001, 'mode': 'absolute'},
+}
+
+
+def host_info():
+    cpu = platform.processor() or platform.machine()
+    try:
+        with open('/proc/cpuinfo') as f:
+            for line in f:
+                if line.startswith('model name'):
+                    cpu = line.split(':', 1)[1].strip()
+                    break
+    except OSError:
+        pass
+    return {'cpu': cpu, 'cpus': os.cpu_count()}
+
+
+def run(cmd):
+    print('+ ' + ' '.join(cmd), flush=True)
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    print(result.stdout, end='', flush=True)
+    if result.returncode != 0:
+        raise RuntimeError(f'{os.path.basename(cmd[0])} exited with status {result.returncode}')
+
+
+# meson's exit status for a skipped test
+EXIT_SKIP = 77
+
+BASELINE_DESCRIPTION = (
+    'Reference numbers for benchmarks/perf_gate.py (meson test --suite perf). '
+    'Values are machine-specific: refresh them on the reference machine with '
+    "'meson compile -C build perf-baseline' and commit the result.")
+
+
+# ── Measurements ─────────────────────────────────────────────────────────────
+
+def kernel_metrics(bench_exe, repetitions, scratch):
+    """Median time per event (or per iteration) of every microbenchmark, in ns."""
+    out = os.path.join(scratch, 'kernels.json')
+    run([bench_exe, f'--benchmark_repetitions={repetitions}',
+         '--benchmark_report_aggregates_only=true',
+         f'--benchmark_out={out}', '--benchmark_out_format=json'])
+    with open(out) as f:
+        report = json.load(f)
+
+    scale = {'ns': 1, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+    metrics = {}
+    for b in report['benchmarks']:
+        if b.get('aggregate_name') != 'median':
+            continue
+        if 'per_event' in b:
+            value = b['per_event'] * 1e9          # kInvert rate: seconds per event
+        else:
+            value = b['real_time'] * scale[b.get('time_unit', 'ns')]
+        metrics['kernels/' + b['run_name']] = value
+    return metrics
+
+
+def loopback_metrics(loopback_exe, data_dir, source, repeat, scratch):
+    """Median Gbps, events/s and p99 latency, worst loss, over repeat trials."""
+    out = os.path.join(scratch, f'loopback_{source}.jsonl')
+    run([loopback_exe] + LOOPBACK_ARGS +
+        ['--data-dir', data_dir, '--source', source, '--repeat', str(repeat), '--json', out])
+    with open(out) as f:
+        trials = [json.loads(line) for line in f if line.strip()]
+    if not trials:
+        raise RuntimeError(f'e2sar-bench wrote no results for --source {source}')
+
+    prefix = f'loopback/{source}/'
+    return {
+        prefix + 'gbps':           statistics.median(t['gbps'] for t in trials),
+        prefix + 'events_per_s':   statistics.median(t['events_per_s'] for t in trials),
+        prefix + 'latency_p99_ns': statistics.median(t['latency_ns']['p99'] for t in trials),
+        prefix + 'loss':           max(t['loss'] for t in trials),
+    }
+
+
+# ── Comparison ───────────────────────────────────────────────────────────────
+
+def defaults_for(name):
+    if name.startswith('kernels/'):
+        return dict(DEFAULTS['kernels'])
+    return dict(DEFAULTS[name.rsplit('/', 1)[1]])
+
+
+def check(spec, current):
+    """Return (status, allowed limit) for one metric."""
+    base = spec.get('value')
+    if base is None:
+        return 'new', None
+    tol = spec['tolerance']
+    lower = spec['better'] == 'lower'
+    if spec['mode'] == 'absolute':
+        limit = base + tol if lower else base - tol
+    else:
+        limit = base * (1 + tol) if lower else base * (1 - tol)
+    worse = current > limit if lower else current < limit
+    if worse:
+        return 'REGRESSED', limit
+    if spec['mode'] == 'relative' and base > 0:
+        better = current < base * (1 - tol) if lower else current > base * (1 + tol)
+        if better:
+            return 'improved', limit
+    return 'ok', limit
+
+
+def compare(baseline, measured):
+    """Print the comparison; return (regressed, unchecked) metric counts."""
+    failures = 0
+    unchecked = 0
+    width = max(len(n) for n in measured)
+    print(f'\n{"metric":<{width}}  {"baseline":>12}  {"current":>12}  {"change":>8}  status')
+    for name in sorted(measured):
+        spec = baseline['metrics'].get(name) or defaults_for(name)
+        current = measured[name]
+        status, _ = check(spec, current)
+        base = spec.get('value')
+        change = f'{100 * (current / base - 1):+7.1f}%' if base else '       -'
+        base_str = f'{base:12.4g}' if base is not None else f'{"-":>12}'
+        print(f'{name:<{width}}  {base_str}  {current:12.4g}  {change}  {status}')
+        if status == 'REGRESSED':
+            failures += 1
+        elif status == 'new':
+            unchecked += 1
+
+    missing = sorted(set(baseline['metrics']) - set(measured))
+    for name in missing:
+        print(f'warning: baseline metric {name} was not measured')
+    return failures, unchecked
+
+
+def update(baseline, measured, host):
+    metrics = {}
+    for name in sorted(measured):
+        spec = baseline['metrics'].get(name) or defaults_for(name)
+        spec['value'] = float(f'{measured[name]:.6g}')
+        metrics[name] = spec
+    baseline.pop('metrics', None)
+    baseline['host'] = host
+    baseline['metrics'] = metrics
+
+
+# ── Main ─────────────────────────────────────────────────────────────────────
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--bench', required=True, help='e2sar_utils_bench executable')
+    parser.add_argument('--loopback', required=True, help='e2sar-bench executable')
+    parser.add_argument('--baseline', required=True, help='baseline JSON file')
+    parser.add_argument('--data-dir', required=True, help='cache for the generated dataset')
+    parser.add_argument('--repetitions', type=int, default=5,
+                        help='microbenchmark repetitions (default: 5)')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='loopback trials per source (default: 3)')
+    parser.add_argument('--update', action='store_true',
+                        help='write the measured values to the baseline instead of comparing')
+    args = parser.parse_args()
+
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    else:
+        baseline = {'description': BASELINE_DESCRIPTION}
+    baseline.setdefault('metrics', {})
+
+    if not args.update and not any(spec.get('value') is not None
+                                   for spec in baseline['metrics'].values()):
+        print(f'No baseline recorded in {args.baseline}; run the perf-baseline target '
+              'on the reference machine first')
+        return EXIT_SKIP
+
+    host = host_info()
+    recorded = baseline.get('host')
+    if not args.update and recorded and recorded != host:
+        print(f'warning: baseline was recorded on {recorded["cpu"]} ({recorded["cpus"]} CPUs), '
+              f'this is {host["cpu"]} ({host["cpus"]} CPUs); numbers may not be comparable')
+
+    try:
+        with tempfile.TemporaryDirectory(prefix='e2sar_perf_') as scratch:
+            measured = kernel_metrics(args.bench, args.repetitions, scratch)
+            for source in ('memory', 'root'):
+                measured.update(loopback_metrics(args.loopback, args.data_dir, source,
+                                                 args.repeat, scratch))
+    except (RuntimeError, OSError, KeyError, ValueError) as e:
+        print(f'Error: {e}', file=sys.stderr)
+        return 1
+
+    if args.update:
+        update(baseline, measured, host)
+        with open(args.baseline, 'w') as f:
+            json.dump(baseline, f, indent=2)
+            f.write('\n')
+        print(f'\nWrote {len(measured)} metrics to {args.baseline}')
+        return 0
+
+    failures, unchecked = compare(baseline, measured)
+    if failures:
+        print(f'\n{failures} metric(s) regressed beyond tolerance', file=sys.stderr)
+        return 1
+    if unchecked:
+        print(f'\nNo baseline recorded for {unchecked} metric(s); refresh the baseline '
+              'to check them')
+        return EXIT_SKIP
+    print('\nNo regressions')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
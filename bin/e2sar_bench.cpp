@@ -0,0 +1,682 @@
+#include "loopback_bench.hpp"
+#include "scaling.hpp"
+#include "memory_model.hpp"
+#include "alloc_stats.hpp"
+#include "event_generator.hpp"
+#include "event_io.hpp"
+#include "tree_writer.hpp"
+#include "file_processor.hpp"
+#include "stats_json.hpp"
+#include <TROOT.h>
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+#include <cstdio>
+
+namespace po = boost::program_options;
+
+struct BenchArgs {
+    std::vector<std::string> files;
+    std::string data_dir = "/tmp/e2sar-bench-data";
+    uint64_t    events_per_file = 500000;
+    uint64_t    seed = 1;
+    std::string source = "root";
+    std::vector<size_t> threads, segmenters, bufsize_mb, mtu, recv_threads, dequeue_threads, event_timeout;
+    std::vector<float>  rates;
+    size_t      repeat = 1;
+    ScalingMode scaling = ScalingMode::None;
+    std::string csv_file;
+    std::string json_file;
+    std::string scaling_csv_file;
+    std::string memory_model_file;
+    double      memory_headroom = 0.2;
+    BenchConfig base;
+    bool        use_toy   = false;
+    bool        use_gluex = false;
+};
+
+// Comma-separated sweep values, e.g. "1,2,4"; all must be > 0.
+std::vector<size_t> parseSweep(const std::string& option, const std::string& list) {
+    std::vector<size_t> values;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        size_t pos = 0;
+        long long v = -1;
+        try {
+            v = std::stoll(item, &pos);
+        } catch (const std::logic_error&) {}
+        if (v <= 0 || pos != item.size())
+            throw std::runtime_error("--" + option + " expects positive integers, e.g. 1,2,4 (got '" + list + "')");
+        values.push_back(static_cast<size_t>(v));
+    }
+    if (values.empty())
+        throw std::runtime_error("--" + option + " needs at least one value");
+    return values;
+}
+
+// Comma-separated rate limits in Gbps, e.g. "0,1,5"; <= 0 means none.
+std::vector<float> parseRates(const std::string& list) {
+    std::vector<float> values;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        size_t pos = 0;
+        float v = 0;
+        try {
+            v = std::stof(item, &pos);
+        } catch (const std::logic_error&) {
+            pos = 0;
+        }
+        if (pos != item.size())
+            throw std::runtime_error("--rate expects numbers in Gbps, e.g. 0,1,5 (got '" + list + "')");
+        values.push_back(v);
+    }
+    if (values.empty())
+        throw std::runtime_error("--rate needs at least one value");
+    return values;
+}
+
+BenchArgs parseArgs(int argc, char* argv[]) {
+    BenchArgs args;
+    std::string threads, segmenters, bufsize, mtu, recv_threads, dequeue_threads, event_timeout, impair, scaling, rate;
+
+    po::options_description desc("E2SAR Bench - In-process sender/receiver loopback benchmark");
+    desc.add_options()
+        ("help,h", "Show this help message")
+        ("toy", po::bool_switch(&args.use_toy)->default_value(false),
+         "Dalitz toy-MC schema (default)")
+        ("gluex", po::bool_switch(&args.use_gluex)->default_value(false),
+         "GlueX kinematic-fit schema")
+        ("files", po::value<std::vector<std::string>>(&args.files),
+         "ROOT files to send (default: generated into --data-dir)")
+        ("tree,t", po::value<std::string>(&args.base.tree_name),
+         "Tree name (default: dalitz_root_tree or myTree)")
+        ("data-dir", po::value<std::string>(&args.data_dir)->default_value("/tmp/e2sar-bench-data"),
+         "Cache directory for generated input files (default: /tmp/e2sar-bench-data)")
+        ("events,n", po::value<uint64_t>(&args.events_per_file)->default_value(500000),
+         "Events per generated file (default: 500000)")
+        ("seed", po::value<uint64_t>(&args.seed)->default_value(1),
+         "Seed for generated files (default: 1)")
+        ("source", po::value<std::string>(&args.source)->default_value("root"),
+         "root: read the ROOT files during the trial; memory: replay preloaded batches (default: root)")
+        ("passes", po::value<size_t>(&args.base.passes)->default_value(1),
+         "Times each sender thread sends its file; with --scaling strong, times each file is sent (default: 1)")
+        ("threads,j", po::value<std::string>(&threads)->default_value("1"),
+         "Sender file threads to sweep, e.g. 1,2,4 (default: 1)")
+        ("segmenters", po::value<std::string>(&segmenters)->default_value("1"),
+         "Segmenters the sender threads share, to sweep; counts above -j are skipped (default: 1)")
+        ("bufsize-mb", po::value<std::string>(&bufsize)->default_value("10"),
+         "Batch sizes in MB to sweep (default: 10)")
+        ("mtu", po::value<std::string>(&mtu)->default_value("9000"),
+         "MTUs to sweep (default: 9000)")
+        ("recv-threads", po::value<std::string>(&recv_threads)->default_value("1"),
+         "Reassembler receive threads to sweep (default: 1)")
+        ("dequeue-threads", po::value<std::string>(&dequeue_threads)->default_value("1"),
+         "Dequeue threads to sweep (default: 1)")
+        ("rate", po::value<std::string>(&rate)->default_value("0"),
+         "Segmenter rate limits in Gbps to sweep, <= 0 for none (default: none)")
+        ("recv-port", po::value<uint16_t>(&args.base.port)->default_value(19522),
+         "Starting UDP port for the receiver (default: 19522)")
+        ("event-timeout", po::value<std::string>(&event_timeout)->default_value("500"),
+         "Reassembly timeouts in ms to sweep (default: 500)")
+        ("impair", po::value<std::string>(&impair),
+         "Route through a proxy that impairs frames: loss=P,burst=P:LEN,dup=P,reorder=P,"
+         "reorder-delay=T,delay=T,jitter=T,seed=N (T in us/ms/s, default ms)")
+        ("proxy", po::bool_switch(&args.base.proxy)->default_value(false),
+         "Route through the proxy even without --impair (measures its overhead)")
+        ("proxy-port", po::value<uint16_t>(&args.base.proxy_port)->default_value(19500),
+         "UDP port of the proxy (default: 19500)")
+        ("withcp", po::bool_switch(&args.base.control_plane)->default_value(false),
+         "Take the control-plane path against an in-process mock CP: registration, "
+         "state reports and CP steering, with data through its data plane on --proxy-port")
+        ("cp-port", po::value<uint16_t>(&args.base.cp_port)->default_value(18347),
+         "gRPC port of the mock control plane (default: 18347)")
+        ("cp-epoch-ms", po::value<int>(&args.base.cp_epoch_ms)->default_value(1000),
+         "Mock CP calendar rebuild period; bounds receiver startup latency (default: 1000)")
+        ("repeat", po::value<size_t>(&args.repeat)->default_value(1),
+         "Trials per configuration (default: 1)")
+        ("scaling", po::value<std::string>(&scaling),
+         "strong: the -j threads share a fixed set of file sends (all files x --passes); "
+         "weak: each thread sends its own file --passes times. Prints speedup and efficiency per curve")
+        ("scaling-csv", po::value<std::string>(&args.scaling_csv_file),
+         "Write one CSV row per scaling curve point to this file (needs --scaling)")
+        ("memory", po::bool_switch(&args.base.memory)->default_value(false),
+         "Record peak RSS, page faults and the in-flight batch high-water mark per trial, "
+         "then fit a sender memory model (needs --source root)")
+        ("memory-model", po::value<std::string>(&args.memory_model_file),
+         "Write the fitted memory model as JSON to this file (needs --memory)")
+        ("memory-headroom", po::value<double>(&args.memory_headroom)->default_value(0.2),
+         "Margin over the model's prediction for suggested memory limits (default: 0.2)")
+        ("csv", po::value<std::string>(&args.csv_file),
+         "Write one CSV row per trial to this file")
+        ("json", po::value<std::string>(&args.json_file),
+         "Write one JSON Lines record per trial to this file");
+
+    po::positional_options_description pos;
+    pos.add("files", -1);
+
+    po::variables_map vm;
+
+    try {
+        po::store(po::command_line_parser(argc, argv)
+                  .options(desc)
+                  .positional(pos)
+                  .run(), vm);
+
+        if (vm.count("help")) {
+            std::cout << "Usage: " << argv[0] << " [--toy|--gluex] [OPTIONS] [file.root ...]\n\n"
+                      << desc << "\n"
+                      << "Examples:\n"
+                      << "  " << argv[0] << " -j 1,2,4 --bufsize-mb 1,10 --mtu 1500,9000\n"
+                      << "  " << argv[0] << " --gluex --source memory --passes 5 --csv bench.csv\n"
+                      << "  " << argv[0] << " --source memory --impair loss=0.0001,burst=0.00001:50,delay=10ms \\\n"
+                      << "      --event-timeout 100,500,2000 --bufsize-mb 1,10 --mtu 1500,9000 --csv wan.csv\n"
+                      << "  " << argv[0] << " --source memory --withcp --cp-epoch-ms 100 --repeat 5\n"
+                      << "  " << argv[0] << " --source memory --scaling strong -j 1,2,4,8 --segmenters 1,2,4 \\\n"
+                      << "      --recv-threads 1,4 --repeat 3 --scaling-csv strong.csv\n"
+                      << "  " << argv[0] << " --memory -j 1,2,4 --bufsize-mb 1,10,50 --rate 0,1 \\\n"
+                      << "      --memory-model memory.json --csv memory.csv\n";
+            std::exit(0);
+        }
+
+        po::notify(vm);
+
+        if (args.use_toy && args.use_gluex)
+            throw std::runtime_error("--toy and --gluex are mutually exclusive");
+        if (args.source != "root" && args.source != "memory")
+            throw std::runtime_error("--source must be root or memory");
+        if (args.events_per_file == 0)
+            throw std::runtime_error("--events must be greater than 0");
+        if (args.base.passes == 0)
+            throw std::runtime_error("--passes must be greater than 0");
+        if (args.repeat == 0)
+            throw std::runtime_error("--repeat must be greater than 0");
+        if (!impair.empty() && !parseImpairment(impair, args.base.impairment))
+            throw std::runtime_error("invalid --impair");
+        if (args.base.cp_epoch_ms <= 0)
+            throw std::runtime_error("--cp-epoch-ms must be greater than 0");
+        if (!scaling.empty() && !parseScalingMode(scaling, args.scaling))
+            throw std::runtime_error("--scaling must be strong or weak");
+        if (!args.scaling_csv_file.empty() && args.scaling == ScalingMode::None)
+            throw std::runtime_error("--scaling-csv needs --scaling");
+        if (args.base.memory && args.source != "root")
+            throw std::runtime_error("--memory needs --source root: preloaded batches hide the sender's buffering");
+        if (!args.memory_model_file.empty() && !args.base.memory)
+            throw std::runtime_error("--memory-model needs --memory");
+        if (args.memory_headroom < 0)
+            throw std::runtime_error("--memory-headroom must not be negative");
+
+        args.threads         = parseSweep("threads", threads);
+        args.segmenters      = parseSweep("segmenters", segmenters);
+        args.bufsize_mb      = parseSweep("bufsize-mb", bufsize);
+        args.mtu             = parseSweep("mtu", mtu);
+        args.recv_threads    = parseSweep("recv-threads", recv_threads);
+        args.dequeue_threads = parseSweep("dequeue-threads", dequeue_threads);
+        args.event_timeout   = parseSweep("event-timeout", event_timeout);
+        args.rates           = parseRates(rate);
+        for (size_t m : args.mtu)
+            if (m < 576 || m > 9000)
+                throw std::runtime_error("--mtu values must be between 576 and 9000 bytes");
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << desc << std::endl;
+        throw;
+    }
+
+    args.base.use_toy     = !args.use_gluex;
+    args.base.from_memory = args.source == "memory";
+    if (args.base.tree_name.empty())
+        args.base.tree_name = args.base.use_toy ? ToyTreeWriter::DEFAULT_TREE : GluexTreeWriter::DEFAULT_TREE;
+
+    return args;
+}
+
+// Generated inputs are cached by schema, size and seed; files already there
+// are reused. Returns false if any could not be written.
+bool prepareFiles(BenchArgs& args) {
+    if (!args.files.empty())
+        return true;
+
+    size_t count = *std::max_element(args.threads.begin(), args.threads.end());
+    std::string pattern = args.data_dir + "/" + (args.base.use_toy ? "toy" : "gluex") + "_" +
+                          std::to_string(args.events_per_file) + "_seed" + std::to_string(args.seed) +
+                          "_{:d}.root";
+    std::error_code ec;
+    std::filesystem::create_directories(args.data_dir, ec);
+
+    std::vector<std::thread> writers;
+    std::atomic<size_t> failed{0};
+    for (size_t i = 0; i < count; ++i) {
+        args.files.push_back(formatFilename(pattern, i));
+        if (std::filesystem::exists(args.files.back()))
+            continue;
+        writers.emplace_back([&args, &failed, i, path = args.files.back()]() {
+            // Write under a temporary name so an interrupted run is not cached
+            std::string tmp = path + ".tmp";
+            PiPiGGGenerator gen(streamSeed(args.seed, i));
+            bool ok;
+            if (args.base.use_toy) {
+                ToyTreeWriter writer;
+                ok = writer.open(tmp, args.base.tree_name);
+                for (uint64_t n = 0; ok && n < args.events_per_file; ++n)
+                    writer.fill(gen.nextDalitz());
+                ok = writer.close() && ok;
+            } else {
+                GluexTreeWriter writer;
+                ok = writer.open(tmp, args.base.tree_name);
+                for (uint64_t n = 0; ok && n < args.events_per_file; ++n)
+                    writer.fill(gen.next());
+                ok = writer.close() && ok;
+            }
+            std::error_code rename_ec;
+            if (ok)
+                std::filesystem::rename(tmp, path, rename_ec);
+            if (!ok || rename_ec)
+                failed++;
+        });
+    }
+    if (!writers.empty())
+        std::cout << "Generating " << writers.size() << " input file(s) of " << args.events_per_file
+                  << " events in " << args.data_dir << "..." << std::endl;
+    for (auto& t : writers)
+        t.join();
+    return failed == 0;
+}
+
+// Distinct source files a trial reads
+size_t filesRead(const BenchConfig& c) {
+    return std::min(c.file_sends ? c.file_sends : c.sender_threads, c.files.size());
+}
+
+void printHeader() {
+    std::printf("%7s %3s %6s %5s %4s %4s %6s | %8s %9s %7s %8s %10s | %9s %9s %9s\n",
+                "threads", "seg", "bufMB", "mtu", "recv", "deq", "tmo_ms",
+                "Gbps", "Mevt/s", "loss%", "reasm", "cores/Gbps", "p50", "p99", "p99.9");
+}
+
+std::string formatRate(float rate_gbps) {
+    if (rate_gbps <= 0) return "none";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%g Gbps", rate_gbps);
+    return buf;
+}
+
+void printRow(const BenchConfig& c, const BenchResult& r) {
+    char startup[32] = "";
+    if (c.control_plane)
+        std::snprintf(startup, sizeof(startup), "  cp startup %.1fms", r.cp_startup_ms);
+    char memory[160] = "";
+    if (c.memory)
+        std::snprintf(memory, sizeof(memory), "  rate %s, RSS peak %s, in flight %s (%lu), faults %lu/%lu",
+                      formatRate(c.rate_gbps).c_str(), formatBytes(r.peak_rss_bytes).c_str(),
+                      formatBytes(r.inflight_peak_bytes).c_str(),
+                      static_cast<unsigned long>(r.inflight_peak_batches),
+                      static_cast<unsigned long>(r.minor_faults), static_cast<unsigned long>(r.major_faults));
+    std::printf("%7zu %3zu %6zu %5u %4zu %4zu %6d | %8.3f %9.3f %7.3f %8lu %10.3f | %9s %9s %9s%s%s%s\n",
+                c.sender_threads, c.segmenters, c.bufsize_mb, static_cast<unsigned>(c.mtu), c.recv_threads,
+                c.dequeue_threads, c.event_timeout_ms, r.gbps(), r.eventsPerSecond() / 1e6,
+                100 * r.lossFraction(), static_cast<unsigned long>(r.reassembly_loss), r.coresPerGbps(), formatNanos(r.latency.percentile(0.50)).c_str(),
+                formatNanos(r.latency.percentile(0.99)).c_str(),
+                formatNanos(r.latency.percentile(0.999)).c_str(), startup, memory, r.ok ? "" : "  FAILED");
+    std::fflush(stdout);
+}
+
+const char* CSV_HEADER =
+    "threads,segmenters,files,bufsize_mb,mtu,recv_threads,dequeue_threads,event_timeout_ms,rate_gbps,"
+    "source,scaling,impairment,control_plane,"
+    "gbps,events_per_s,loss,cores_per_gbps,latency_p50_ns,latency_p99_ns,latency_p999_ns,"
+    "latency_max_ns,buffers_sent,buffers_received,reassembly_loss,enqueue_loss,send_errors,"
+    "impaired_drops,duplicated,reordered,cp_startup_ms,start_rss_bytes,peak_rss_bytes,minor_faults,"
+    "major_faults,inflight_peak_bytes,inflight_peak_batches,seconds,ok";
+
+void writeCsvRow(std::ostream& out, ScalingMode scaling, const BenchConfig& c, const BenchResult& r) {
+    out << c.sender_threads << ',' << c.segmenters << ',' << filesRead(c) << ',' << c.bufsize_mb << ','
+        << c.mtu << ',' << c.recv_threads << ',' << c.dequeue_threads << ',' << c.event_timeout_ms << ','
+        << (c.rate_gbps > 0 ? c.rate_gbps : 0) << ',' << (c.from_memory ? "memory" : "root") << ','
+        << scalingModeName(scaling) << ",\"" << c.impairment.describe() << "\","
+        << (c.control_plane ? 1 : 0) << ','
+        << r.gbps() << ',' << r.eventsPerSecond() << ',' << r.lossFraction() << ','
+        << r.coresPerGbps() << ',' << r.latency.percentile(0.50) << ','
+        << r.latency.percentile(0.99) << ',' << r.latency.percentile(0.999) << ','
+        << r.latency.max() << ',' << r.buffers_sent << ',' << r.buffers_received << ','
+        << r.reassembly_loss << ',' << r.enqueue_loss << ',' << r.send_errors << ','
+        << r.impaired_drops << ',' << r.duplicated << ',' << r.reordered << ','
+        << r.cp_startup_ms << ',' << r.start_rss_bytes << ',' << r.peak_rss_bytes << ','
+        << r.minor_faults << ',' << r.major_faults << ',' << r.inflight_peak_bytes << ','
+        << r.inflight_peak_batches << ',' << r.seconds << ',' << (r.ok ? 1 : 0) << '\n';
+}
+
+void writeJsonRecord(JsonLinesFile& out, std::chrono::steady_clock::time_point start,
+                     ScalingMode scaling, const BenchConfig& c, const BenchResult& r) {
+    JsonWriter json;
+    beginStatsRecord(json, "bench", true, start);
+    json.beginObject("config")
+        .field("threads", static_cast<uint64_t>(c.sender_threads))
+        .field("segmenters", static_cast<uint64_t>(c.segmenters))
+        .field("files", static_cast<uint64_t>(filesRead(c)))
+        .field("scaling", scalingModeName(scaling))
+        .field("bufsize_mb", static_cast<uint64_t>(c.bufsize_mb))
+        .field("mtu", static_cast<uint64_t>(c.mtu))
+        .field("recv_threads", static_cast<uint64_t>(c.recv_threads))
+        .field("dequeue_threads", static_cast<uint64_t>(c.dequeue_threads))
+        .field("event_timeout_ms", static_cast<uint64_t>(c.event_timeout_ms))
+        .field("proxy", c.routed())
+        .field("impairment", c.impairment.describe())
+        .field("control_plane", c.control_plane)
+        .field("source", c.from_memory ? "memory" : "root")
+        .field("passes", static_cast<uint64_t>(c.passes))
+        .field("rate_gbps", static_cast<double>(c.rate_gbps))
+        .endObject();
+    json.field("ok", r.ok)
+        .field("seconds", r.seconds)
+        .field("gbps", r.gbps())
+        .field("events_per_s", r.eventsPerSecond())
+        .field("loss", r.lossFraction())
+        .field("cpu_seconds", r.cpu_seconds)
+        .field("cores_per_gbps", r.coresPerGbps())
+        .field("buffers_sent", r.buffers_sent)
+        .field("buffers_received", r.buffers_received)
+        .field("bytes_received", r.bytes_received)
+        .field("reassembly_loss", r.reassembly_loss)
+        .field("enqueue_loss", r.enqueue_loss)
+        .field("send_errors", r.send_errors)
+        .field("impaired_drops", r.impaired_drops)
+        .field("duplicated", r.duplicated)
+        .field("reordered", r.reordered);
+    if (c.control_plane)
+        json.field("cp_startup_ms", r.cp_startup_ms);
+    if (c.memory) {
+        json.beginObject("memory")
+            .field("start_rss", r.start_rss_bytes)
+            .field("peak_rss", r.peak_rss_bytes)
+            .field("minor_faults", r.minor_faults)
+            .field("major_faults", r.major_faults)
+            .field("inflight_peak_bytes", r.inflight_peak_bytes)
+            .field("inflight_peak_batches", r.inflight_peak_batches)
+            .endObject();
+    }
+    json.beginObject("latency_ns")
+        .field("p50", r.latency.percentile(0.50))
+        .field("p99", r.latency.percentile(0.99))
+        .field("p999", r.latency.percentile(0.999))
+        .field("max", r.latency.max())
+        .endObject();
+    json.endObject();
+    out.write(json);
+}
+
+// ── Scaling summary ──────────────────────────────────────────────────────────
+
+// Trials that differ only in sender threads form one curve
+struct CurveTrials {
+    BenchConfig  config;
+    ScalingCurve curve;
+};
+
+bool sameCurve(const BenchConfig& a, const BenchConfig& b) {
+    return a.segmenters == b.segmenters && a.bufsize_mb == b.bufsize_mb && a.mtu == b.mtu &&
+           a.recv_threads == b.recv_threads && a.dequeue_threads == b.dequeue_threads &&
+           a.event_timeout_ms == b.event_timeout_ms && a.rate_gbps == b.rate_gbps;
+}
+
+void addToCurve(std::vector<CurveTrials>& curves, const BenchConfig& c, const BenchResult& r) {
+    auto it = std::find_if(curves.begin(), curves.end(),
+                           [&c](const CurveTrials& t) { return sameCurve(t.config, c); });
+    if (it == curves.end())
+        it = curves.insert(curves.end(), CurveTrials{c, ScalingCurve{}});
+    it->curve.add(c.sender_threads, r.gbps());
+}
+
+void printScalingSummary(ScalingMode scaling, const BenchArgs& args, const std::vector<CurveTrials>& curves) {
+    if (scaling == ScalingMode::Strong)
+        std::printf("\n=== Strong scaling: %zu file(s) x %zu pass(es) in total ===\n",
+                    args.files.size(), args.base.passes);
+    else
+        std::printf("\n=== Weak scaling: one file x %zu pass(es) per sender thread ===\n", args.base.passes);
+
+    for (const auto& t : curves) {
+        const BenchConfig& c = t.config;
+        std::printf("\nsegmenters %zu, recv %zu, deq %zu, %zu MB, mtu %u, timeout %d ms\n",
+                    c.segmenters, c.recv_threads, c.dequeue_threads, c.bufsize_mb,
+                    static_cast<unsigned>(c.mtu), c.event_timeout_ms);
+        std::printf("  %7s %6s %8s %8s %10s\n", "threads", "trials", "Gbps", "speedup", "efficiency");
+        const auto points = t.curve.points();
+        for (const auto& p : points)
+            std::printf("  %7zu %6zu %8.3f %8.2f %9.1f%%\n", p.threads, p.trials, p.gbps, p.speedup,
+                        100 * p.efficiency);
+        if (points.size() < 2)
+            std::printf("  (one thread count; nothing to compare)\n");
+        else if (size_t knee = t.curve.knee())
+            std::printf("  stops scaling at %zu threads (efficiency below %.0f%%)\n", knee,
+                        100 * ScalingCurve::DEFAULT_KNEE_EFFICIENCY);
+        else
+            std::printf("  scales to %zu threads\n", points.back().threads);
+    }
+    std::fflush(stdout);
+}
+
+bool writeScalingCsv(const std::string& path, ScalingMode scaling, const std::vector<CurveTrials>& curves) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Error: Cannot create " << path << std::endl;
+        return false;
+    }
+    out << "scaling,segmenters,bufsize_mb,mtu,recv_threads,dequeue_threads,event_timeout_ms,"
+           "threads,trials,gbps,speedup,efficiency\n";
+    for (const auto& t : curves) {
+        const BenchConfig& c = t.config;
+        for (const auto& p : t.curve.points())
+            out << scalingModeName(scaling) << ',' << c.segmenters << ',' << c.bufsize_mb << ','
+                << c.mtu << ',' << c.recv_threads << ',' << c.dequeue_threads << ','
+                << c.event_timeout_ms << ',' << p.threads << ',' << p.trials << ',' << p.gbps << ','
+                << p.speedup << ',' << p.efficiency << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+// ── Memory model ─────────────────────────────────────────────────────────────
+
+// Largest measured peak RSS per (threads, bufsize, rate) over the repeats
+using MemoryConfigKey = std::tuple<size_t, size_t, double>;
+
+std::map<MemoryConfigKey, uint64_t> measuredPeaks(const MemoryModel& model) {
+    std::map<MemoryConfigKey, uint64_t> peaks;
+    for (const auto& s : model.samples()) {
+        uint64_t& peak = peaks[{s.threads, s.bufsize_mb, s.rate_gbps > 0 ? s.rate_gbps : 0.0}];
+        peak = std::max(peak, s.peak_rss_bytes);
+    }
+    return peaks;
+}
+
+std::string formatSignedBytes(double bytes) {
+    return bytes < 0 ? "-" + formatBytes(static_cast<uint64_t>(-bytes)) : formatBytes(static_cast<uint64_t>(bytes));
+}
+
+void printMemoryModel(const MemoryModel& model, double headroom) {
+    std::printf("\n=== Sender memory model (%zu trial(s)) ===\n", model.samples().size());
+    std::printf("peak RSS = %s + %s per file thread + %.3f x batch memory in flight\n",
+                formatSignedBytes(model.baseBytes()).c_str(), formatSignedBytes(model.perThreadBytes()).c_str(),
+                model.perInflightByte());
+    std::printf("batch memory in flight = file threads x bufsize x depth; depth by rate:");
+    for (const auto& [rate, depth] : model.depths())
+        std::printf("  %s %.1f", formatRate(static_cast<float>(rate)).c_str(), depth);
+    std::printf("\nat most %.1f%% under the measured peaks; RSS is the whole process, receiver included\n\n",
+                100 * model.maxUnderPrediction());
+
+    std::printf("%7s %6s %10s | %10s %10s %10s\n", "threads", "bufMB", "rate", "measured", "model",
+                "limit");
+    for (const auto& [key, peak] : measuredPeaks(model)) {
+        const auto& [threads, bufsize, rate] = key;
+        double predicted = model.predictBytes(threads, bufsize, rate);
+        std::printf("%7zu %6zu %10s | %10s %10s %10s\n", threads, bufsize,
+                    formatRate(static_cast<float>(rate)).c_str(), formatBytes(peak).c_str(),
+                    formatSignedBytes(predicted).c_str(),
+                    formatSignedBytes(predicted * (1 + headroom)).c_str());
+    }
+    std::printf("(limit = model + %.0f%% headroom)\n", 100 * headroom);
+    std::fflush(stdout);
+}
+
+bool writeMemoryModel(const std::string& path, const MemoryModel& model, double headroom) {
+    JsonWriter json;
+    json.beginObject()
+        .field("base_bytes", model.baseBytes())
+        .field("per_thread_bytes", model.perThreadBytes())
+        .field("per_inflight_byte", model.perInflightByte())
+        .field("max_under_prediction", model.maxUnderPrediction())
+        .field("headroom", headroom);
+    json.beginArray("depths");
+    for (const auto& [rate, depth] : model.depths())
+        json.beginObject().field("rate_gbps", rate).field("batches_per_thread", depth).endObject();
+    json.endArray();
+    json.beginArray("configs");
+    for (const auto& [key, peak] : measuredPeaks(model)) {
+        const auto& [threads, bufsize, rate] = key;
+        double predicted = model.predictBytes(threads, bufsize, rate);
+        json.beginObject()
+            .field("threads", static_cast<uint64_t>(threads))
+            .field("bufsize_mb", static_cast<uint64_t>(bufsize))
+            .field("rate_gbps", rate)
+            .field("peak_rss", peak)
+            .field("model_bytes", predicted)
+            .field("limit_bytes", predicted * (1 + headroom))
+            .endObject();
+    }
+    json.endArray();
+    json.endObject();
+
+    std::ofstream out(path);
+    out << json.str() << '\n';
+    if (!out) {
+        std::cerr << "Error: Cannot write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    ROOT::EnableThreadSafety();
+
+    try {
+        auto args = parseArgs(argc, argv);
+        verbosity = 0;   // keep processor progress out of the results table
+
+        if (!prepareFiles(args)) {
+            std::cerr << "Failed to generate input files in " << args.data_dir << std::endl;
+            return 1;
+        }
+        args.base.files = args.files;
+        if (args.base.memory && !resetPeakRss())
+            std::cerr << "Warning: cannot reset peak RSS (/proc/self/clear_refs); "
+                         "each trial reports the process peak so far" << std::endl;
+        if (args.scaling == ScalingMode::Strong)
+            args.base.file_sends = args.files.size() * args.base.passes;
+
+        std::ofstream csv;
+        if (!args.csv_file.empty()) {
+            csv.open(args.csv_file);
+            if (!csv) {
+                std::cerr << "Error: Cannot create " << args.csv_file << std::endl;
+                return 1;
+            }
+            csv << CSV_HEADER << '\n';
+        }
+        JsonLinesFile json;
+        if (!args.json_file.empty() && !json.open(args.json_file))
+            return 1;
+
+        std::cout << "Loopback benchmark: " << args.files.size() << " source file(s), "
+                  << (args.base.from_memory ? "preloaded batches" : "read from ROOT") << ", "
+                  << args.base.passes << " pass(es) per sender thread";
+        if (args.base.control_plane)
+            std::cout << ", via mock control plane on port " << args.base.cp_port << " (epoch "
+                      << args.base.cp_epoch_ms << " ms, impairment " << args.base.impairment.describe() << ")";
+        else if (args.base.routed())
+            std::cout << ", via proxy on port " << args.base.proxy_port << " (impairment "
+                      << args.base.impairment.describe() << ")";
+        if (args.scaling != ScalingMode::None)
+            std::cout << ", " << scalingModeName(args.scaling) << " scaling";
+        if (args.base.memory)
+            std::cout << ", memory accounting";
+        std::cout << "\n" << std::endl;
+        printHeader();
+
+        auto start = std::chrono::steady_clock::now();
+        std::map<size_t, std::vector<BenchBatches>> preloaded;   // by bufsize_mb
+        size_t failures = 0;
+        std::vector<CurveTrials> curves;
+        MemoryModel memory;
+
+        for (size_t bufsize : args.bufsize_mb) {
+            BenchConfig config = args.base;
+            config.bufsize_mb = bufsize;
+            if (config.from_memory && !preloaded.count(bufsize)) {
+                if (!loadBenchBatches(config, preloaded[bufsize]))
+                    return 1;
+            }
+            for (size_t threads : args.threads)
+            for (size_t seg : args.segmenters)
+            for (size_t mtu : args.mtu)
+            for (size_t recv : args.recv_threads)
+            for (size_t deq : args.dequeue_threads)
+            for (size_t timeout : args.event_timeout)
+            for (float rate : args.rates)
+            for (size_t rep = 0; rep < args.repeat; ++rep) {
+                if (seg > threads) continue;   // a Segmenter per thread at most
+                config.sender_threads  = threads;
+                config.segmenters      = seg;
+                config.mtu             = static_cast<uint16_t>(mtu);
+                config.recv_threads    = recv;
+                config.dequeue_threads = deq;
+                config.event_timeout_ms = static_cast<int>(timeout);
+                config.rate_gbps       = rate;
+                BenchResult result = runLoopbackTrial(config,
+                    config.from_memory ? &preloaded[bufsize] : nullptr);
+                printRow(config, result);
+                if (csv.is_open()) writeCsvRow(csv, args.scaling, config, result);
+                if (json.isOpen()) writeJsonRecord(json, start, args.scaling, config, result);
+                if (!result.ok) {
+                    failures++;
+                    continue;
+                }
+                if (args.scaling != ScalingMode::None)
+                    addToCurve(curves, config, result);
+                if (config.memory)
+                    memory.add({filesRead(config), config.bufsize_mb, config.rate_gbps, result.peak_rss_bytes,
+                                result.inflight_peak_bytes, result.inflight_peak_batches});
+            }
+        }
+
+        if (args.scaling != ScalingMode::None) {
+            printScalingSummary(args.scaling, args, curves);
+            if (!args.scaling_csv_file.empty() && !writeScalingCsv(args.scaling_csv_file, args.scaling, curves))
+                return 1;
+        }
+
+        if (args.base.memory && memory.fit()) {
+            printMemoryModel(memory, args.memory_headroom);
+            if (!args.memory_model_file.empty() && !writeMemoryModel(args.memory_model_file, memory, args.memory_headroom))
+                return 1;
+        }
+
+        if (failures > 0)
+            std::cerr << "\n" << failures << " trial(s) failed" << std::endl;
+        return failures == 0 ? 0 : 1;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
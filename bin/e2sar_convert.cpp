@@ -0,0 +1,243 @@
+#include "event_capture.hpp"
+#include "event_io.hpp"
+#include "tree_writer.hpp"
+#include <TROOT.h>
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <cstring>
+
+namespace po = boost::program_options;
+
+struct ConvertArgs {
+    std::vector<std::string> dat_files;
+    std::vector<std::string> capture_files;
+    std::string              output_pattern = "converted_{:03d}.root";
+    std::string              tree_name;
+    size_t                   threads = 0;
+    TreeWriterOptions        writer_opts;
+    bool                     use_toy   = false;
+    bool                     use_gluex = false;
+};
+
+// One unit of conversion work: a whole .dat file, or one record of a capture.
+struct WorkItem {
+    const std::string*   dat_path = nullptr;
+    const CaptureReader* capture  = nullptr;
+    size_t               record   = 0;
+};
+
+struct ConvertStats {
+    std::atomic<uint64_t> inputs_done{0};
+    std::atomic<uint64_t> events{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+std::mutex print_mutex;
+
+// Fill every complete event in data into the writer; returns events written.
+size_t convertBuffer(RootTreeWriter& writer, const uint8_t* data, size_t size,
+                     const std::string& what) {
+    const size_t event_bytes = writer.numDoubles() * sizeof(double);
+    const size_t n_events    = size / event_bytes;
+    if (size % event_bytes != 0) {
+        std::lock_guard<std::mutex> lock(print_mutex);
+        std::cerr << "Warning: " << what << " holds " << size << " bytes, not a multiple of "
+                  << event_bytes << "; trailing " << (size % event_bytes) << " bytes ignored" << std::endl;
+    }
+
+    // Payloads are doubles written from std::vector<double>; both mmap and the
+    // capture layout keep them 8-byte aligned, but guard against foreign files.
+    std::vector<double> aligned;
+    const double* p = reinterpret_cast<const double*>(data);
+    if (reinterpret_cast<uintptr_t>(data) % alignof(double) != 0) {
+        aligned.resize(n_events * writer.numDoubles());
+        std::memcpy(aligned.data(), data, aligned.size() * sizeof(double));
+        p = aligned.data();
+    }
+
+    for (size_t i = 0; i < n_events; ++i)
+        writer.fillFromBuffer(p + i * writer.numDoubles());
+    return n_events;
+}
+
+// Worker: writes one output shard, pulling inputs from the shared queue.
+bool convertShard(const ConvertArgs& args, const std::vector<WorkItem>& work,
+                  std::atomic<size_t>& next, size_t shard, ConvertStats& stats) {
+    std::unique_ptr<RootTreeWriter> writer;
+    if (args.use_toy)
+        writer = std::make_unique<ToyTreeWriter>(args.writer_opts);
+    else
+        writer = std::make_unique<GluexTreeWriter>(args.writer_opts);
+
+    std::string out = formatFilename(args.output_pattern, shard);
+    if (!writer->open(out, args.tree_name))
+        return false;
+
+    for (size_t i = next.fetch_add(1); i < work.size(); i = next.fetch_add(1)) {
+        const WorkItem& item = work[i];
+        if (item.dat_path) {
+            MappedFile in;
+            if (!in.open(*item.dat_path)) {
+                stats.errors++;
+                continue;
+            }
+            stats.events += convertBuffer(*writer, in.data(), in.size(), *item.dat_path);
+            stats.bytes  += in.size();
+        } else {
+            CaptureRecord rec = item.capture->record(item.record);
+            stats.events += convertBuffer(*writer, rec.data, rec.size,
+                                          "capture event " + std::to_string(rec.event_num));
+            stats.bytes  += rec.size;
+        }
+        stats.inputs_done++;
+    }
+
+    Long64_t entries = writer->entries();
+    bool ok = writer->close();
+    {
+        std::lock_guard<std::mutex> lock(print_mutex);
+        std::cout << "[Shard " << shard << "] " << entries << " events -> " << out << std::endl;
+    }
+    return ok;
+}
+
+ConvertArgs parseArgs(int argc, char* argv[]) {
+    ConvertArgs args;
+
+    po::options_description desc("E2SAR Converter - Turn received .dat events back into ROOT trees");
+    desc.add_options()
+        ("help,h", "Show this help message")
+        ("toy", po::bool_switch(&args.use_toy)->default_value(false),
+         "Input holds Dalitz toy-MC events; write dalitz_root_tree schema")
+        ("gluex", po::bool_switch(&args.use_gluex)->default_value(false),
+         "Input holds GlueX kinematic-fit events; write myTree schema")
+        ("files", po::value<std::vector<std::string>>(&args.dat_files),
+         "Received .dat files to convert")
+        ("capture", po::value<std::vector<std::string>>(&args.capture_files),
+         "Capture file(s) recorded with e2sar-root --capture to convert (repeatable)")
+        ("output-pattern,o", po::value<std::string>(&args.output_pattern)->default_value("converted_{:03d}.root"),
+         "Output file pattern, formatted with the shard number (default: converted_{:03d}.root)")
+        ("tree,t", po::value<std::string>(&args.tree_name),
+         "Output tree name (default: dalitz_root_tree or myTree)")
+        ("threads,j", po::value<size_t>(&args.threads)->default_value(0),
+         "Worker threads, one output shard each (default: hardware concurrency)")
+        ("compression", po::value<int>(&args.writer_opts.compression)->default_value(101),
+         "ROOT compression setting, algorithm*100+level (default: 101)")
+        ("basket-size", po::value<int>(&args.writer_opts.basket_size)->default_value(32000),
+         "Branch basket size in bytes (default: 32000)")
+        ("auto-flush", po::value<Long64_t>(&args.writer_opts.auto_flush)->default_value(-30000000),
+         "Cluster size: >0 entries, <0 bytes (default: -30000000)");
+
+    po::positional_options_description pos;
+    pos.add("files", -1);
+
+    po::variables_map vm;
+
+    try {
+        po::store(po::command_line_parser(argc, argv)
+                  .options(desc)
+                  .positional(pos)
+                  .run(), vm);
+
+        if (vm.count("help")) {
+            std::cout << "Usage:\n"
+                      << "  " << argv[0] << " --toy|--gluex [OPTIONS] <event1.dat> ...\n"
+                      << "  " << argv[0] << " --toy|--gluex [OPTIONS] --capture <run.e2cap>\n\n"
+                      << desc << "\n"
+                      << "Examples:\n"
+                      << "  " << argv[0] << " --toy -j 8 -o toy_{:02d}.root event_*.dat\n"
+                      << "  " << argv[0] << " --gluex --compression 404 --capture run.e2cap\n";
+            std::exit(0);
+        }
+
+        po::notify(vm);
+
+        if (!args.use_toy && !args.use_gluex)
+            throw std::runtime_error("One of --toy or --gluex must be specified");
+        if (args.use_toy && args.use_gluex)
+            throw std::runtime_error("--toy and --gluex are mutually exclusive");
+        if (args.dat_files.empty() && args.capture_files.empty())
+            throw std::runtime_error("No input .dat or capture files given");
+        if (args.writer_opts.basket_size <= 0)
+            throw std::runtime_error("--basket-size must be greater than 0");
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << desc << std::endl;
+        throw;
+    }
+
+    if (args.tree_name.empty())
+        args.tree_name = args.use_toy ? ToyTreeWriter::DEFAULT_TREE : GluexTreeWriter::DEFAULT_TREE;
+    if (args.threads == 0)
+        args.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    return args;
+}
+
+int main(int argc, char* argv[]) {
+    ROOT::EnableThreadSafety();
+
+    try {
+        auto args = parseArgs(argc, argv);
+
+        std::vector<std::unique_ptr<CaptureReader>> captures;
+        std::vector<WorkItem> work;
+        work.reserve(args.dat_files.size());
+        for (const auto& f : args.dat_files)
+            work.push_back({&f, nullptr, 0});
+        for (const auto& f : args.capture_files) {
+            captures.push_back(std::make_unique<CaptureReader>());
+            if (!captures.back()->open(f))
+                return 1;
+            for (size_t r = 0; r < captures.back()->size(); ++r)
+                work.push_back({nullptr, captures.back().get(), r});
+        }
+
+        size_t shards = std::min(args.threads, work.size());
+        std::cout << "Converting " << work.size() << " event buffer(s) into "
+                  << shards << " shard(s) of tree '" << args.tree_name << "'" << std::endl;
+
+        ConvertStats stats;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> failed{0};
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> workers;
+        for (size_t s = 0; s < shards; ++s) {
+            workers.emplace_back([&, s]() {
+                if (!convertShard(args, work, next, s, stats))
+                    failed++;
+            });
+        }
+        for (auto& t : workers)
+            t.join();
+
+        double secs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count() / 1e6;
+
+        std::cout << "\n========== Conversion Complete ==========" << std::endl;
+        std::cout << "Inputs converted: " << stats.inputs_done << " / " << work.size() << std::endl;
+        std::cout << "Physics events: "   << stats.events << std::endl;
+        std::cout << "Input data: "       << (stats.bytes / (1024.0 * 1024.0)) << " MB" << std::endl;
+        std::cout << "Duration: "         << secs << " s" << std::endl;
+        if (secs > 0)
+            std::cout << "Average rate: " << (stats.bytes * 8.0 / 1e6) / secs << " Mbps" << std::endl;
+        if (stats.errors > 0)
+            std::cerr << "Read errors: " << stats.errors << std::endl;
+
+        return (failed == 0 && stats.errors == 0) ? 0 : 1;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
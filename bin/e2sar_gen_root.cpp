@@ -0,0 +1,212 @@
+#include "event_generator.hpp"
+#include "event_io.hpp"
+#include "tree_writer.hpp"
+#include <TROOT.h>
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <filesystem>
+
+namespace po = boost::program_options;
+
+struct GenArgs {
+    std::string       output_pattern;
+    std::string       tree_name;
+    uint64_t          events_per_file = 100000;
+    size_t            num_files = 1;
+    size_t            threads   = 0;
+    uint64_t          seed      = 1;
+    GeneratorOptions  gen_opts;
+    TreeWriterOptions writer_opts;
+    bool              use_toy   = false;
+    bool              use_gluex = false;
+};
+
+struct GenStats {
+    std::atomic<uint64_t> events{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+std::mutex print_mutex;
+
+// Write output file `index`. Its events depend only on the seed and the
+// index, never on which thread writes it or in what order.
+bool generateFile(const GenArgs& args, size_t index, GenStats& stats) {
+    std::unique_ptr<RootTreeWriter> writer;
+    if (args.use_toy)
+        writer = std::make_unique<ToyTreeWriter>(args.writer_opts);
+    else
+        writer = std::make_unique<GluexTreeWriter>(args.writer_opts);
+
+    std::string out = formatFilename(args.output_pattern, index);
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(out).parent_path();
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, ec);
+    if (!writer->open(out, args.tree_name))
+        return false;
+
+    PiPiGGGenerator gen(streamSeed(args.seed, index), args.gen_opts);
+    if (args.use_toy) {
+        auto& toy = static_cast<ToyTreeWriter&>(*writer);
+        for (uint64_t i = 0; i < args.events_per_file; ++i)
+            toy.fill(gen.nextDalitz());
+    } else {
+        auto& gluex = static_cast<GluexTreeWriter&>(*writer);
+        for (uint64_t i = 0; i < args.events_per_file; ++i)
+            gluex.fill(gen.next());
+    }
+
+    Long64_t entries = writer->entries();
+    bool ok = writer->close();
+
+    uint64_t size = std::filesystem::file_size(out, ec);
+    if (ec) size = 0;
+    stats.events += entries;
+    stats.bytes  += size;
+    {
+        std::lock_guard<std::mutex> lock(print_mutex);
+        std::cout << "[File " << index << "] " << entries << " events -> " << out
+                  << " (" << (size / (1024.0 * 1024.0)) << " MB)" << std::endl;
+    }
+    return ok;
+}
+
+GenArgs parseArgs(int argc, char* argv[]) {
+    GenArgs args;
+
+    po::options_description desc("E2SAR Generator - Write synthetic pi+ pi- gamma gamma ROOT files");
+    desc.add_options()
+        ("help,h", "Show this help message")
+        ("toy", po::bool_switch(&args.use_toy)->default_value(false),
+         "Write the Dalitz toy-MC schema (dalitz_root_tree), eta signal only")
+        ("gluex", po::bool_switch(&args.use_gluex)->default_value(false),
+         "Write the GlueX kinematic-fit schema (myTree), signal plus background")
+        ("events,n", po::value<uint64_t>(&args.events_per_file)->default_value(100000),
+         "Events per file (default: 100000)")
+        ("files,f", po::value<size_t>(&args.num_files)->default_value(1),
+         "Number of files to write (default: 1)")
+        ("output-pattern,o", po::value<std::string>(&args.output_pattern),
+         "Output file pattern, formatted with the file number "
+         "(default: dalitz_root_file_{:d}.root or pipigg_tree_{:d}.root)")
+        ("tree,t", po::value<std::string>(&args.tree_name),
+         "Output tree name (default: dalitz_root_tree or myTree)")
+        ("threads,j", po::value<size_t>(&args.threads)->default_value(0),
+         "Worker threads, one file at a time each (default: hardware concurrency)")
+        ("seed", po::value<uint64_t>(&args.seed)->default_value(1),
+         "Random seed; the same seed gives the same events (default: 1)")
+        ("beam-energy", po::value<double>(&args.gen_opts.beam_energy)->default_value(8.5),
+         "Coherent-peak photon energy in GeV (default: 8.5)")
+        ("t-slope", po::value<double>(&args.gen_opts.t_slope)->default_value(4.0),
+         "Slope of dsigma/dt in GeV^-2 (default: 4.0)")
+        ("background", po::value<double>(&args.gen_opts.background_fraction)->default_value(0.1),
+         "Fraction of non-eta background events, --gluex only (default: 0.1)")
+        ("resolution", po::value<double>(&args.gen_opts.resolution)->default_value(1.0),
+         "Detector smearing scale, 0 for generator truth (default: 1.0)")
+        ("compression", po::value<int>(&args.writer_opts.compression)->default_value(101),
+         "ROOT compression setting, algorithm*100+level (default: 101)")
+        ("basket-size", po::value<int>(&args.writer_opts.basket_size)->default_value(32000),
+         "Branch basket size in bytes (default: 32000)")
+        ("auto-flush", po::value<Long64_t>(&args.writer_opts.auto_flush)->default_value(-30000000),
+         "Cluster size: >0 entries, <0 bytes (default: -30000000)");
+
+    po::variables_map vm;
+
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+
+        if (vm.count("help")) {
+            std::cout << "Usage: " << argv[0] << " --toy|--gluex [OPTIONS]\n\n"
+                      << desc << "\n"
+                      << "Examples:\n"
+                      << "  " << argv[0] << " --toy -n 1000000 -o dalitz_toy_data_0/dalitz_root_file_{:d}.root\n"
+                      << "  " << argv[0] << " --gluex -f 16 -j 8 --compression 404 --auto-flush 10000\n";
+            std::exit(0);
+        }
+
+        po::notify(vm);
+
+        if (!args.use_toy && !args.use_gluex)
+            throw std::runtime_error("One of --toy or --gluex must be specified");
+        if (args.use_toy && args.use_gluex)
+            throw std::runtime_error("--toy and --gluex are mutually exclusive");
+        if (args.num_files == 0)
+            throw std::runtime_error("--files must be greater than 0");
+        if (args.writer_opts.basket_size <= 0)
+            throw std::runtime_error("--basket-size must be greater than 0");
+        if (args.gen_opts.background_fraction < 0 || args.gen_opts.background_fraction > 1)
+            throw std::runtime_error("--background must be between 0 and 1");
+        if (args.gen_opts.resolution < 0)
+            throw std::runtime_error("--resolution must not be negative");
+        if (args.gen_opts.beam_energy <= 1.0)
+            throw std::runtime_error("--beam-energy must be above 1 GeV");
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << desc << std::endl;
+        throw;
+    }
+
+    if (args.output_pattern.empty())
+        args.output_pattern = args.use_toy ? "dalitz_root_file_{:d}.root" : "pipigg_tree_{:d}.root";
+    if (args.num_files > 1 && formatFilename(args.output_pattern, 0) == formatFilename(args.output_pattern, 1))
+        throw std::runtime_error("--output-pattern needs a {:d} placeholder to write more than one file");
+    if (args.tree_name.empty())
+        args.tree_name = args.use_toy ? ToyTreeWriter::DEFAULT_TREE : GluexTreeWriter::DEFAULT_TREE;
+    if (args.threads == 0)
+        args.threads = std::max(1u, std::thread::hardware_concurrency());
+    args.threads = std::min(args.threads, args.num_files);
+
+    return args;
+}
+
+int main(int argc, char* argv[]) {
+    ROOT::EnableThreadSafety();
+
+    try {
+        auto args = parseArgs(argc, argv);
+
+        std::cout << "Generating " << args.num_files << " file(s) of " << args.events_per_file
+                  << " events in tree '" << args.tree_name << "' with seed " << args.seed
+                  << " on " << args.threads << " thread(s)" << std::endl;
+
+        GenStats stats;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> failed{0};
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < args.threads; ++t) {
+            workers.emplace_back([&]() {
+                for (size_t i = next.fetch_add(1); i < args.num_files; i = next.fetch_add(1))
+                    if (!generateFile(args, i, stats))
+                        failed++;
+            });
+        }
+        for (auto& t : workers)
+            t.join();
+
+        double secs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count() / 1e6;
+
+        std::cout << "\n========== Generation Complete ==========" << std::endl;
+        std::cout << "Files written: " << (args.num_files - failed) << " / " << args.num_files << std::endl;
+        std::cout << "Physics events: " << stats.events << std::endl;
+        std::cout << "Output data: "    << (stats.bytes / (1024.0 * 1024.0)) << " MB" << std::endl;
+        std::cout << "Duration: "       << secs << " s" << std::endl;
+        if (secs > 0)
+            std::cout << "Average rate: " << stats.events / secs << " events/s" << std::endl;
+
+        return failed == 0 ? 0 : 1;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,165 @@
+#include "lb_emulator.hpp"
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace po = boost::program_options;
+
+struct LBEmuArgs {
+    LBEmulatorConfig config;
+    std::string      impair;
+    int              stats_interval_ms = 1000;
+    double           duration_s = 0;
+};
+
+// eventfd written by the signal handler (async-signal-safe)
+int stop_fd = -1;
+
+void signalHandler(int) {
+    uint64_t one = 1;
+    ssize_t rc = write(stop_fd, &one, sizeof(one));
+    (void)rc;
+}
+
+LBEmuArgs parseArgs(int argc, char* argv[]) {
+    LBEmuArgs args;
+    std::vector<std::string> workers;
+
+    po::options_description desc("E2SAR LB Emulator - Local load-balancer data plane for multi-receiver tests");
+    desc.add_options()
+        ("help,h", "Show this help message")
+        ("listen-ip", po::value<std::string>(&args.config.listen_ip)->default_value("127.0.0.1"),
+         "Address the senders' URI data= points at (default: 127.0.0.1)")
+        ("listen-port", po::value<uint16_t>(&args.config.listen_port)->default_value(19522),
+         "UDP port the senders' URI data= points at (default: 19522)")
+        ("worker,w", po::value<std::vector<std::string>>(&workers),
+         "Receiver as host:port[,ports=N][,weight=W]; repeat for each receiver")
+        ("threads,j", po::value<size_t>(&args.config.threads)->default_value(1),
+         "Forwarding threads sharing the listen port (default: 1)")
+        ("slots", po::value<size_t>(&args.config.calendar_slots)->default_value(LBCalendar::DEFAULT_SLOTS),
+         "Calendar slots shared out among the workers by weight (default: 512)")
+        ("strip-lb-header", po::bool_switch(&args.config.strip_lb_header)->default_value(false),
+         "Remove the LB header as the real LB does (receivers must not expect it; "
+         "e2sar-root without --withcp does)")
+        ("socket-buffer-mb", po::value<int>(&args.config.socket_buffer_mb)->default_value(32),
+         "Requested SO_RCVBUF / SO_SNDBUF in MB, capped by net.core.*mem_max (default: 32)")
+        ("impair", po::value<std::string>(&args.impair),
+         "Impair forwarded frames: loss=P,burst=P:LEN,dup=P,reorder=P,reorder-delay=T,"
+         "delay=T,jitter=T,seed=N (T in us/ms/s, default ms)")
+        ("stats-interval-ms", po::value<int>(&args.stats_interval_ms)->default_value(1000),
+         "Print per-worker counts this often; 0 = only at exit (default: 1000)")
+        ("duration", po::value<double>(&args.duration_s)->default_value(0),
+         "Stop after this many seconds; 0 = until Ctrl+C (default: 0)");
+
+    po::variables_map vm;
+
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+
+        if (vm.count("help")) {
+            std::cout << "Usage: " << argv[0] << " --worker HOST:PORT [--worker ...] [OPTIONS]\n\n"
+                      << desc << "\n"
+                      << "Senders use a URI whose data= is the listen address, e.g.\n"
+                      << "  ejfat://token@127.0.0.1:18347/lb/1?sync=127.0.0.1:19010&data=127.0.0.1:19522\n"
+                      << "and each receiver listens on its worker port with the same URI.\n\n"
+                      << "Examples:\n"
+                      << "  Two receivers:        " << argv[0] << " -w 127.0.0.1:19600 -w 127.0.0.1:19610\n"
+                      << "  4 ports, 2:1 weights: " << argv[0] << " -w 127.0.0.1:19600,ports=4,weight=2"
+                      << " -w 127.0.0.1:19610,ports=4\n"
+                      << "  Lossy WAN proxy:      " << argv[0] << " -w 127.0.0.1:19600"
+                      << " --impair loss=0.0001,burst=0.00001:50,reorder=0.01,delay=20ms,jitter=2ms\n";
+            std::exit(0);
+        }
+
+        po::notify(vm);
+
+        if (workers.empty())
+            throw std::runtime_error("at least one --worker is required");
+        for (const auto& spec : workers) {
+            LBWorker worker;
+            if (!parseLBWorker(spec, worker))
+                throw std::runtime_error("invalid --worker");
+            args.config.workers.push_back(worker);
+        }
+        if (args.config.threads == 0)
+            throw std::runtime_error("--threads must be greater than 0");
+        if (args.config.calendar_slots < args.config.workers.size())
+            throw std::runtime_error("--slots must be at least the number of workers");
+        if (!args.impair.empty() && !parseImpairment(args.impair, args.config.impairment))
+            throw std::runtime_error("invalid --impair");
+        if (args.stats_interval_ms < 0)
+            throw std::runtime_error("--stats-interval-ms must not be negative");
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << desc << std::endl;
+        throw;
+    }
+
+    return args;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        auto args = parseArgs(argc, argv);
+
+        stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stop_fd < 0) {
+            std::cerr << "Error: eventfd: " << strerror(errno) << std::endl;
+            return 1;
+        }
+        signal(SIGINT, signalHandler);
+        signal(SIGTERM, signalHandler);
+
+        LBEmulator emulator(args.config);
+        if (!emulator.start())
+            return 1;
+
+        std::cout << "LB emulator listening on " << args.config.listen_ip << ":"
+                  << args.config.listen_port << ", " << args.config.workers.size() << " worker(s), "
+                  << args.config.threads << " thread(s)"
+                  << (args.config.strip_lb_header ? ", stripping LB headers" : "")
+                  << (args.config.impairment.active() ? ", impairment " + args.config.impairment.describe() : "")
+                  << std::endl;
+
+        auto start    = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(args.duration_s));
+        while (true) {
+            int wait_ms = args.stats_interval_ms > 0 ? args.stats_interval_ms : 1000;
+            if (args.duration_s > 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()).count();
+                if (left <= 0) break;
+                wait_ms = static_cast<int>(std::min<long long>(wait_ms, left));
+            }
+            struct pollfd pfd{stop_fd, POLLIN, 0};
+            if (poll(&pfd, 1, wait_ms) > 0) {
+                std::cout << "\nStopping..." << std::endl;
+                break;
+            }
+            if (args.stats_interval_ms > 0)
+                emulator.printSummary(std::cout);
+        }
+
+        emulator.stop();
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+
+        std::cout << "\n=== Final ===" << std::endl;
+        emulator.printSummary(std::cout);
+        return emulator.counters().send_errors.load() == 0 ? 0 : 1;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,167 @@
+#include "mock_cp.hpp"
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace po = boost::program_options;
+
+struct MockCPArgs {
+    MockCPConfig config;
+    std::string  impair;
+    int          stats_interval_ms = 5000;
+    double       duration_s = 0;
+};
+
+// eventfd written by the signal handler (async-signal-safe)
+int stop_fd = -1;
+
+void signalHandler(int) {
+    uint64_t one = 1;
+    ssize_t rc = write(stop_fd, &one, sizeof(one));
+    (void)rc;
+}
+
+MockCPArgs parseArgs(int argc, char* argv[]) {
+    MockCPArgs args;
+    LBEmulatorConfig& data = args.config.data_plane;
+
+    po::options_description desc("E2SAR Mock CP - Local load-balancer control plane for --withcp tests");
+    desc.add_options()
+        ("help,h", "Show this help message")
+        ("cp-ip", po::value<std::string>(&args.config.cp_ip)->default_value("127.0.0.1"),
+         "gRPC listen address (default: 127.0.0.1)")
+        ("cp-port", po::value<uint16_t>(&args.config.cp_port)->default_value(18347),
+         "gRPC listen port (default: 18347)")
+        ("data-ip", po::value<std::string>(&data.listen_ip)->default_value("127.0.0.1"),
+         "Data plane and sync address (default: 127.0.0.1)")
+        ("data-port", po::value<uint16_t>(&data.listen_port)->default_value(19522),
+         "Data plane UDP port (default: 19522)")
+        ("sync-port", po::value<uint16_t>(&args.config.sync_port)->default_value(19010),
+         "UDP port for Segmenter sync packets (default: 19010)")
+        ("lb-id", po::value<std::string>(&args.config.lb_id)->default_value("1"),
+         "Load balancer id in the URI (default: 1)")
+        ("token", po::value<std::string>(&args.config.token),
+         "Token callers must present; default: accept any")
+        ("epoch-ms", po::value<int>(&args.config.epoch_ms)->default_value(1000),
+         "Rebuild the calendar from state reports this often (default: 1000)")
+        ("state-timeout-ms", po::value<int>(&args.config.state_timeout_ms)->default_value(2000),
+         "Drop workers silent this long from the calendar (default: 2000)")
+        ("state-log", po::value<std::string>(&args.config.state_log),
+         "Write every worker state report to this CSV file")
+        ("threads,j", po::value<size_t>(&data.threads)->default_value(1),
+         "Data plane forwarding threads (default: 1)")
+        ("slots", po::value<size_t>(&data.calendar_slots)->default_value(LBCalendar::DEFAULT_SLOTS),
+         "Calendar slots shared out among the workers (default: 512)")
+        ("socket-buffer-mb", po::value<int>(&data.socket_buffer_mb)->default_value(32),
+         "Requested SO_RCVBUF / SO_SNDBUF in MB, capped by net.core.*mem_max (default: 32)")
+        ("impair", po::value<std::string>(&args.impair),
+         "Impair forwarded frames: loss=P,burst=P:LEN,dup=P,reorder=P,reorder-delay=T,"
+         "delay=T,jitter=T,seed=N (T in us/ms/s, default ms)")
+        ("stats-interval-ms", po::value<int>(&args.stats_interval_ms)->default_value(5000),
+         "Print workers and counts this often; 0 = only at exit (default: 5000)")
+        ("duration", po::value<double>(&args.duration_s)->default_value(0),
+         "Stop after this many seconds; 0 = until Ctrl+C (default: 0)");
+
+    po::variables_map vm;
+
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+
+        if (vm.count("help")) {
+            std::cout << "Usage: " << argv[0] << " [OPTIONS]\n\n"
+                      << desc << "\n"
+                      << "Prints the URI to give senders and receivers, which then run with --withcp.\n"
+                      << "Receivers join the calendar at the first epoch after they report ready;\n"
+                      << "their slots follow the control signal in their state reports.\n\n"
+                      << "Example:\n"
+                      << "  " << argv[0] << " --state-log state.csv &\n"
+                      << "  e2sar-root -r -u 'ejfat://mock@127.0.0.1:18347/lb/1?sync=127.0.0.1:19010"
+                      << "&data=127.0.0.1:19522' --withcp --recv-ip 127.0.0.1 --recv-port 19600\n"
+                      << "  e2sar-root -s -u '<same URI>' --withcp --toy -t dalitz_root_tree file.root\n";
+            std::exit(0);
+        }
+
+        po::notify(vm);
+
+        if (data.threads == 0)
+            throw std::runtime_error("--threads must be greater than 0");
+        if (args.config.epoch_ms <= 0 || args.config.state_timeout_ms <= 0)
+            throw std::runtime_error("--epoch-ms and --state-timeout-ms must be greater than 0");
+        if (!args.impair.empty() && !parseImpairment(args.impair, data.impairment))
+            throw std::runtime_error("invalid --impair");
+        if (args.stats_interval_ms < 0)
+            throw std::runtime_error("--stats-interval-ms must not be negative");
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << desc << std::endl;
+        throw;
+    }
+
+    return args;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        auto args = parseArgs(argc, argv);
+
+        stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stop_fd < 0) {
+            std::cerr << "Error: eventfd: " << strerror(errno) << std::endl;
+            return 1;
+        }
+        signal(SIGINT, signalHandler);
+        signal(SIGTERM, signalHandler);
+
+        MockControlPlane cp(args.config);
+        if (!cp.start())
+            return 1;
+
+        const LBEmulatorConfig& data = args.config.data_plane;
+        std::cout << "Mock CP on " << args.config.cp_ip << ":" << args.config.cp_port << ", data plane "
+                  << data.listen_ip << ":" << data.listen_port << ", " << data.threads << " thread(s), epoch "
+                  << args.config.epoch_ms << " ms"
+                  << (data.impairment.active() ? ", impairment " + data.impairment.describe() : "") << "\n"
+                  << "URI: " << cp.uri() << std::endl;
+
+        auto start    = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(args.duration_s));
+        while (true) {
+            int wait_ms = args.stats_interval_ms > 0 ? args.stats_interval_ms : 1000;
+            if (args.duration_s > 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()).count();
+                if (left <= 0) break;
+                wait_ms = static_cast<int>(std::min<long long>(wait_ms, left));
+            }
+            struct pollfd pfd{stop_fd, POLLIN, 0};
+            if (poll(&pfd, 1, wait_ms) > 0) {
+                std::cout << "\nStopping..." << std::endl;
+                break;
+            }
+            if (args.stats_interval_ms > 0)
+                cp.printSummary(std::cout);
+        }
+
+        cp.stop();
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+
+        std::cout << "\n=== Final ===" << std::endl;
+        cp.printSummary(std::cout);
+        return cp.dataPlane().counters().send_errors.load() == 0 ? 0 : 1;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -1,4 +1,13 @@
 #include "file_processor.hpp"
+#include "event_capture.hpp"
+#include "event_io.hpp"
+#include "event_receiver.hpp"
+#include "cpu_affinity.hpp"
+#include "send_stats.hpp"
+#include "control_socket.hpp"
+#include "trace.hpp"
+#include "async_log.hpp"
+#include "alloc_stats.hpp"
 #include <TFile.h>
 #include <TTree.h>
 #include <TROOT.h>
@@ -10,100 +19,25 @@
 #include <cstdlib>
 #include <chrono>
 #include <thread>
-#include <sys/mman.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-#include <unistd.h>
 #include <sstream>
-#include <iomanip>
 #include <atomic>
 #include <signal.h>
+#include <unistd.h>
 #include <future>
 
 namespace po = boost::program_options;
 
-// Global flag for signal handling
-std::atomic<bool> keep_receiving{true};
+// Stop signal for the receive loop, set while receiving
+StopSignal* receive_stop = nullptr;
 
-// Signal handler for Ctrl+C
+// Signal handler for Ctrl+C (async-signal-safe: write() and an eventfd only)
 void signalHandler(int signal) {
-    if (signal == SIGINT) {
-        std::cout << "\nReceived interrupt signal, stopping..." << std::endl;
-        keep_receiving = false;
-    }
-}
-
-// Format filename using pattern and event number
-// Supports patterns like "event_{:08d}.dat" or "data_{:06d}.bin"
-std::string formatFilename(const std::string& pattern, uint64_t event_num) {
-    std::ostringstream oss;
-    size_t pos = 0;
-
-    while (pos < pattern.size()) {
-        size_t start = pattern.find("{:", pos);
-        if (start == std::string::npos) {
-            oss << pattern.substr(pos);
-            break;
-        }
-
-        oss << pattern.substr(pos, start - pos);
-
-        size_t end = pattern.find("}", start);
-        if (end == std::string::npos) {
-            oss << pattern.substr(start);
-            break;
-        }
-
-        std::string format_spec = pattern.substr(start + 2, end - start - 3);
-
-        int width = 0;
-        char fill_char = '0';
-        if (format_spec.size() >= 2) {
-            if (format_spec[0] == '0') {
-                fill_char = '0';
-                width = std::stoi(format_spec.substr(0, format_spec.size() - 1));
-            } else {
-                width = std::stoi(format_spec.substr(0, format_spec.size() - 1));
-            }
-        }
-
-        oss << std::setfill(fill_char) << std::setw(width) << event_num;
-        pos = end + 1;
-    }
-
-    return oss.str();
-}
-
-// Write data to memory-mapped file
-bool writeMemoryMappedFile(const std::string& filename, const uint8_t* data, size_t size) {
-    int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
-    if (fd < 0) {
-        std::cerr << "Error creating file " << filename << ": " << strerror(errno) << std::endl;
-        return false;
-    }
-
-    if (ftruncate(fd, size) < 0) {
-        std::cerr << "Error resizing file " << filename << ": " << strerror(errno) << std::endl;
-        close(fd);
-        return false;
-    }
-
-    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-    if (mapped == MAP_FAILED) {
-        std::cerr << "Error memory-mapping file " << filename << ": " << strerror(errno) << std::endl;
-        close(fd);
-        return false;
+    if (signal == SIGINT && receive_stop) {
+        const char msg[] = "\nReceived interrupt signal, stopping...\n";
+        ssize_t rc = write(STDOUT_FILENO, msg, sizeof(msg) - 1);
+        (void)rc;
+        receive_stop->trigger();
     }
-
-    memcpy(mapped, data, size);
-
-    if (msync(mapped, size, MS_SYNC) < 0) {
-        std::cerr << "Warning: msync failed for " << filename << ": " << strerror(errno) << std::endl;
-    }
-
-    munmap(mapped, size);
-    close(fd);
-    return true;
 }
 
 // Initialize and start E2SAR Segmenter
@@ -167,6 +101,7 @@ std::unique_ptr<e2sar::Reassembler> initializeReassembler(
     const std::string& recv_ip,
     uint16_t recv_port,
     size_t num_threads,
+    const std::vector<int>& recv_cores,
     int event_timeout_ms,
     bool withCP,
     bool validateCert) {
@@ -197,8 +132,10 @@ std::unique_ptr<e2sar::Reassembler> initializeReassembler(
     rflags.eventTimeout_ms = event_timeout_ms;
     rflags.validateCert = validateCert;
 
-    auto reassembler = std::make_unique<e2sar::Reassembler>(
-        uri, ip, recv_port, num_threads, rflags);
+    // With a core list E2SAR starts one receive thread pinned to each core
+    auto reassembler = recv_cores.empty()
+        ? std::make_unique<e2sar::Reassembler>(uri, ip, recv_port, num_threads, rflags)
+        : std::make_unique<e2sar::Reassembler>(uri, ip, recv_port, recv_cores, rflags);
 
     std::cout << "Using IP address: " << reassembler->get_dataIP() << std::endl;
     std::cout << "Receiving on ports: " << reassembler->get_recvPorts().first
@@ -221,129 +158,18 @@ std::unique_ptr<e2sar::Reassembler> initializeReassembler(
 
     std::cout << "Reassembler started successfully" << std::endl;
     std::cout << "  Event timeout: " << event_timeout_ms << " ms" << std::endl;
-    std::cout << "  Receive threads: " << num_threads << std::endl;
+    if (recv_cores.empty())
+        std::cout << "  Receive threads: " << num_threads << std::endl;
+    else
+        std::cout << "  Receive threads: " << recv_cores.size()
+                  << " (cores " << formatCpuList(recv_cores) << ")" << std::endl;
 
     return reassembler;
 }
 
-// Statistics for receiving events
-struct ReceiveStats {
-    std::atomic<uint64_t> events_received{0};
-    std::atomic<uint64_t> events_written{0};
-    std::atomic<uint64_t> write_errors{0};
-    std::atomic<uint64_t> total_bytes{0};
-    std::atomic<uint64_t> data_id_mismatches{0};
-
-    void printProgress() const {
-        std::cout << "  Events received: " << events_received
-                  << " | Written: " << events_written
-                  << " | Errors: " << write_errors
-                  << " | DataID mismatches: " << data_id_mismatches
-                  << " | Total MB: " << (total_bytes / (1024.0 * 1024.0))
-                  << std::endl;
-    }
-};
-
-// Receive events and write to memory-mapped files
-bool receiveEvents(e2sar::Reassembler& reassembler, const std::string& output_pattern,
-                   uint16_t expected_data_id) {
-    std::cout << "\nStarting event reception..." << std::endl;
-    std::cout << "Output pattern: " << output_pattern << std::endl;
-    std::cout << "Press Ctrl+C to stop\n" << std::endl;
-
-    ReceiveStats stats;
-    uint8_t* event_buffer = nullptr;
-    size_t event_size;
-    e2sar::EventNum_t event_num;
-    uint16_t data_id;
-
-    auto start_time   = std::chrono::steady_clock::now();
-    auto last_progress = start_time;
-
-    while (keep_receiving) {
-        auto result = reassembler.recvEvent(&event_buffer, &event_size,
-                                            &event_num, &data_id, 1000);
-
-        auto now = std::chrono::steady_clock::now();
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - last_progress).count() >= 5) {
-            stats.printProgress();
-            last_progress = now;
-        }
-
-        if (result.has_error()) continue;
-        if (result.value() == -1) continue;
-
-        if (data_id != expected_data_id) {
-            stats.data_id_mismatches++;
-            std::lock_guard<std::mutex> lock(cout_mutex);
-            std::cerr << "Warning: received data_id=" << data_id
-                      << " expected=" << expected_data_id
-                      << " event_num=" << event_num << std::endl;
-            delete[] event_buffer;
-            event_buffer = nullptr;
-            continue;
-        }
-
-        stats.events_received++;
-        stats.total_bytes += event_size;
-
-        std::string filename = formatFilename(output_pattern, event_num);
-
-        if (writeMemoryMappedFile(filename, event_buffer, event_size)) {
-            stats.events_written++;
-        } else {
-            stats.write_errors++;
-            std::cerr << "Failed to write event " << event_num << std::endl;
-        }
-
-        delete[] event_buffer;
-        event_buffer = nullptr;
-    }
-
-    auto end_time = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-
-    std::cout << "\n========== Reception Complete ==========" << std::endl;
-    std::cout << "EJFAT Events received: "       << stats.events_received    << std::endl;
-    std::cout << "EJFAT Events written: "        << stats.events_written     << std::endl;
-    std::cout << "Write errors: "          << stats.write_errors       << std::endl;
-    std::cout << "DataID mismatches: "     << stats.data_id_mismatches << std::endl;
-    std::cout << "Total data: "            << (stats.total_bytes / (1024.0 * 1024.0)) << " MB" << std::endl;
-    std::cout << "Duration: "        << duration.count() << " ms" << std::endl;
-
-    if (stats.events_received > 0) {
-        double mbps = (stats.total_bytes * 8.0 / 1000000.0) / (duration.count() / 1000.0);
-        std::cout << "Average rate: " << mbps << " Mbps" << std::endl;
-    }
-
-    auto reas_stats = reassembler.getStats();
-    std::cout << "\nReassembler Statistics:" << std::endl;
-    std::cout << "  Total packets: "    << reas_stats.totalPackets    << std::endl;
-    std::cout << "  Total bytes: "      << reas_stats.totalBytes      << std::endl;
-    std::cout << "  Event success: "    << reas_stats.eventSuccess    << std::endl;
-    std::cout << "  Reassembly loss: "  << reas_stats.reassemblyLoss  << std::endl;
-    std::cout << "  Enqueue loss: "     << reas_stats.enqueueLoss     << std::endl;
-    std::cout << "  Data errors: "      << reas_stats.dataErrCnt      << std::endl;
-    std::cout << "  gRPC errors: "      << reas_stats.grpcErrCnt      << std::endl;
-
-    std::vector<boost::tuple<e2sar::EventNum_t, u_int16_t, size_t>> lostEvents;
-    while (true) {
-        auto res = reassembler.get_LostEvent();
-        if (res.has_error()) break;
-        lostEvents.push_back(res.value());
-    }
-
-    std::cout << "\tEvents lost so far (<Evt ID:Data ID/num frags rcvd>): ";
-    for (auto evt : lostEvents) {
-        std::cout << "<" << evt.get<0>() << ":" << evt.get<1>() << "/" << evt.get<2>() << "> ";
-    }
-    std::cout << std::endl;
-
-    return stats.write_errors == 0 && stats.data_id_mismatches == 0;
-}
-
 CommandLineArgs parseArgs(int argc, char* argv[]) {
     CommandLineArgs args;
+    std::string recv_cores, dequeue_cores, suggest_iface;
 
     po::options_description desc("ROOT File Reader - Extract named trees from ROOT files and send/receive via E2SAR");
     desc.add_options()
@@ -370,10 +196,51 @@ CommandLineArgs parseArgs(int argc, char* argv[]) {
          "Starting UDP port for receiver (default: 19522)")
         ("recv-threads", po::value<size_t>(&args.recv_threads)->default_value(1),
          "Number of receiver threads (default: 1)")
+        ("dequeue-threads", po::value<size_t>(&args.dequeue_threads)->default_value(1),
+         "Threads dequeuing and writing reassembled events (default: 1)")
+        ("stats-csv", po::value<std::string>(&args.stats_csv),
+         "Receiver: write a CSV time series of receive and reassembler counters with rates")
+        ("stats-json", po::value<std::string>(&args.stats_json),
+         "Write periodic and final JSON Lines statistics records (sender and receiver)")
+        ("metrics-addr", po::value<std::string>(&args.metrics_addr),
+         "Serve Prometheus metrics at http://<host:port>/metrics (e.g. 127.0.0.1:9100)")
+        ("control-socket", po::value<std::string>(&args.control_socket),
+         "Unix socket for live stats and settings (stats, set rate|prescale|verbosity; try 'help')")
+        ("trace", po::value<std::string>(&args.trace_file),
+         "Record per-thread spans (file open, cluster read, batch build, enqueue wait, write) as a Chrome trace")
+        ("trace-buffer", po::value<size_t>(&args.trace_buffer)->default_value(trace::DEFAULT_EVENTS_PER_THREAD),
+         "Spans kept per thread for --trace, 40 bytes each; older ones are overwritten (default: 16384)")
+        ("perf-counters", po::bool_switch(&args.perf_counters)->default_value(false),
+         "Count cycles, instructions, LLC/dTLB/branch misses per pipeline stage (perf_event_open)")
+        ("perf-sample", po::value<size_t>(&args.perf_sample)->default_value(64),
+         "Count the read and convert stages of every Nth entry (sender) and the dequeue and "
+         "write stages of every Nth event (receiver) (default: 64)")
+        ("alloc-stats", po::bool_switch(&args.alloc_stats)->default_value(false),
+         "Account batch / event buffer allocations, peak outstanding memory and RSS")
+        ("log-rate", po::value<double>()->default_value(100),
+         "Progress messages per second allowed from each thread; 0 = unlimited (default: 100)")
+        ("verbosity", po::value<int>()->default_value(1),
+         "0 = errors and summary only, 1 = periodic progress, 2 = per-batch progress (default: 1)")
+        ("stats-interval-ms", po::value<int>(&args.stats_interval_ms)->default_value(1000),
+         "Sampling interval for --stats-csv / --stats-json in milliseconds (default: 1000)")
+        ("recv-cores", po::value<std::string>(&recv_cores),
+         "Pin reassembler receive threads to these CPUs, one thread each (e.g. 2-5; overrides --recv-threads)")
+        ("dequeue-cores", po::value<std::string>(&dequeue_cores),
+         "Pin dequeue/writer threads to these CPUs, round-robin (e.g. 6,7; sets --dequeue-threads if not given)")
+        ("numa-node", po::value<int>(&args.numa_node)->default_value(-1),
+         "Prefer allocating receive buffers on this NUMA node (default: -1, no preference)")
+        ("suggest-placement", po::value<std::string>(&suggest_iface),
+         "Print NUMA/IRQ-aware --numa-node, --recv-cores, --dequeue-cores for a NIC and exit")
         ("output-pattern,o", po::value<std::string>(&args.output_pattern)->default_value("event_{:08d}.dat"),
          "Output file naming pattern for received events (default: event_{:08d}.dat)")
         ("event-timeout", po::value<int>(&args.event_timeout_ms)->default_value(500),
          "Event reassembly timeout in milliseconds (default: 500)")
+        ("capture", po::value<std::string>(&args.capture_file),
+         "Record received events with timestamps into one capture file instead of per-event files")
+        ("replay", po::value<std::string>(&args.replay_file),
+         "Replay a capture file through the sender instead of reading ROOT files")
+        ("replay-speedup", po::value<double>(&args.replay_speedup)->default_value(1.0),
+         "Divide recorded inter-event gaps by this factor (default: 1.0, 0 sends unpaced)")
         ("files", po::value<std::vector<std::string>>(&args.file_paths),
          "ROOT files to process (required for sender mode)")
         ("toy", po::bool_switch(&args.use_toy)->default_value(false),
@@ -409,16 +276,37 @@ CommandLineArgs parseArgs(int argc, char* argv[]) {
                       << "  Send (toy):        " << argv[0] << " --toy  -t dalitz_root_tree --send -u ejfat://... --bufsize-mb 5 file.root\n"
                       << "  Send (gluex):      " << argv[0] << " --gluex -t myTree          --send -u ejfat://... --bufsize-mb 5 file.root\n"
                       << "  Send (jumbo):      " << argv[0] << " --toy  -t dalitz_root_tree --send -u ejfat://... --mtu 9000 file.root\n"
-                      << "  Receive:           " << argv[0] << " --recv -u ejfat://... --recv-ip 127.0.0.1 -o output_{:06d}.dat\n";
+                      << "  Receive:           " << argv[0] << " --recv -u ejfat://... --recv-ip 127.0.0.1 -o output_{:06d}.dat\n"
+                      << "  Capture:           " << argv[0] << " --recv -u ejfat://... --recv-ip 127.0.0.1 --capture run.e2cap\n"
+                      << "  Replay (2x):       " << argv[0] << " --send -u ejfat://... --replay run.e2cap --replay-speedup 2\n";
             std::exit(0);
         }
 
         po::notify(vm);
 
+        if (!suggest_iface.empty()) {
+            NicPlacement placement;
+            if (!inspectNic(suggest_iface, placement))
+                std::exit(1);
+            printPlacementSuggestion(placement, args.recv_threads, args.dequeue_threads);
+            std::exit(0);
+        }
+
+        args.recv_cores    = parseCpuList(recv_cores);
+        args.dequeue_cores = parseCpuList(dequeue_cores);
+        if (!args.dequeue_cores.empty() && vm["dequeue-threads"].defaulted())
+            args.dequeue_threads = args.dequeue_cores.size();
+
         if (args.send_data && args.recv_data)
             throw std::runtime_error("Cannot use --send and --recv simultaneously");
 
-        if (!args.recv_data) {
+        if (!args.replay_file.empty() && !args.send_data)
+            throw std::runtime_error("--replay requires --send");
+
+        if (!args.capture_file.empty() && !args.recv_data)
+            throw std::runtime_error("--capture requires --recv");
+
+        if (!args.recv_data && args.replay_file.empty()) {
             if (!args.use_toy && !args.use_gluex)
                 throw std::runtime_error("One of --toy or --gluex must be specified");
             if (args.use_toy && args.use_gluex)
@@ -428,9 +316,9 @@ CommandLineArgs parseArgs(int argc, char* argv[]) {
         if (args.send_data) {
             if (args.ejfat_uri.empty())
                 throw std::runtime_error("--uri is required when --send is enabled");
-            if (args.tree_name.empty())
+            if (args.replay_file.empty() && args.tree_name.empty())
                 throw std::runtime_error("--tree is required when --send is enabled");
-            if (args.file_paths.empty())
+            if (args.replay_file.empty() && args.file_paths.empty())
                 throw std::runtime_error("ROOT file(s) required when --send is enabled");
             if (args.bufsize_mb == 0)
                 throw std::runtime_error("--bufsize-mb must be greater than 0");
@@ -445,8 +333,19 @@ CommandLineArgs parseArgs(int argc, char* argv[]) {
                 throw std::runtime_error("--recv-ip is required when --recv is enabled");
             if (args.event_timeout_ms <= 0)
                 throw std::runtime_error("--event-timeout must be greater than 0");
+            if (args.dequeue_threads == 0)
+                throw std::runtime_error("--dequeue-threads must be greater than 0");
+            if (!validFilenamePattern(args.output_pattern))
+                throw std::runtime_error("--output-pattern placeholders must look like {:d} or {:08d}");
         }
 
+        if (args.stats_interval_ms <= 0)
+            throw std::runtime_error("--stats-interval-ms must be greater than 0");
+        if (args.trace_buffer == 0)
+            throw std::runtime_error("--trace-buffer must be greater than 0");
+        if (args.perf_sample == 0)
+            throw std::runtime_error("--perf-sample must be greater than 0");
+
         if (!args.send_data && !args.recv_data) {
             if (args.tree_name.empty())
                 throw std::runtime_error("--tree is required for read-only mode");
@@ -462,24 +361,83 @@ CommandLineArgs parseArgs(int argc, char* argv[]) {
         throw;
     }
 
+    int level = vm["verbosity"].as<int>();
+    if (level < 0 || level > 2) {
+        std::cerr << "Error: --verbosity must be 0, 1 or 2" << std::endl;
+        throw std::runtime_error("invalid --verbosity");
+    }
+    verbosity = level;
+
+    double log_rate = vm["log-rate"].as<double>();
+    if (log_rate < 0) {
+        std::cerr << "Error: --log-rate must not be negative" << std::endl;
+        throw std::runtime_error("invalid --log-rate");
+    }
+    logSetRateLimit(log_rate);
+
     args.withCP   = vm["withcp"].as<bool>();
     args.validate = !vm["novalidate"].as<bool>();
 
     return args;
 }
 
+// Dump the --trace timeline once all recording threads have stopped.
+bool writeTrace(const CommandLineArgs& args) {
+    return args.trace_file.empty() || trace::write(args.trace_file);
+}
+
+// Give the segmenter's send threads time to drain, then print its final
+// counters. False if any send failed.
+bool drainAndReport(e2sar::Segmenter& segmenter) {
+    std::cout << "\nWaiting for send queues to drain..." << std::endl;
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    auto send_stats = segmenter.getSendStats();
+
+    std::cout << "\n========== E2SAR Final Statistics ==========" << std::endl;
+    std::cout << "Total network frames sent: " << send_stats.msgCnt << std::endl;
+    std::cout << "Send errors: "               << send_stats.errCnt << std::endl;
+
+    if (send_stats.errCnt > 0)
+        std::cerr << "WARNING: Errors occurred during sending" << std::endl;
+    return send_stats.errCnt == 0;
+}
+
 int main(int argc, char* argv[]) {
     ROOT::EnableThreadSafety();
 
     try {
         auto args = parseArgs(argc, argv);
 
+        alloc_accounting = args.alloc_stats;
+
+        if (!args.trace_file.empty()) {
+            trace::enable(args.trace_buffer);
+            trace::nameThread("main");
+        }
+
+        // Declared before the server so its commands never outlive it
+        SendControl   send_control;
+        ControlServer control;
+        if (!args.control_socket.empty()) {
+            addVerbosityCommands(control);
+            if (!control.start(args.control_socket))
+                return 1;
+            std::cout << "Control socket: " << args.control_socket << std::endl;
+        }
+
         if (args.recv_data) {
+            StopSignal stop;
+            receive_stop = &stop;
             signal(SIGINT, signalHandler);
 
+            // Before any reassembler thread or buffer exists, so all inherit it
+            if (args.numa_node >= 0 && preferNumaNode(args.numa_node))
+                std::cout << "Preferring memory on NUMA node " << args.numa_node << std::endl;
+
             auto reassembler = initializeReassembler(
                 args.ejfat_uri, args.recv_ip, args.recv_port,
-                args.recv_threads, args.event_timeout_ms,
+                args.recv_threads, args.recv_cores, args.event_timeout_ms,
                 args.withCP, args.validate);
 
             if (!reassembler) {
@@ -487,7 +445,24 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
 
-            bool success = receiveEvents(*reassembler, args.output_pattern, args.data_id);
+            CaptureWriter capture;
+            if (!args.capture_file.empty()) {
+                if (!capture.open(args.capture_file))
+                    return 1;
+                std::cout << "Capturing events to " << args.capture_file << std::endl;
+            }
+
+            bool success = receiveEvents(*reassembler, args,
+                                         args.capture_file.empty() ? nullptr : &capture, stop,
+                                         args.control_socket.empty() ? nullptr : &control);
+            signal(SIGINT, SIG_DFL);
+            receive_stop = nullptr;
+
+            if (!args.capture_file.empty()) {
+                success = capture.close() && success;
+                std::cout << "Capture closed: " << capture.recordCount() << " events in "
+                          << args.capture_file << std::endl;
+            }
 
             std::cout << "\nDeregistering worker..." << std::endl;
             auto deregres = reassembler->deregisterWorker();
@@ -499,6 +474,7 @@ int main(int argc, char* argv[]) {
             std::cout << "Stopping reassembler..." << std::endl;
             reassembler->stopThreads();
 
+            success = writeTrace(args) && success;
             return success ? 0 : 1;
         }
 
@@ -509,8 +485,12 @@ int main(int argc, char* argv[]) {
         std::unique_ptr<e2sar::Segmenter> segmenter;
 
         if (args.send_data) {
-            std::cout << "Initializing shared E2SAR Segmenter for "
-                      << args.file_paths.size() << " file(s)..." << std::endl;
+            if (args.replay_file.empty())
+                std::cout << "Initializing shared E2SAR Segmenter for "
+                          << args.file_paths.size() << " file(s)..." << std::endl;
+            else
+                std::cout << "Initializing E2SAR Segmenter for replay of "
+                          << args.replay_file << "..." << std::endl;
 
             segmenter = initializeSegmenter(args.ejfat_uri, args.data_id,
                                             args.event_src_id, args.mtu,
@@ -525,8 +505,44 @@ int main(int argc, char* argv[]) {
                       << segmenter->getMaxPldLen() << " bytes" << std::endl;
         }
 
+        if (!args.replay_file.empty()) {
+            bool ok = replayCapture(args.replay_file, args.replay_speedup, *segmenter);
+            ok = drainAndReport(*segmenter) && ok;
+            ok = writeTrace(args) && ok;
+            return ok ? 0 : 1;
+        }
+
         global_buffer_id = 0;
 
+        // One counter block per file thread, sampled by the JSON reporter
+        std::unique_ptr<SendCounters[]> counters(new SendCounters[args.file_paths.size()]);
+        SendStatsReporter reporter(args.file_paths, counters.get(), segmenter.get());
+        if (!args.stats_json.empty()) {
+            if (!reporter.start(args.stats_json, args.stats_interval_ms))
+                return 1;
+            std::cout << "Writing JSON statistics every " << args.stats_interval_ms
+                      << " ms into " << args.stats_json << std::endl;
+        }
+        MetricsServer metrics;
+        if (!args.metrics_addr.empty()) {
+            if (!metrics.start(args.metrics_addr, [&reporter](PromText& out) { reporter.writeMetrics(out); }))
+                return 1;
+            std::cout << "Serving Prometheus metrics on http://" << args.metrics_addr << "/metrics" << std::endl;
+        }
+
+        if (!args.control_socket.empty())
+            addSendControlCommands(control, send_control);
+        ScopedCommand stats_command(args.control_socket.empty() ? nullptr : &control,
+                                    "stats", "stats", [&reporter](const ControlServer::Args&) {
+            JsonWriter json;
+            reporter.buildRecord(json, false);
+            return json.str();
+        });
+
+        // Per-entry stage timing only when something reports it live
+        const bool entry_timing = !args.stats_json.empty() || !args.metrics_addr.empty() ||
+                                  !args.control_socket.empty();
+
         std::cout << "\nSpawning " << args.file_paths.size()
                   << " thread(s) for file processing..." << std::endl;
 
@@ -535,12 +551,16 @@ int main(int argc, char* argv[]) {
             std::cout << "  Thread " << i << ": " << args.file_paths[i] << std::endl;
 
             futures.push_back(std::async(std::launch::async,
-                [&args, seg = segmenter.get(), file_path = args.file_paths[i], i]() -> bool {
+                [&args, &send_control, seg = segmenter.get(), file_path = args.file_paths[i], i,
+                 slot = &counters[i], entry_timing]() -> bool {
                     std::unique_ptr<RootFileProcessor> proc;
                     if (args.use_toy)
                         proc = std::make_unique<ToyFileProcessor>(args, seg, i);
                     else
                         proc = std::make_unique<GluexFileProcessor>(args, seg, i);
+                    proc->setCounters(slot);
+                    proc->setControl(&send_control);
+                    proc->setEntryTiming(entry_timing);
                     return proc->process(file_path, args.tree_name);
                 }));
         }
@@ -552,24 +572,27 @@ int main(int argc, char* argv[]) {
                 success_count++;
             } else {
                 failure_count++;
+                logFlush();   // its error message first
                 std::cerr << "Thread " << i << " failed" << std::endl;
             }
         }
+        // Let the file threads' last messages out before the summary
+        logFlush();
 
         if (segmenter) {
-            std::cout << "\nWaiting for send queues to drain..." << std::endl;
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-
-            auto send_stats = segmenter->getSendStats();
+            drainAndReport(*segmenter);
+            std::cout << "Total buffers submitted: " << global_buffer_id.load() << std::endl;
 
-            std::cout << "\n========== E2SAR Final Statistics ==========" << std::endl;
-            std::cout << "Total network frames sent: " << send_stats.msgCnt << std::endl;
-            std::cout << "Send errors: "               << send_stats.errCnt << std::endl;
-            std::cout << "Total buffers submitted: "   << global_buffer_id.load() << std::endl;
-
-            if (send_stats.errCnt > 0)
-                std::cerr << "WARNING: Errors occurred during sending" << std::endl;
+            reporter.printLatency(std::cout);
         }
+        if (args.perf_counters)
+            reporter.printPerfCounters(std::cout);
+        if (args.alloc_stats)
+            reporter.printMemory(std::cout);
+
+        // After the drain, so the final record carries the settled segmenter counters
+        reporter.finish();
+        bool trace_ok = writeTrace(args);
 
         std::cout << "\nProcessing complete: "
                   << success_count << " file(s) processed successfully";
@@ -577,7 +600,7 @@ int main(int argc, char* argv[]) {
             std::cout << ", " << failure_count << " file(s) failed";
         std::cout << std::endl;
 
-        return failure_count > 0 ? 1 : 0;
+        return failure_count > 0 || !trace_ok ? 1 : 0;
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,245 @@
+#include "file_processor.hpp"
+#include "event_capture.hpp"
+#include "event_io.hpp"
+#include "dalitz_analysis.hpp"
+#include "async_log.hpp"
+#include <TROOT.h>
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+
+namespace po = boost::program_options;
+
+struct ValidateArgs {
+    std::vector<std::string> source_files;
+    std::vector<std::string> dat_files;
+    std::vector<std::string> capture_files;
+    std::string              received_dir;
+    std::string              tree_name;
+    size_t                   threads = 0;
+    size_t                   max_bins_reported = 10;
+    bool                     use_toy   = false;
+    bool                     use_gluex = false;
+};
+
+// One unit of work: a source ROOT file, a received .dat file, or one record
+// of a capture file.
+struct WorkItem {
+    const std::string*   source   = nullptr;
+    const std::string*   dat_path = nullptr;
+    const CaptureReader* capture  = nullptr;
+    size_t               record   = 0;
+};
+
+// Per-worker results, merged once all workers finish.
+struct WorkerResult {
+    DalitzHistograms source;
+    DalitzHistograms received;
+    uint64_t         source_doubles   = 0;
+    uint64_t         received_doubles = 0;
+    uint64_t         received_bytes   = 0;
+    uint64_t         errors           = 0;
+};
+
+void validateWorker(const ValidateArgs& args, const std::vector<WorkItem>& work,
+                    std::atomic<size_t>& next, WorkerResult& result) {
+    const bool gluex = args.use_gluex;
+
+    // Source files go through the sender's own ROOT → wire conversion
+    CommandLineArgs proc_args;
+    proc_args.use_toy    = args.use_toy;
+    proc_args.use_gluex  = args.use_gluex;
+    proc_args.tree_name  = args.tree_name;
+    proc_args.send_data  = false;
+    proc_args.bufsize_mb = 10;
+
+    for (size_t i = next.fetch_add(1); i < work.size(); i = next.fetch_add(1)) {
+        const WorkItem& item = work[i];
+        if (item.source) {
+            std::unique_ptr<RootFileProcessor> proc;
+            if (args.use_toy)
+                proc = std::make_unique<ToyFileProcessor>(proc_args, nullptr, i);
+            else
+                proc = std::make_unique<GluexFileProcessor>(proc_args, nullptr, i);
+            proc->setBatchSink([&](const std::vector<double>& batch) {
+                result.source.fillBuffer(batch.data(), batch.size(), gluex);
+                result.source_doubles += batch.size();
+            });
+            if (!proc->process(*item.source, args.tree_name))
+                result.errors++;
+        } else if (item.dat_path) {
+            MappedFile in;
+            if (!in.open(*item.dat_path)) {
+                result.errors++;
+                continue;
+            }
+            size_t n = in.size() / sizeof(double);
+            result.received.fillBuffer(reinterpret_cast<const double*>(in.data()), n, gluex);
+            result.received_doubles += n;
+            result.received_bytes   += in.size();
+        } else {
+            CaptureRecord rec = item.capture->record(item.record);
+            size_t n = rec.size / sizeof(double);
+            result.received.fillBuffer(reinterpret_cast<const double*>(rec.data), n, gluex);
+            result.received_doubles += n;
+            result.received_bytes   += rec.size;
+        }
+    }
+}
+
+ValidateArgs parseArgs(int argc, char* argv[]) {
+    ValidateArgs args;
+
+    po::options_description desc("E2SAR Validator - Compare physics histograms of sent ROOT data and received events");
+    desc.add_options()
+        ("help,h", "Show this help message")
+        ("toy", po::bool_switch(&args.use_toy)->default_value(false),
+         "Dalitz toy-MC schema (dalitz_root_tree)")
+        ("gluex", po::bool_switch(&args.use_gluex)->default_value(false),
+         "GlueX kinematic-fit schema (myTree)")
+        ("source,S", po::value<std::vector<std::string>>(&args.source_files),
+         "Source ROOT file, once per time it was sent (repeatable)")
+        ("tree,t", po::value<std::string>(&args.tree_name),
+         "Source tree name (default: dalitz_root_tree or myTree)")
+        ("files", po::value<std::vector<std::string>>(&args.dat_files),
+         "Received .dat files")
+        ("received-dir,d", po::value<std::string>(&args.received_dir),
+         "Directory of received .dat files (avoids shell argument limits)")
+        ("capture", po::value<std::vector<std::string>>(&args.capture_files),
+         "Capture file(s) recorded with e2sar-root --capture (repeatable)")
+        ("threads,j", po::value<size_t>(&args.threads)->default_value(0),
+         "Worker threads (default: hardware concurrency)")
+        ("max-bins", po::value<size_t>(&args.max_bins_reported)->default_value(10),
+         "Mismatching bins to print per histogram (default: 10)");
+
+    po::positional_options_description pos;
+    pos.add("files", -1);
+
+    po::variables_map vm;
+
+    try {
+        po::store(po::command_line_parser(argc, argv)
+                  .options(desc)
+                  .positional(pos)
+                  .run(), vm);
+
+        if (vm.count("help")) {
+            std::cout << "Usage:\n"
+                      << "  " << argv[0] << " --toy|--gluex -S <sent.root> [-S ...] [OPTIONS] <event1.dat> ...\n\n"
+                      << desc << "\n"
+                      << "Examples:\n"
+                      << "  " << argv[0] << " --toy -S data.root -S data.root -d recv_out/\n"
+                      << "  " << argv[0] << " --gluex -S gluex.root --capture run.e2cap\n";
+            std::exit(0);
+        }
+
+        po::notify(vm);
+
+        if (!args.use_toy && !args.use_gluex)
+            throw std::runtime_error("One of --toy or --gluex must be specified");
+        if (args.use_toy && args.use_gluex)
+            throw std::runtime_error("--toy and --gluex are mutually exclusive");
+        if (args.source_files.empty())
+            throw std::runtime_error("At least one --source ROOT file is required");
+        if (args.dat_files.empty() && args.capture_files.empty() && args.received_dir.empty())
+            throw std::runtime_error("No received .dat files, --received-dir or --capture given");
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << desc << std::endl;
+        throw;
+    }
+
+    if (args.tree_name.empty())
+        args.tree_name = args.use_toy ? "dalitz_root_tree" : "myTree";
+    if (args.threads == 0)
+        args.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (!args.received_dir.empty()) {
+        for (const auto& entry : std::filesystem::directory_iterator(args.received_dir))
+            if (entry.is_regular_file() && entry.path().extension() == ".dat")
+                args.dat_files.push_back(entry.path().string());
+    }
+
+    return args;
+}
+
+int main(int argc, char* argv[]) {
+    ROOT::EnableThreadSafety();
+
+    try {
+        auto args = parseArgs(argc, argv);
+
+        std::vector<std::unique_ptr<CaptureReader>> captures;
+        std::vector<WorkItem> work;
+        // Sources first: they are the slowest items, so start them early
+        for (const auto& f : args.source_files)
+            work.push_back({&f, nullptr, nullptr, 0});
+        for (const auto& f : args.dat_files)
+            work.push_back({nullptr, &f, nullptr, 0});
+        for (const auto& f : args.capture_files) {
+            captures.push_back(std::make_unique<CaptureReader>());
+            if (!captures.back()->open(f))
+                return 1;
+            for (size_t r = 0; r < captures.back()->size(); ++r)
+                work.push_back({nullptr, nullptr, captures.back().get(), r});
+        }
+
+        size_t n_workers = std::min(args.threads, work.size());
+        std::cout << "Validating " << args.source_files.size() << " source file(s) against "
+                  << (work.size() - args.source_files.size()) << " received event buffer(s) with "
+                  << n_workers << " thread(s)" << std::endl;
+
+        std::vector<WorkerResult> results(n_workers);
+        std::atomic<size_t> next{0};
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < n_workers; ++w)
+            workers.emplace_back(validateWorker, std::cref(args), std::cref(work),
+                                 std::ref(next), std::ref(results[w]));
+        for (auto& t : workers)
+            t.join();
+        logFlush();
+
+        WorkerResult total;
+        for (const auto& r : results) {
+            total.source.add(r.source);
+            total.received.add(r.received);
+            total.source_doubles   += r.source_doubles;
+            total.received_doubles += r.received_doubles;
+            total.received_bytes   += r.received_bytes;
+            total.errors           += r.errors;
+        }
+
+        double secs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count() / 1e6;
+        const size_t per_event = args.use_gluex ? GluexEventData::NUM_DOUBLES
+                                                : DalitzEventData::NUM_DOUBLES;
+
+        std::cout << "\n========== Round-Trip Validation ==========" << std::endl;
+        std::cout << "Source events: "   << total.source_doubles / per_event   << std::endl;
+        std::cout << "Received events: " << total.received_doubles / per_event << std::endl;
+        std::cout << "Received data: "   << (total.received_bytes / (1024.0 * 1024.0)) << " MB" << std::endl;
+        std::cout << "Duration: "        << secs << " s" << std::endl;
+        std::cout << std::endl;
+
+        size_t differing = compareHistograms(total.source, total.received, std::cout,
+                                             args.max_bins_reported);
+        if (total.errors > 0)
+            std::cerr << "Input errors: " << total.errors << std::endl;
+
+        std::cout << "\n" << (differing == 0 ? "ALL HISTOGRAMS IDENTICAL" : "DIFFERENCES FOUND") << std::endl;
+        return (differing == 0 && total.errors == 0) ? 0 : 1;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "stats_json.hpp"
+#include "metrics.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Optional (--alloc-stats) accounting of the large hot-loop buffers: how
+// many were allocated, how many bytes, and how much was outstanding at
+// once. Updates are relaxed atomics and skipped entirely while disabled.
+extern std::atomic<bool> alloc_accounting;
+
+class AllocCounter {
+public:
+    void allocated(uint64_t bytes) noexcept {
+        if (!alloc_accounting.load(std::memory_order_relaxed)) return;
+        allocs_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        raiseTo(peak_count_, live_count_.fetch_add(1, std::memory_order_relaxed) + 1);
+        raiseTo(peak_bytes_, live_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    }
+    void freed(uint64_t bytes) noexcept {
+        if (!alloc_accounting.load(std::memory_order_relaxed)) return;
+        frees_.fetch_add(1, std::memory_order_relaxed);
+        live_count_.fetch_sub(1, std::memory_order_relaxed);
+        live_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    uint64_t allocations() const { return allocs_.load(std::memory_order_relaxed); }
+    uint64_t frees()       const { return frees_.load(std::memory_order_relaxed); }
+    uint64_t totalBytes()  const { return bytes_.load(std::memory_order_relaxed); }
+    uint64_t liveCount()   const { return live_count_.load(std::memory_order_relaxed); }
+    uint64_t liveBytes()   const { return live_bytes_.load(std::memory_order_relaxed); }
+    uint64_t peakCount()   const { return peak_count_.load(std::memory_order_relaxed); }
+    uint64_t peakBytes()   const { return peak_bytes_.load(std::memory_order_relaxed); }
+
+    // Start a new high-water mark from what is outstanding now.
+    void resetPeak() noexcept {
+        peak_count_.store(live_count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        peak_bytes_.store(live_bytes_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    // "181 allocated (1.8 GB), peak 120.0 MB in 12 outstanding, 0 B live"
+    std::string summary() const;
+    // Object key: {allocations, frees, bytes, live, live_bytes, peak, peak_bytes}
+    void addTo(JsonWriter& json, const char* key) const;
+    // <prefix>_allocations_total, _bytes_total, _live_bytes, _peak_bytes
+    void addTo(PromText& out, const std::string& prefix, const char* what) const;
+
+private:
+    static void raiseTo(std::atomic<uint64_t>& peak, uint64_t value) noexcept {
+        uint64_t p = peak.load(std::memory_order_relaxed);
+        while (value > p && !peak.compare_exchange_weak(p, value, std::memory_order_relaxed)) {}
+    }
+
+    std::atomic<uint64_t> allocs_{0};
+    std::atomic<uint64_t> frees_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> live_count_{0};
+    std::atomic<uint64_t> live_bytes_{0};
+    std::atomic<uint64_t> peak_count_{0};
+    std::atomic<uint64_t> peak_bytes_{0};
+};
+
+// Sender batches, by reserved capacity, from allocation until freeBuffer or
+// the read-only path deletes them.
+extern AllocCounter batch_memory;
+// Receiver event buffers from recvEvent() handing them over until delete[].
+extern AllocCounter event_memory;
+
+// Resident set size of this process now and at its peak (0 if unknown).
+uint64_t currentRssBytes();
+uint64_t peakRssBytes();
+// Restart the peak from the current RSS (/proc/self/clear_refs); false if
+// the kernel does not allow it, leaving peakRssBytes() at the process peak.
+bool resetPeakRss();
+
+// Human-readable size with a binary unit, e.g. "512 B", "120.0 MB".
+std::string formatBytes(uint64_t bytes);
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Asynchronous logger for the data-path threads. Each thread queues
+// messages into its own single-producer ring and a background flusher
+// writes them out (errors and warnings to stderr, the rest to stdout) in
+// timestamp order. Logging never takes a lock or waits for I/O: when a
+// ring is full the message is dropped and counted. Info and debug messages
+// are also rate limited per thread; errors and warnings never are.
+
+enum class LogLevel : uint8_t {
+    Error,
+    Warning,
+    Info,    // shown at verbosity >= 1
+    Debug    // shown at verbosity >= 2
+};
+
+// False when the current verbosity hides level; check it before building an
+// expensive message.
+bool logEnabled(LogLevel level);
+
+// Queue text (without a trailing newline) from the calling thread.
+void logMessage(LogLevel level, std::string text);
+
+inline void logError(std::string text)   { logMessage(LogLevel::Error,   std::move(text)); }
+inline void logWarning(std::string text) { logMessage(LogLevel::Warning, std::move(text)); }
+inline void logInfo(std::string text)    { logMessage(LogLevel::Info,    std::move(text)); }
+inline void logDebug(std::string text)   { logMessage(LogLevel::Debug,   std::move(text)); }
+
+// Write out everything queued so far before returning, e.g. before a
+// summary printed directly to std::cout.
+void logFlush();
+
+// Info/debug messages per second allowed from each thread (burst of twice
+// that); 0 disables the limit. Default 100.
+void logSetRateLimit(double per_second);
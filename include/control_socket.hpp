@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Application-level send pacing shared by all file threads, adjustable while
+// running. The Segmenter's own rate is fixed when it is constructed, so
+// this paces batch submission on top of it: lowering the rate here takes
+// effect at once, while raising it beyond --rate has no effect.
+class SendPacer {
+public:
+    // Highest rate setRate() accepts (10 Tbps)
+    static constexpr double MAX_GBPS = 10000;
+
+    // gbps <= 0 disables pacing; above MAX_GBPS it is capped. Callers
+    // already waiting wake up and re-reserve at the new rate.
+    void   setRate(double gbps);
+    double rate() const;
+
+    // Block until bytes may be submitted at the current rate. Each caller
+    // reserves the next slot with a CAS and waits for it; a rate change
+    // cuts the wait short so the slot is recomputed.
+    void acquire(size_t bytes);
+
+private:
+    std::atomic<uint64_t> bits_per_sec_{0};
+    std::atomic<int64_t>  next_ns_{0};       // steady_clock; next free slot
+    std::atomic<uint64_t> generation_{0};    // bumped by setRate()
+    std::mutex              wait_mutex_;
+    std::condition_variable rate_changed_;
+};
+
+// Sender settings the control socket can change mid-run.
+struct SendControl {
+    SendPacer             pacer;
+    std::atomic<uint32_t> prescale{1};       // stream every Nth tree entry
+};
+
+// Line-oriented control server on a Unix stream socket. Each request line is
+// "<command> [args...]"; each reply is one line starting with "OK" or
+// "ERR". A poll() thread serves any number of clients; handlers run on that
+// thread and must only touch atomics or their own state.
+class ControlServer {
+public:
+    using Args    = std::vector<std::string>;
+    // Returns the reply text after "OK "; throw std::runtime_error for ERR.
+    using Handler = std::function<std::string(const Args& args)>;
+
+    ControlServer() = default;
+    ~ControlServer() { stop(); }
+    ControlServer(const ControlServer&)            = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // command is one or two words, e.g. "stats" or "set rate". Commands may
+    // be added and removed while the server runs; "help" is built in.
+    void addCommand(const std::string& command, const std::string& usage, Handler handler);
+    void removeCommand(const std::string& command);
+
+    bool start(const std::string& path);
+    void stop();
+
+    // Dispatch one request line; used by the server thread.
+    std::string handle(const std::string& line);
+
+private:
+    struct Command {
+        std::string usage;
+        Handler     handler;
+    };
+
+    void run();
+
+    std::mutex                     commands_mutex_;
+    std::map<std::string, Command> commands_;
+    std::string                    path_;
+    int                            listen_fd_ = -1;
+    int                            stop_fd_   = -1;
+    std::thread                    thread_;
+};
+
+// Registers a command for the lifetime of a scope; for handlers that capture
+// locals. A null server makes it a no-op.
+class ScopedCommand {
+public:
+    ScopedCommand(ControlServer* server, const std::string& command,
+                  const std::string& usage, ControlServer::Handler handler)
+        : server_(server), command_(command) {
+        if (server_) server_->addCommand(command, usage, std::move(handler));
+    }
+    ~ScopedCommand() { if (server_) server_->removeCommand(command_); }
+    ScopedCommand(const ScopedCommand&)            = delete;
+    ScopedCommand& operator=(const ScopedCommand&) = delete;
+
+private:
+    ControlServer* server_;
+    std::string    command_;
+};
+
+// "set verbosity" / "get verbosity" for the process-wide verbosity level.
+void addVerbosityCommands(ControlServer& server);
+// "set rate", "set prescale" and "get settings" for a running sender.
+void addSendControlCommands(ControlServer& server, SendControl& control);
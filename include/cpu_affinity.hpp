@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Parse a Linux CPU list such as "0-3,8,10-11" (as in sysfs cpulist files).
+// Throws std::runtime_error on malformed input.
+std::vector<int> parseCpuList(const std::string& list);
+// Inverse of parseCpuList(): collapse sorted runs into ranges.
+std::string formatCpuList(std::vector<int> cpus);
+
+// Pin the calling thread to one CPU.
+bool pinCurrentThread(int cpu);
+// Prefer allocating memory on a NUMA node for the calling thread and every
+// thread it creates afterwards (set_mempolicy MPOL_PREFERRED). Call before
+// the reassembler/segmenter threads and buffers are created.
+bool preferNumaNode(int node);
+
+// Where a NIC lives and which CPUs service its interrupts.
+struct NicPlacement {
+    std::string      iface;
+    std::string      pci_addr;      // empty for virtual interfaces
+    int              numa_node = -1;
+    std::vector<int> local_cpus;    // CPUs on numa_node (all CPUs if unknown)
+    std::vector<int> irqs;          // IRQ numbers attributed to the NIC
+    std::vector<int> irq_cpus;      // CPUs that have serviced those IRQs
+};
+
+// Fill placement from /sys/class/net/<iface>/device/numa_node, the node's
+// cpulist and /proc/interrupts. Returns false if the interface is unknown.
+bool inspectNic(const std::string& iface, NicPlacement& placement);
+
+// Print the NIC's placement and suggested --numa-node / --recv-cores /
+// --dequeue-cores values: NUMA-local CPUs, avoiding those busy with NIC IRQs.
+void printPlacementSuggestion(const NicPlacement& placement,
+                              size_t recv_threads, size_t dequeue_threads);
@@ -0,0 +1,66 @@
+#pragma once
+#include "event_data.hpp"
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Fixed-binning 1D histogram with TH1-style under/overflow bins (0 and
+// nbins+1). Plain integer counts so per-thread copies merge exactly and two
+// fills of the same events compare bin-for-bin.
+class FixedHistogram {
+public:
+    FixedHistogram(std::string name, int nbins, double lo, double hi);
+
+    void fill(double x) {
+        int b;
+        if (!(x >= lo_))     b = 0;              // includes NaN
+        else if (x >= hi_)   b = nbins_ + 1;
+        else                 b = 1 + static_cast<int>(scale_ * (x - lo_));
+        ++counts_[b];
+    }
+    void add(const FixedHistogram& other);
+
+    const std::string& name() const { return name_; }
+    int      nbins()   const { return nbins_; }
+    uint64_t count(int bin) const { return counts_[bin]; }
+    uint64_t entries() const;
+
+private:
+    std::string           name_;
+    int                   nbins_;
+    double                lo_, hi_, scale_;
+    std::vector<uint64_t> counts_;
+};
+
+// The eta -> pi+ pi- pi0 Dalitz observables of tests/gluex_event_selection.C:
+// X, Y, imass and imassGG before and after event selection, same binning.
+// GlueX events use the kinematic-fit cuts; toy events, which carry no kfit
+// scalars, use the invariant masses and the kinematic check of
+// tests/read_dalitz_root.py.
+class DalitzHistograms {
+public:
+    DalitzHistograms();
+
+    void fill(const GluexEventData& event);
+    void fill(const DalitzEventData& event);
+    // Fill from serialized events of either schema.
+    void fillBuffer(const double* p, size_t num_doubles, bool gluex);
+    void add(const DalitzHistograms& other);
+
+    std::vector<const FixedHistogram*> all() const;
+
+private:
+    void fillObservables(const TLorentzVector& pip, const TLorentzVector& pim,
+                         const TLorentzVector& g1,  const TLorentzVector& g2,
+                         double imass, double imassGG, bool pass);
+
+    FixedHistogram X_pre_, Y_pre_, im_pre_, imgg_pre_;
+    FixedHistogram X_post_, Y_post_, im_post_, imgg_post_;
+};
+
+// Bin-by-bin counterpart of the tests/compare_histos.C overlay. Prints one
+// line per histogram and up to max_bins_reported mismatching bins each;
+// returns the number of histograms that differ.
+size_t compareHistograms(const DalitzHistograms& source, const DalitzHistograms& received,
+                         std::ostream& out, size_t max_bins_reported = 10);
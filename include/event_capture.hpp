@@ -0,0 +1,123 @@
+#pragma once
+#include <e2sar.hpp>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Event-level capture file: every reassembled event with its receive
+// timestamp, event number, data id and payload, followed by an index.
+// All integers are stored in host byte order.
+//
+// File layout:
+//   CaptureFileHeader
+//   { CaptureRecordHeader, payload[size] } × N
+//   uint64_t record_offset × N       (index, written on close)
+//   CaptureFileTrailer
+//
+// A capture that was never closed (receiver killed) has no index; the reader
+// then recovers the records with a sequential scan.
+
+constexpr char     CAPTURE_MAGIC[8]     = {'E', '2', 'S', 'A', 'R', 'C', 'A', 'P'};
+constexpr char     CAPTURE_IDX_MAGIC[8] = {'E', '2', 'S', 'A', 'R', 'I', 'D', 'X'};
+constexpr uint32_t CAPTURE_VERSION      = 1;
+
+struct CaptureFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t start_unix_ns;   // wall-clock time of the first record's time base
+};
+
+struct CaptureRecordHeader {
+    uint64_t recv_ns;         // receive time, ns since capture start (steady clock)
+    uint64_t event_num;
+    uint64_t size;            // payload bytes following this header
+    uint16_t data_id;
+    uint16_t reserved[3];
+};
+
+struct CaptureFileTrailer {
+    uint64_t index_offset;
+    uint64_t record_count;
+    char     magic[8];
+};
+
+static_assert(sizeof(CaptureFileHeader)   == 24, "capture header layout");
+static_assert(sizeof(CaptureRecordHeader) == 32, "capture record layout");
+static_assert(sizeof(CaptureFileTrailer)  == 24, "capture trailer layout");
+
+// Appends records to a capture file. append() is thread-safe.
+class CaptureWriter {
+public:
+    using clock = std::chrono::steady_clock;
+
+    CaptureWriter() = default;
+    ~CaptureWriter() { close(); }
+    CaptureWriter(const CaptureWriter&)            = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    bool open(const std::string& path);
+    // recv_time should be taken as soon as the event is dequeued.
+    bool append(clock::time_point recv_time, uint64_t event_num, uint16_t data_id,
+                const uint8_t* data, size_t size);
+    // Writes the index and trailer. Safe to call more than once.
+    bool close();
+
+    uint64_t recordCount() const;
+
+private:
+    mutable std::mutex    mtx_;
+    int                   fd_ = -1;
+    std::string           path_;
+    clock::time_point     start_;
+    uint64_t              offset_  = 0;
+    uint64_t              last_ns_ = 0;
+    std::vector<uint64_t> index_;
+};
+
+// One record of an open capture; data points into the mapped file.
+struct CaptureRecord {
+    uint64_t       recv_ns;
+    uint64_t       event_num;
+    uint16_t       data_id;
+    size_t         size;
+    const uint8_t* data;
+};
+
+// Memory-maps a capture file read-only and exposes its records by position.
+class CaptureReader {
+public:
+    CaptureReader() = default;
+    ~CaptureReader() { close(); }
+    CaptureReader(const CaptureReader&)            = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    size_t        size() const { return index_.size(); }
+    CaptureRecord record(size_t i) const;
+    // True when the index was recovered by scanning (capture not closed, or
+    // its index did not match the records).
+    bool          recovered() const { return recovered_; }
+    uint64_t      startUnixNs() const { return start_unix_ns_; }
+
+private:
+    // Trailer index, every entry checked to lie within the file; false if not.
+    bool loadIndex(const CaptureFileTrailer& trailer);
+    bool scanRecords();
+
+    const uint8_t*        base_ = nullptr;
+    size_t                len_  = 0;
+    uint64_t              start_unix_ns_ = 0;
+    bool                  recovered_ = false;
+    std::vector<uint64_t> index_;
+};
+
+// Send every record of a capture through the segmenter with its original
+// event number and data id, reproducing the recorded inter-event gaps divided
+// by speedup (speedup <= 0 sends as fast as the segmenter accepts).
+bool replayCapture(const std::string& path, double speedup, e2sar::Segmenter& segmenter);
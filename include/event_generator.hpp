@@ -0,0 +1,54 @@
+#pragma once
+#include "event_data.hpp"
+#include <cstdint>
+#include <random>
+
+// Kinematics of the synthetic γp → ηp, η → π+π−π0, π0 → γγ sample.
+struct GeneratorOptions {
+    // Coherent-peak photon energy and its spread in GeV (GlueX: ~8.5, 0.3)
+    double beam_energy = 8.5;
+    double beam_spread = 0.3;
+    // Slope b of dσ/dt ∝ exp(−b|t|) in GeV^-2
+    double t_slope = 4.0;
+    // Fraction of non-resonant π+π−γγ events mixed into the sample
+    double background_fraction = 0.1;
+    // Detector smearing scale: 1 = nominal GlueX resolutions, 0 = generator truth
+    double resolution = 1.0;
+};
+
+// Deterministic π+π−γγ event source. The η Dalitz distribution follows the
+// measured matrix element |A|² = 1 + aY + bY² + dX² + fY³, and each event is
+// smeared with tracking and calorimeter resolutions before imass_kfit,
+// imassGG_kfit and a fit probability are derived from it. All randomness
+// comes from the generator's own engine, so a given seed always produces
+// the same events regardless of threads or ROOT's global state.
+class PiPiGGGenerator {
+public:
+    explicit PiPiGGGenerator(uint64_t seed, const GeneratorOptions& opts = {});
+
+    GluexEventData next();
+    DalitzEventData nextDalitz();
+
+private:
+    double uniform(double lo = 0.0, double hi = 1.0) { return std::uniform_real_distribution<double>(lo, hi)(rng_); }
+    double gauss(double sigma) { return sigma > 0 ? std::normal_distribution<double>(0.0, sigma)(rng_) : 0.0; }
+    TVector3 isotropic(double mag);
+
+    // Lab four-momentum of a state of mass m recoiling against the proton.
+    TLorentzVector produce(double mass);
+    // Isotropic decay of parent into masses m1, m2, both returned in the lab.
+    void twoBody(const TLorentzVector& parent, double m1, double m2,
+                 TLorentzVector& d1, TLorentzVector& d2);
+    // η → π+π−π0 with the Dalitz matrix element, in the η rest frame.
+    void etaDecay(TLorentzVector& pip, TLorentzVector& pim, TLorentzVector& pi0);
+
+    void smearCharged(TLorentzVector& p);
+    void smearPhoton(TLorentzVector& p);
+
+    std::mt19937_64  rng_;
+    GeneratorOptions opts_;
+};
+
+// Independent seed for stream `index` (e.g. an output file) of a run seeded
+// with `seed`, so each stream is reproducible on its own.
+uint64_t streamSeed(uint64_t seed, uint64_t index);
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Format filename using pattern and event number
+// Supports patterns like "event_{:08d}.dat" or "data_{:06d}.bin"
+// Never throws: a malformed placeholder is formatted without padding.
+std::string formatFilename(const std::string& pattern, uint64_t event_num);
+// True if every "{:...}" placeholder is "{:d}" or "{:<width>d}".
+bool validFilenamePattern(const std::string& pattern);
+
+// Write data to memory-mapped file
+bool writeMemoryMappedFile(const std::string& filename, const uint8_t* data, size_t size);
+
+// Read-only memory mapping of a whole file (e.g. one received .dat event).
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+
+    const uint8_t* data() const { return data_; }
+    size_t         size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t         size_ = 0;
+};
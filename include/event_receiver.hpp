@@ -0,0 +1,61 @@
+#pragma once
+#include "file_processor.hpp"
+#include "event_capture.hpp"
+#include "metrics.hpp"
+#include "latency_histogram.hpp"
+#include "control_socket.hpp"
+#include <e2sar.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+// One-shot stop signal backed by an eventfd. trigger() is async-signal-safe,
+// and the descriptor can be poll()ed alongside sockets, so waiters wake
+// immediately instead of at the next timeout.
+class StopSignal {
+public:
+    StopSignal();
+    ~StopSignal();
+    StopSignal(const StopSignal&)            = delete;
+    StopSignal& operator=(const StopSignal&) = delete;
+
+    void trigger() noexcept;
+    bool triggered() const noexcept { return stopped_.load(std::memory_order_relaxed); }
+    // Block until triggered or timeout elapses; returns triggered().
+    bool waitFor(std::chrono::milliseconds timeout) const;
+    // Readable once triggered.
+    int  fd() const noexcept { return fd_; }
+
+private:
+    int               fd_ = -1;
+    std::atomic<bool> stopped_{false};
+};
+
+// Statistics for receiving events
+struct ReceiveStats {
+    std::atomic<uint64_t> events_received{0};
+    std::atomic<uint64_t> events_written{0};
+    std::atomic<uint64_t> write_errors{0};
+    std::atomic<uint64_t> total_bytes{0};
+    std::atomic<uint64_t> data_id_mismatches{0};
+    AtomicHistogram       event_bytes{{65536, 262144, 1048576, 4194304, 16777216, 67108864}};
+    // recvEvent return → event written, one histogram per dequeue thread
+    std::vector<std::unique_ptr<LatencyHistogram>> write_latency;
+    // Hardware counters per event (--perf-counters), shared by dequeue threads
+    PerfStageTotals       perf_dequeue;   // recvEvent call
+    PerfStageTotals       perf_write;     // .dat file or capture write
+
+    LatencyDistribution writeLatency() const;
+    void printProgress() const;
+};
+
+// Receive events until stop is triggered. args.dequeue_threads threads run a
+// loop of nothing but recvEvent and dispatch (per-event .dat file, or capture
+// when non-null); the calling thread only reports progress and waits on stop.
+// A non-null control server gets a "stats" command for the duration.
+// Prints the final summary and reassembler statistics before returning.
+bool receiveEvents(e2sar::Reassembler& reassembler, const CommandLineArgs& args,
+                   CaptureWriter* capture, StopSignal& stop,
+                   ControlServer* control = nullptr);
@@ -1,5 +1,8 @@
 #pragma once
 #include "event_data.hpp"
+#include "metrics.hpp"
+#include "control_socket.hpp"
+#include "perf_counters.hpp"
 #include <TFile.h>
 #include <TTree.h>
 #include <e2sar.hpp>
@@ -8,6 +11,8 @@
 #include <string>
 #include <atomic>
 #include <mutex>
+#include <functional>
+#include <chrono>
 #include <cstdint>
 
 struct CommandLineArgs {
@@ -25,8 +30,26 @@ struct CommandLineArgs {
     std::string recv_ip;
     uint16_t recv_port = 19522;
     size_t recv_threads = 1;
+    size_t dequeue_threads = 1;
+    std::vector<int> recv_cores;     // pin reassembler threads (one per core)
+    std::vector<int> dequeue_cores;  // pin dequeue threads (round-robin)
+    int numa_node = -1;              // preferred NUMA node for buffers
+    std::string stats_csv;           // periodic receiver counter time series
+    std::string stats_json;          // periodic + final JSON Lines records (sender and receiver)
+    std::string metrics_addr;        // Prometheus endpoint, host:port
+    std::string control_socket;      // Unix socket for live stats and settings
+    std::string trace_file;          // Chrome trace-event timeline
+    size_t trace_buffer = 16384;     // spans kept per thread for --trace
+    bool perf_counters = false;      // hardware counters per pipeline stage
+    size_t perf_sample = 64;         // count every Nth entry (sender) / event (receiver)
+    bool alloc_stats = false;        // batch / event buffer accounting and RSS
+    int stats_interval_ms = 1000;
     std::string output_pattern = "event_{:08d}.dat";
     int event_timeout_ms = 500;
+    std::string capture_file;        // record events into one capture file instead of per-event files
+    // Capture replay (sender)
+    std::string replay_file;
+    double replay_speedup = 1.0;     // <= 0 replays without pacing
     bool withCP;
     float rateGbps;
     bool validate;
@@ -36,8 +59,43 @@ struct CommandLineArgs {
 };
 
 // Defined in file_processor.cpp; also used by e2sar_root.cpp (receiveEvents, main).
+// Data-path threads print through async_log.hpp rather than std::cout.
 extern std::atomic<size_t> global_buffer_id;
-extern std::mutex          cout_mutex;
+// 0 = errors and end-of-run summary only, 1 = periodic progress,
+// 2 = progress for every batch.
+// Adjustable at run time through the control socket.
+extern std::atomic<int>    verbosity;
+// Batches handed to the segmenter and not yet released by its callback.
+extern std::atomic<uint64_t> inflight_buffers;
+extern std::atomic<uint64_t> inflight_bytes;
+
+// Send counters of one file's thread. Only that thread writes them, so
+// updates are relaxed load + store rather than locked read-modify-writes;
+// the --stats-json aggregator reads them concurrently. Cache-line aligned so
+// neighbouring files' threads never share a line.
+struct alignas(64) SendCounters {
+    std::atomic<uint64_t> events{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> retries{0};          // addToSendQueue MemoryError retries
+    std::atomic<uint64_t> backpressure_ns{0};  // time spent retrying
+    std::atomic<int64_t>  start_ns{0};         // steady_clock; 0 until started
+    std::atomic<int64_t>  end_ns{0};           // 0 while running
+    // Stage latencies (ns)
+    LatencyHistogram      get_entry_ns;      // tree->GetEntry per entry (entry timing only)
+    LatencyHistogram      serialize_ns;      // appendEntry total per batch (entry timing only)
+    LatencyHistogram      send_wait_ns;      // addToSendQueue per batch, retries included
+    LatencyHistogram      queue_to_free_ns;  // queued → free callback (Segmenter send thread)
+    // Hardware counters (--perf-counters)
+    PerfStageTotals       perf_read;         // GetEntry, sampled entries
+    PerfStageTotals       perf_convert;      // appendEntry, sampled entries
+    PerfStageTotals       perf_enqueue;      // pacing + addToSendQueue per batch
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
 
 // Abstract base for per-file ROOT processing (Template Method pattern).
 // process() owns the file open, batch allocation, send loop, and statistics.
@@ -54,13 +112,33 @@ public:
     // Template method: not overridden by subclasses.
     bool process(const std::string& file_path, const std::string& tree_name);
 
+    // Read-only mode: hand every completed batch to sink before it is freed,
+    // i.e. exactly the bytes the sender would put on the wire.
+    using BatchSink = std::function<void(const std::vector<double>& batch)>;
+    void setBatchSink(BatchSink sink) { batch_sink_ = std::move(sink); }
+
+    // Called with the buffer id (the E2SAR event number) and steady_clock ns
+    // right before each addToSendQueue attempt, e.g. to time events end to end.
+    using EnqueueHook = std::function<void(size_t buffer_id, int64_t ns)>;
+    void setEnqueueHook(EnqueueHook hook) { enqueue_hook_ = std::move(hook); }
+
+    // Publish send counters into an externally owned block (e.g. one slot of
+    // the array read by SendStatsReporter) instead of a private one.
+    void setCounters(SendCounters* counters) { counters_ = counters; }
+    // Live rate limit and prescale shared by all file threads; null for none.
+    void setControl(SendControl* control) { control_ = control; }
+    // Time GetEntry and appendEntry of every entry into get_entry_ns and
+    // serialize_ns. Off by default: it costs clock reads on the hottest loop,
+    // so enable it only when a reporter reads those stages.
+    void setEntryTiming(bool on) { entry_timing_ = on; }
+
 protected:
     // Bind type-specific branch addresses on the already-opened tree.
     virtual void bindBranches(TTree* tree) = 0;
     // Called after tree->GetEntry(i): build one event from loaded branch vars
     // and append it to batch. Save state for printSample() on the first call.
     virtual void appendEntry(std::vector<double>& batch) = 0;
-    // Print the first-event summary to stdout (cout_mutex already held by caller).
+    // Format the first-event summary into o.
     virtual void printSample(std::ostringstream &o) const = 0;
     // Serialized byte size of one event; used to compute batch capacity.
     virtual size_t eventSize() const = 0;
@@ -69,6 +147,12 @@ protected:
     e2sar::Segmenter*      segmenter_;
     size_t                 file_index_;
     boost::chrono::steady_clock::time_point send_start_;
+    BatchSink              batch_sink_;
+    EnqueueHook            enqueue_hook_;
+    SendCounters           own_counters_;
+    SendCounters*          counters_ = &own_counters_;
+    SendControl*           control_  = nullptr;
+    bool                   entry_timing_ = false;
 };
 
 // Processes Dalitz toy-MC ROOT files (dalitz_root_tree schema).
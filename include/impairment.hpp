@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <string>
+
+// Network impairment for the forwarding path (e2sar-lb-emu, e2sar-bench):
+// random and burst loss, duplication, reordering and delay, decided per
+// frame. Modelled on netem, so WAN conditions can be reproduced on loopback.
+
+struct ImpairmentConfig {
+    double   loss = 0;                 // independent drop probability
+    // Gilbert-Elliott burst loss: enter the bad state with burst_enter per
+    // frame, stay for burst_length frames on average, drop everything there
+    double   burst_enter = 0;
+    double   burst_length = 1;
+    double   duplicate = 0;            // probability a frame is sent twice
+    double   reorder = 0;              // probability a frame is held back...
+    int64_t  reorder_delay_ns = 1000000;   // ...this long, so later ones overtake it
+    int64_t  delay_ns = 0;             // fixed extra latency
+    int64_t  jitter_ns = 0;            // plus uniform [0, jitter)
+    uint64_t seed = 1;
+
+    bool active() const {
+        return loss > 0 || burst_enter > 0 || duplicate > 0 || reorder > 0 ||
+               delay_ns > 0 || jitter_ns > 0;
+    }
+    // Short form for logs and tables, e.g. "loss=0.01,delay=5ms"; "none"
+    // when inactive.
+    std::string describe() const;
+};
+
+// "key=value,..." with keys loss, burst (P_ENTER:MEAN_LENGTH), dup, reorder,
+// reorder-delay, delay, jitter and seed. Times take us / ms / s suffixes and
+// default to ms. Prints the reason and returns false on a bad spec.
+bool parseImpairment(const std::string& spec, ImpairmentConfig& out);
+
+// Per-thread decision source; not thread-safe.
+class Impairment {
+public:
+    // Copies of a frame to send (0 = dropped) and the delay of each.
+    struct Verdict {
+        int     copies = 1;
+        int64_t delay_ns[2] = {0, 0};
+    };
+
+    Impairment(const ImpairmentConfig& config, uint64_t stream);
+
+    Verdict decide();
+
+    uint64_t dropped()    const { return dropped_; }
+    uint64_t duplicated() const { return duplicated_; }
+    uint64_t reordered()  const { return reordered_; }
+
+private:
+    int64_t delayOnce();
+
+    ImpairmentConfig config_;
+    std::mt19937_64  rng_;
+    std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+    bool     bad_state_ = false;
+    uint64_t dropped_ = 0, duplicated_ = 0, reordered_ = 0;
+};
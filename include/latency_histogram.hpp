@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// HDR-style log-linear bucketing of nanosecond values: exact below 32 ns,
+// then 32 sub-buckets per power of two (at most ~3% relative error) over
+// the full 64-bit range. Bucket i covers [bucketLow(i), bucketHigh(i)].
+namespace latency_buckets {
+constexpr unsigned SUB_BITS = 5;
+constexpr size_t   SUB      = size_t{1} << SUB_BITS;
+constexpr size_t   COUNT    = (64 - SUB_BITS + 1) * SUB;
+
+inline size_t index(uint64_t v) {
+    if (v < SUB) return v;
+    unsigned shift = 63 - __builtin_clzll(v) - SUB_BITS;
+    return (shift + 1) * SUB + ((v >> shift) - SUB);
+}
+uint64_t bucketLow(size_t i);
+uint64_t bucketHigh(size_t i);
+} // namespace latency_buckets
+
+class LatencyDistribution;
+
+// Per-thread latency histogram for one pipeline stage. Exactly one thread
+// records into each, so record() is relaxed loads and stores rather than
+// locked read-modify-writes (as for SendCounters); a reporter may read
+// concurrently. Merge into a LatencyDistribution at report time.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint64_t ns) noexcept {
+        std::atomic<uint64_t>& count = counts_[latency_buckets::index(ns)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_.store(sum_.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        if (ns > max_.load(std::memory_order_relaxed))
+            max_.store(ns, std::memory_order_relaxed);
+    }
+
+    // Add this histogram's current contents to out.
+    void addTo(LatencyDistribution& out) const;
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+    std::atomic<uint64_t>                    sum_{0};
+    std::atomic<uint64_t>                    max_{0};
+};
+
+// Plain merged histogram for reporting.
+class LatencyDistribution {
+public:
+    LatencyDistribution() : counts_(latency_buckets::COUNT, 0) {}
+
+    uint64_t count() const { return count_; }
+    uint64_t max()   const { return max_; }
+    uint64_t sum()   const { return sum_; }
+    double   mean()  const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+    // Highest value equivalent to the q-quantile's bucket (q in [0, 1]),
+    // capped at the recorded maximum. 0 when empty.
+    uint64_t percentile(double q) const;
+    // Number of values <= ns, at bucket resolution.
+    uint64_t countAtOrBelow(uint64_t ns) const;
+
+    // "p50=12.3us p99=… p99.9=… max=… (n=…)"
+    std::string summary() const;
+
+private:
+    friend class LatencyHistogram;
+
+    std::vector<uint64_t> counts_;
+    uint64_t              count_ = 0;
+    uint64_t              sum_   = 0;
+    uint64_t              max_   = 0;
+};
+
+// Human-readable duration with an adaptive unit, e.g. "850ns", "12.3us".
+std::string formatNanos(uint64_t ns);
@@ -0,0 +1,179 @@
+#pragma once
+#include "impairment.hpp"
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+
+// Local stand-in for the EJFAT load balancer's data plane. Segmenters send
+// to it as they would to the LB; it picks a receiver per event from a slot
+// calendar and a port within that receiver from the packet entropy, so
+// multi-worker setups can be run and measured on one host. With a single
+// worker and an ImpairmentConfig it doubles as a lossy WAN proxy.
+
+// ── LB header ────────────────────────────────────────────────────────────────
+
+// The 16-byte header E2SAR puts in front of every frame sent to the LB
+// (network byte order). Versions 2 and 3 agree on the fields used here:
+//   0-1 "LB"  2 version  3 next protocol  4-5 reserved / slot select
+//   6-7 entropy / port select  8-15 event number (tick)
+constexpr size_t LB_HEADER_BYTES = 16;
+
+struct LBHeader {
+    uint8_t  version   = 2;
+    uint16_t entropy   = 0;
+    uint64_t event_num = 0;
+};
+
+// False if the frame is too short or does not start with an LB header.
+bool parseLBHeader(const uint8_t* data, size_t len, LBHeader& out);
+// Write a version-2 header (next protocol 1, the reassembly header).
+void writeLBHeader(uint8_t* data, const LBHeader& header);
+
+// ── Workers and calendar ─────────────────────────────────────────────────────
+
+struct LBWorker {
+    std::string host;        // numeric IPv4 / IPv6 address
+    uint16_t    port  = 0;   // first receive port
+    uint16_t    ports = 1;   // receive ports from port on; a power of two
+    double      weight = 1.0;
+    bool        strip_lb_header = false;   // this worker only; see LBEmulatorConfig
+};
+
+// "host:port[,ports=N][,weight=W]", IPv6 hosts in brackets. ports is rounded
+// up to a power of two, as the Reassembler does with its receive threads.
+bool parseLBWorker(const std::string& spec, LBWorker& out);
+
+// Slot calendar: event number modulo the slot count picks the worker. Slots
+// are shared out in proportion to the weights and interleaved, so
+// consecutive events go to different workers.
+class LBCalendar {
+public:
+    static constexpr size_t DEFAULT_SLOTS = 512;
+
+    explicit LBCalendar(const std::vector<double>& weights, size_t slots = DEFAULT_SLOTS);
+
+    size_t workerFor(uint64_t event_num) const { return slots_[event_num % slots_.size()]; }
+    size_t slotsFor(size_t worker) const;
+    size_t size() const { return slots_.size(); }
+
+private:
+    std::vector<uint32_t> slots_;
+};
+
+// ── Emulator ─────────────────────────────────────────────────────────────────
+
+struct LBEmulatorConfig {
+    std::string listen_ip   = "127.0.0.1";
+    uint16_t    listen_port = 19522;
+    std::vector<LBWorker> workers;
+    size_t      threads = 1;          // forwarding threads sharing the port (SO_REUSEPORT)
+    bool        strip_lb_header = false;   // as the real LB does; receivers then need withLBHeader off
+    size_t      calendar_slots = LBCalendar::DEFAULT_SLOTS;
+    int         socket_buffer_mb = 32;
+    // Applied per frame after routing; each thread draws its own stream
+    ImpairmentConfig impairment;
+};
+
+struct LBWorkerCounters {
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+struct LBEmulatorCounters {
+    std::atomic<uint64_t> frames_in{0};
+    std::atomic<uint64_t> bytes_in{0};
+    std::atomic<uint64_t> dropped{0};       // no LB header, larger than a jumbo frame, or no workers
+    std::atomic<uint64_t> send_errors{0};
+    // Impairment, if configured
+    std::atomic<uint64_t> impaired_drops{0};
+    std::atomic<uint64_t> duplicated{0};
+    std::atomic<uint64_t> reordered{0};
+};
+
+class LBEmulator {
+public:
+    explicit LBEmulator(LBEmulatorConfig config);
+    ~LBEmulator() { stop(); }
+    LBEmulator(const LBEmulator&)            = delete;
+    LBEmulator& operator=(const LBEmulator&) = delete;
+
+    // Bind the listen port and start forwarding. Prints the reason and
+    // returns false if a socket cannot be set up.
+    bool start();
+    void stop();
+
+    // Replace the workers and calendar, as the control plane does at an
+    // epoch change. The new calendar applies to events past the highest
+    // event number seen so far; events already under way finish on the old
+    // one. counters lines up with workers so a worker's totals carry over;
+    // missing entries start at zero. With no workers every frame is dropped.
+    // Prints the reason and returns false on a bad address.
+    bool setWorkers(std::vector<LBWorker> workers,
+                    std::vector<std::shared_ptr<LBWorkerCounters>> counters = {});
+
+    const LBEmulatorConfig&   config()   const { return config_; }
+    const LBEmulatorCounters& counters() const { return counters_; }
+    // Current epoch: 1 after start, +1 per setWorkers
+    uint64_t              epoch() const;
+    std::vector<LBWorker> workers() const;
+    LBCalendar            calendar() const;
+    std::shared_ptr<LBWorkerCounters> workerCounters(size_t worker) const;
+
+    // Print per-worker frames, bytes and share of the traffic.
+    void printSummary(std::ostream& out) const;
+
+private:
+    struct Destination {
+        sockaddr_storage addr{};
+        socklen_t        len = 0;
+    };
+
+    // Where each worker's frames go under one calendar
+    struct Routing {
+        std::vector<LBWorker> workers;
+        LBCalendar            calendar;
+        // Per worker: one address per receive port, LB header bytes to strip
+        std::vector<std::vector<Destination>> destinations;
+        std::vector<size_t>   skip;
+        std::vector<std::shared_ptr<LBWorkerCounters>> counters;
+    };
+
+    struct Epoch {
+        uint64_t id = 0;
+        uint64_t start_event = 0;      // events just below this stay on previous
+        std::shared_ptr<const Routing> current, previous;
+
+        const Routing& routeFor(uint64_t event_num) const;
+    };
+
+    struct DelayedFrame {
+        int64_t              due_ns = 0;
+        Destination          dest;
+        std::shared_ptr<LBWorkerCounters> counters;
+        std::vector<uint8_t> frame;
+    };
+
+    bool buildRouting(std::vector<LBWorker> workers,
+                      std::vector<std::shared_ptr<LBWorkerCounters>> counters,
+                      std::shared_ptr<Routing>& out) const;
+    void forwardLoop(int listen_fd, int send_fd, size_t index);
+
+    LBEmulatorConfig   config_;
+    LBEmulatorCounters counters_;
+    int                family_ = AF_INET;   // of every worker address
+
+    // Replaced with std::atomic_store; forwarding threads load it per batch
+    std::shared_ptr<const Epoch> epoch_;
+    std::mutex                   epoch_mutex_;      // serialises setWorkers
+    std::atomic<uint64_t>        max_event_{0};
+
+    std::vector<int>         fds_;
+    std::vector<std::thread> threads_;
+    int                      stop_fd_ = -1;
+};
@@ -0,0 +1,115 @@
+#pragma once
+#include "latency_histogram.hpp"
+#include "impairment.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// In-process loopback benchmark: a Segmenter and a Reassembler in the same
+// process exchange events over 127.0.0.1, so throughput, loss and latency
+// are measured directly instead of inferred from two processes' logs.
+
+// Serialized batches of one source file, as process() would send them.
+using BenchBatches = std::vector<std::vector<double>>;
+
+struct BenchConfig {
+    // Source data: one ROOT file per sender thread, reused round-robin
+    std::vector<std::string> files;
+    std::string tree_name;
+    bool        use_toy = true;
+    // Replay batches preloaded with loadBenchBatches() instead of reading
+    // the ROOT files during the trial (isolates the network path)
+    bool        from_memory = false;
+    size_t      passes = 1;              // times each sender thread sends its file
+    // Total file sends shared by the sender threads through a work queue,
+    // the k-th sending files[k % files.size()]; 0 = each sender thread t
+    // sends files[t % files.size()] `passes` times (data grows with threads)
+    size_t      file_sends = 0;
+
+    // Sender
+    size_t      sender_threads = 1;
+    // Segmenters the sender threads share, thread t enqueueing to t % segmenters
+    size_t      segmenters = 1;
+    size_t      bufsize_mb = 10;
+    uint16_t    mtu = 9000;
+    float       rate_gbps = -1;          // Segmenter rate limit; <= 0 for none
+
+    // Receiver
+    uint16_t    port = 19522;
+    size_t      recv_threads = 1;
+    size_t      dequeue_threads = 1;
+    int         event_timeout_ms = 500;
+    // Give up waiting for outstanding events after this long without progress
+    int         drain_timeout_ms = 3000;
+
+    // Route sender → receiver through an in-process LBEmulator listening on
+    // proxy_port, applying impairment there. Implied by an active impairment.
+    bool        proxy = false;
+    uint16_t    proxy_port = 19500;
+    ImpairmentConfig impairment;
+
+    // Take the --withcp path against an in-process MockControlPlane on
+    // cp_port: the receiver registers and reports state, the sender joins
+    // the allow list, and data goes through the mock's data plane on
+    // proxy_port. A ready receiver gets slots at the next cp_epoch_ms tick.
+    bool        control_plane = false;
+    uint16_t    cp_port = 18347;
+    int         cp_epoch_ms = 1000;
+
+    // Record peak RSS, page faults and the sender batch high-water mark
+    // (turns on alloc_accounting; needs the ROOT source, which allocates
+    // batches the way e2sar-root does)
+    bool        memory = false;
+
+    bool routed() const { return proxy || impairment.active() || control_plane; }
+};
+
+struct BenchResult {
+    bool     ok = false;
+    double   seconds = 0;              // first enqueue → last event received
+    double   cpu_seconds = 0;          // user + system, whole process
+    uint64_t buffers_sent = 0;
+    uint64_t buffers_received = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+    uint64_t events_received = 0;      // physics events
+    uint64_t send_errors = 0;
+    uint64_t reassembly_loss = 0;
+    uint64_t enqueue_loss = 0;
+    // Frames the proxy dropped / duplicated / reordered (routed trials)
+    uint64_t impaired_drops = 0;
+    uint64_t duplicated = 0;
+    uint64_t reordered = 0;
+    // registerWorker → first calendar with slots (control-plane trials)
+    double   cp_startup_ms = 0;
+    // Memory trials: peak RSS from the senders' start (whole process, so
+    // the receiver is included), page faults over the trial, and the most
+    // sender batch memory outstanding at once
+    uint64_t start_rss_bytes = 0;
+    uint64_t peak_rss_bytes = 0;
+    uint64_t minor_faults = 0;
+    uint64_t major_faults = 0;
+    uint64_t inflight_peak_bytes = 0;
+    uint64_t inflight_peak_batches = 0;
+    LatencyDistribution latency;       // enqueue → recvEvent, per buffer
+
+    double gbps() const { return seconds > 0 ? bytes_received * 8.0 / 1e9 / seconds : 0.0; }
+    double eventsPerSecond() const { return seconds > 0 ? events_received / seconds : 0.0; }
+    double lossFraction() const {
+        return buffers_sent ? 1.0 - static_cast<double>(buffers_received) / buffers_sent : 0.0;
+    }
+    // CPU cores busy per Gbps received (= CPU seconds per Gbit)
+    double coresPerGbps() const {
+        return bytes_received ? cpu_seconds / (bytes_received * 8.0 / 1e9) : 0.0;
+    }
+};
+
+// Read every file of config through the schema's processor in read-only
+// mode, keeping config.bufsize_mb batches in memory (one entry per file).
+bool loadBenchBatches(const BenchConfig& config, std::vector<BenchBatches>& out);
+
+// Run one trial. preloaded (indexed like config.files) is required when
+// config.from_memory is set, and must have been loaded with the same
+// bufsize_mb.
+BenchResult runLoopbackTrial(const BenchConfig& config,
+                             const std::vector<BenchBatches>* preloaded = nullptr);
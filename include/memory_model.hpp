@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Sender memory model from benchmark trials, for sizing e2sar-root memory
+// limits. Peak RSS is fitted by least squares as
+//
+//   base + per_thread × file threads + per_inflight × in-flight batch bytes
+//
+// and the in-flight peak is modelled as file threads × batch size × depth,
+// where depth (batches in flight per file thread) is measured per rate:
+// a rate limit below what the readers produce lets the send queue fill.
+
+struct MemorySample {
+    size_t   threads    = 0;     // file threads, one file each
+    size_t   bufsize_mb = 0;
+    double   rate_gbps  = 0;     // <= 0 = unlimited
+    uint64_t peak_rss_bytes        = 0;
+    uint64_t inflight_peak_bytes   = 0;
+    uint64_t inflight_peak_batches = 0;
+};
+
+class MemoryModel {
+public:
+    void add(const MemorySample& sample);
+    const std::vector<MemorySample>& samples() const { return samples_; }
+
+    // Fit the coefficients. Terms that do not vary across the samples stay
+    // 0 (their share lands in base). False without samples.
+    bool fit();
+
+    double baseBytes()       const { return base_; }
+    double perThreadBytes()  const { return per_thread_; }
+    double perInflightByte() const { return per_inflight_; }
+
+    // Most batches in flight per file thread at this rate; for a rate not
+    // measured, the deepest seen at any rate.
+    double depth(double rate_gbps) const;
+    // By rate, 0 = unlimited
+    const std::map<double, double>& depths() const { return depths_; }
+
+    double predictBytes(size_t threads, size_t bufsize_mb, double rate_gbps) const;
+
+    // Largest (measured - predicted) / measured over the samples, 0 if the
+    // model never under-predicts. Valid after fit().
+    double maxUnderPrediction() const;
+
+private:
+    std::vector<MemorySample> samples_;
+    std::map<double, double>  depths_;
+    double base_ = 0, per_thread_ = 0, per_inflight_ = 0;
+};
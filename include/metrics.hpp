@@ -0,0 +1,87 @@
+#pragma once
+#include "latency_histogram.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Fixed-bucket histogram updated with relaxed atomic adds, safe to observe()
+// from any number of threads and to read while they run. Bucket i counts
+// values <= bounds[i]; the last bucket counts everything above.
+class AtomicHistogram {
+public:
+    explicit AtomicHistogram(std::vector<uint64_t> bounds);
+
+    void observe(uint64_t value) noexcept {
+        size_t b = 0;
+        while (b < bounds_.size() && value > bounds_[b]) ++b;
+        buckets_[b].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    const std::vector<uint64_t>& bounds() const { return bounds_; }
+    // i == bounds().size() is the overflow bucket.
+    uint64_t bucket(size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<uint64_t>                    bounds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+    std::atomic<uint64_t>                    sum_{0};
+};
+
+// Prometheus text exposition format (version 0.0.4) builder.
+class PromText {
+public:
+    // # HELP and # TYPE lines; once per metric family, before its samples.
+    void family(const char* name, const char* type, const char* help);
+    // labels is the inside of {...}, e.g. label("file", "0"); empty for none.
+    void sample(const char* name, double value, const std::string& labels = {});
+    void sample(const char* name, uint64_t value, const std::string& labels = {});
+    // _bucket (cumulative, with le), _sum and _count series. Values are
+    // multiplied by scale, e.g. 1e-9 to export nanoseconds as seconds.
+    void histogram(const char* name, const AtomicHistogram& h, double scale,
+                   const std::string& labels = {});
+    // Same, re-bucketing a latency distribution onto bounds_ns.
+    void histogram(const char* name, const LatencyDistribution& d,
+                   const std::vector<uint64_t>& bounds_ns, double scale,
+                   const std::string& labels = {});
+
+    const std::string& str() const { return out_; }
+
+private:
+    std::string out_;
+};
+
+// key="value" with the value escaped for a label.
+std::string label(const char* key, const std::string& value);
+
+// Minimal HTTP/1.0 server for Prometheus scrapes. One background thread
+// poll()s the listening socket and serves GET /metrics sequentially by
+// calling the collector, which must only read atomics: the collector runs
+// concurrently with the data path and nothing on that path waits for it.
+class MetricsServer {
+public:
+    using Collector = std::function<void(PromText&)>;
+
+    MetricsServer() = default;
+    ~MetricsServer() { stop(); }
+    MetricsServer(const MetricsServer&)            = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // addr is "host:port" or "[v6addr]:port"; numeric hosts only.
+    bool start(const std::string& addr, Collector collector);
+    void stop();
+
+private:
+    void run();
+    void serve(int client);
+
+    Collector   collector_;
+    int         listen_fd_ = -1;
+    int         stop_fd_   = -1;
+    std::thread thread_;
+};
@@ -0,0 +1,148 @@
+#pragma once
+#include "lb_emulator.hpp"
+#include <cstdint>
+#include <fstream>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace grpc { class Server; }
+
+// Local stand-in for the EJFAT load balancer's control plane, so the
+// --withcp path (addSenderSelf, registerWorker / deregisterWorker, state
+// reports, CP-driven steering) runs and can be timed without
+// ejfat-lb.es.net. It serves the part of E2SAR's LoadBalancer gRPC service
+// that senders and receivers call, records every worker state report, and
+// steers events over an LBEmulator data plane whose calendar follows the
+// reported state.
+
+// ── Steering ─────────────────────────────────────────────────────────────────
+
+// Calendar weight of a worker: its registered weight scaled by
+// 1 + control_signal, the PID output of its state reports, and kept within
+// [min_factor, max_factor] times the registered weight (0 = no bound).
+double steeringWeight(double weight, double control_signal, double min_factor, double max_factor);
+
+// ── Control plane ────────────────────────────────────────────────────────────
+
+struct MockCPConfig {
+    std::string cp_ip   = "127.0.0.1";
+    uint16_t    cp_port = 18347;
+    uint16_t    sync_port = 19010;        // Segmenter sync packets, on data_plane.listen_ip
+    std::string lb_id = "1";
+    // Bearer token callers must present; empty accepts any
+    std::string token;
+    // Calendar rebuilt from the latest state reports this often; workers
+    // join at the first rebuild after they report ready
+    int         epoch_ms = 1000;
+    // Workers without a state report for this long lose their slots
+    int         state_timeout_ms = 2000;
+    // CSV of every state report, if set
+    std::string state_log;
+    // Data plane: listen address (the URI's data=), threads, impairment.
+    // Workers come from registrations and always have the LB header stripped.
+    LBEmulatorConfig data_plane;
+};
+
+// A registered receiver as the control plane sees it.
+struct MockCPWorker {
+    std::string session_id;
+    std::string token;                    // session token issued at registration
+    std::string name;
+    LBWorker    address;                  // ipAddress, udpPort, 2^portRange ports
+    double      weight = 1.0;
+    double      min_factor = 0;
+    double      max_factor = 0;
+    // Latest state report
+    double      fill_percent = 0;
+    double      control_signal = 0;
+    bool        ready = false;
+    uint64_t    reports = 0;
+    double      report_age_ms = 0;        // receipt time - report timestamp
+    // steady_clock ns; 0 = not yet
+    int64_t     registered_ns = 0;
+    int64_t     last_report_ns = 0;
+    int64_t     ready_ns = 0;             // first ready report
+    int64_t     routed_ns = 0;            // first calendar with slots for it
+    double      slot_weight = 0;          // in the current calendar; 0 = no slots
+    std::shared_ptr<LBWorkerCounters> counters = std::make_shared<LBWorkerCounters>();
+};
+
+// Sync packets from one Segmenter event source.
+struct MockCPSyncSource {
+    uint32_t src_id = 0;
+    uint64_t packets = 0;
+    uint64_t last_event = 0;
+    uint32_t rate_hz = 0;                 // the sender's reported average event rate
+};
+
+class MockControlPlane {
+public:
+    explicit MockControlPlane(MockCPConfig config);
+    ~MockControlPlane();
+    MockControlPlane(const MockControlPlane&)            = delete;
+    MockControlPlane& operator=(const MockControlPlane&) = delete;
+
+    // Start the data plane, the sync listener and the gRPC server. Prints
+    // the reason and returns false if any of them cannot be set up.
+    bool start();
+    void stop();
+
+    // URI for senders and receivers: plain ejfat:// (no TLS) with the
+    // token, CP, sync and data addresses of this instance.
+    std::string uri() const;
+
+    // Rebuild the calendar from the latest state now; the epoch thread
+    // calls this every epoch_ms. Returns true if the calendar changed.
+    bool rebalance();
+
+    const MockCPConfig&           config()  const { return config_; }
+    const LBEmulator&             dataPlane() const { return data_plane_; }
+    std::vector<MockCPWorker>     workers() const;
+    std::vector<std::string>      senders() const;
+    std::vector<MockCPSyncSource> syncSources() const;
+
+    // Workers (state, slots, frames, startup latency), senders and sync
+    // sources, then the data plane summary.
+    void printSummary(std::ostream& out) const;
+
+private:
+    class Service;
+
+    // gRPC handlers; each returns false with a reason in error
+    bool authorized(const std::string& bearer) const;
+    void addSenders(const std::vector<std::string>& addresses);
+    void removeSenders(const std::vector<std::string>& addresses);
+    bool registerWorker(MockCPWorker worker, std::string& session_id, std::string& token,
+                        std::string& error);
+    bool deregisterWorker(const std::string& session_id, std::string& error);
+    bool reportState(const std::string& session_id, double fill_percent, double control_signal,
+                     bool ready, int64_t report_unix_ns, std::string& error);
+
+    bool rebalanceLocked(int64_t now_ns);
+    void epochLoop();
+    void syncLoop(int fd);
+
+    MockCPConfig config_;
+    LBEmulator   data_plane_;
+
+    mutable std::mutex                  mutex_;
+    std::map<std::string, MockCPWorker> workers_;      // by session id
+    std::vector<std::string>            senders_;
+    std::map<uint32_t, MockCPSyncSource> sync_sources_;
+    // Session and weight of each worker in the installed calendar, in its order
+    std::vector<std::pair<std::string, double>> installed_;
+    uint64_t                            next_session_ = 1;
+    std::ofstream                       state_log_;
+    int64_t                             started_ns_ = 0;
+
+    std::unique_ptr<Service>      service_;
+    std::unique_ptr<grpc::Server> server_;
+    std::thread                   epoch_thread_, sync_thread_;
+    int                           sync_fd_ = -1;
+    int                           stop_fd_ = -1;
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Hardware counters read through perf_event_open (--perf-counters). Counts
+// are user space only for the calling thread, so an unprivileged run works
+// with kernel.perf_event_paranoid <= 2.
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_DTLB_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+};
+
+// Counter values, scaled up when the PMU was multiplexed.
+struct PerfReading {
+    uint64_t value[PERF_EVENT_COUNT] = {};
+};
+
+// One counter group on the calling thread: open() it on the thread that will
+// read() it. Events the PMU or hypervisor does not offer are left out and
+// reported as unavailable instead of failing the group.
+class PerfCounterGroup {
+public:
+    PerfCounterGroup() = default;
+    ~PerfCounterGroup();
+    PerfCounterGroup(const PerfCounterGroup&)            = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    // False (with a one-time warning per process) if not even cycles open.
+    bool open();
+    bool isOpen() const { return fds_[PERF_CYCLES] >= 0; }
+    // Bit i set when PerfEvent i is counted.
+    uint32_t available() const { return available_; }
+
+    // One read() syscall; false if the group was never scheduled.
+    bool read(PerfReading& out) const;
+
+private:
+    int      fds_[PERF_EVENT_COUNT] = {-1, -1, -1, -1, -1};
+    int      slot_[PERF_EVENT_COUNT] = {};   // position in the group read
+    int      members_ = 0;
+    uint32_t available_ = 0;
+};
+
+// Counter deltas summed over the measured occurrences of one stage. add()
+// is a relaxed fetch_add per event, so several threads may share one.
+class PerfStageTotals {
+public:
+    void add(const PerfCounterGroup& group, const PerfReading& before, const PerfReading& after);
+
+    uint64_t samples() const { return samples_.load(std::memory_order_relaxed); }
+    uint64_t value(PerfEvent e) const { return value_[e].load(std::memory_order_relaxed); }
+    uint32_t available() const { return available_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> samples_{0};
+    std::atomic<uint64_t> value_[PERF_EVENT_COUNT] = {};
+    std::atomic<uint32_t> available_{0};
+};
+
+// Plain sum of several PerfStageTotals for reporting.
+struct PerfSummary {
+    uint64_t samples = 0;
+    uint64_t value[PERF_EVENT_COUNT] = {};
+    uint32_t available = 0;
+
+    void merge(const PerfStageTotals& t);
+    // "IPC=1.42 cycles=3120 instructions=4431 LLC-misses=12.0 dTLB-misses=3.10
+    //  branch-misses=8.20 per event (n=31250)"
+    std::string summary() const;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+// USDT static probes (provider "e2sar_utils") on the sender and receiver hot
+// paths. With systemtap's <sys/sdt.h> at build time (-Dusdt, on by default
+// when the header exists) each probe is a single nop plus an ELF note, so an
+// unattached probe costs nothing measurable; without it they compile away.
+// Arguments must stay cheap: they are evaluated even when nothing attaches.
+//
+//   batch_ready   (buffer_id, bytes, data_id, events)   batch built, about to queue
+//   enqueue       (buffer_id, bytes, data_id, retries)  accepted by addToSendQueue
+//   enqueue_retry (buffer_id, bytes, data_id, retry)    send queue full, backing off
+//   buffer_free   (buffer_id, bytes, data_id, queued_ns) segmenter free callback
+//   recv_event    (event_num, bytes, data_id)           recvEvent returned an event
+//   write_start   (event_num, bytes, data_id)
+//   write_end     (event_num, bytes, data_id, ok)
+//
+// List them with: readelf -n $(which e2sar-root) | grep -A2 stapsdt
+// Attach with e.g.: bpftrace -e 'usdt:./e2sar-root:e2sar_utils:enqueue_retry { @[arg0] = count(); }'
+
+#ifdef E2SAR_UTILS_USDT
+#include <sys/sdt.h>
+#define E2SAR_PROBE3(name, a, b, c)    DTRACE_PROBE3(e2sar_utils, name, a, b, c)
+#define E2SAR_PROBE4(name, a, b, c, d) DTRACE_PROBE4(e2sar_utils, name, a, b, c, d)
+#else
+#define E2SAR_PROBE3(name, a, b, c)    do {} while (0)
+#define E2SAR_PROBE4(name, a, b, c, d) do {} while (0)
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// Scaling curves from benchmark trials: throughput against thread count,
+// with speedup and parallel efficiency relative to the fewest threads.
+// Strong scaling (fixed data, time ∝ 1/throughput) and weak scaling (data
+// ∝ threads) reduce to the same ratio: efficiency = (R(n) / R(n0)) / (n / n0).
+
+enum class ScalingMode { None, Strong, Weak };
+
+// "strong" or "weak"; false for anything else.
+bool        parseScalingMode(const std::string& text, ScalingMode& mode);
+const char* scalingModeName(ScalingMode mode);
+
+struct ScalingPoint {
+    size_t threads    = 0;
+    size_t trials     = 0;
+    double gbps       = 0;    // mean over the trials
+    double speedup    = 0;    // gbps / gbps at the fewest threads
+    double efficiency = 0;    // speedup / (threads / fewest threads)
+};
+
+class ScalingCurve {
+public:
+    // Efficiency below which a curve has stopped scaling
+    static constexpr double DEFAULT_KNEE_EFFICIENCY = 0.8;
+
+    // Record one trial.
+    void add(size_t threads, double gbps);
+
+    // One point per thread count, ascending. Empty without trials.
+    std::vector<ScalingPoint> points() const;
+
+    // Fewest threads whose efficiency is below threshold; 0 if the curve
+    // scales over its whole range.
+    size_t knee(double threshold = DEFAULT_KNEE_EFFICIENCY) const;
+
+private:
+    struct Sum {
+        double gbps   = 0;
+        size_t trials = 0;
+    };
+    std::map<size_t, Sum> sums_;      // by threads
+};
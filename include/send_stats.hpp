@@ -0,0 +1,58 @@
+#pragma once
+#include "file_processor.hpp"
+#include "stats_json.hpp"
+#include "metrics.hpp"
+#include <e2sar.hpp>
+#include <condition_variable>
+#include <ostream>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <vector>
+
+// Sender statistics from the per-file SendCounters (relaxed loads, never
+// blocking the file threads) and the Segmenter's getSendStats(). For
+// --stats-json a background thread appends a "sender" record every
+// interval and finish() writes the final record once the send queues
+// drained; writeMetrics() serves the same counters to --metrics-addr.
+class SendStatsReporter {
+public:
+    // counters[i] belongs to files[i]; segmenter may be null (read-only mode).
+    SendStatsReporter(const std::vector<std::string>& files, const SendCounters* counters,
+                      e2sar::Segmenter* segmenter);
+    ~SendStatsReporter() { finish(); }
+    SendStatsReporter(const SendStatsReporter&)            = delete;
+    SendStatsReporter& operator=(const SendStatsReporter&) = delete;
+
+    bool start(const std::string& path, int interval_ms);
+    // Stop sampling, write the final record and close the file. Idempotent.
+    void finish();
+
+    // One "sender" record; safe to call from any thread at any time.
+    void buildRecord(JsonWriter& json, bool final) const;
+    // Prometheus collector; safe to call from the metrics server thread.
+    void writeMetrics(PromText& out) const;
+    // p50/p99/p99.9/max of every sender stage, merged over all files.
+    void printLatency(std::ostream& out) const;
+    // IPC and misses per event of every sender stage (--perf-counters).
+    void printPerfCounters(std::ostream& out) const;
+    // Batch memory and process RSS (--alloc-stats).
+    void printMemory(std::ostream& out) const;
+
+private:
+    void run(std::chrono::milliseconds interval);
+    void writeRecord(bool final);
+    LatencyDistribution mergeStage(LatencyHistogram SendCounters::* stage) const;
+
+    const std::vector<std::string>&       files_;
+    const SendCounters*                   counters_;
+    e2sar::Segmenter*                     segmenter_;
+    JsonLinesFile                         out_;
+    JsonWriter                            json_;
+    std::chrono::steady_clock::time_point start_;
+
+    std::thread             thread_;
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    bool                    stopping_ = false;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal streaming JSON builder for flat stats records. Keys are trusted
+// literals; string values are escaped. Non-finite doubles become null.
+class JsonWriter {
+public:
+    JsonWriter& beginObject(const char* key = nullptr);
+    JsonWriter& endObject();
+    JsonWriter& beginArray(const char* key);
+    JsonWriter& endArray();
+
+    JsonWriter& field(const char* key, uint64_t value);
+    JsonWriter& field(const char* key, double value);
+    JsonWriter& field(const char* key, bool value);
+    JsonWriter& field(const char* key, const std::string& value);
+    JsonWriter& field(const char* key, const char* value) { return field(key, std::string(value)); }
+
+    const std::string& str() const { return out_; }
+    void clear() { out_.clear(); first_.clear(); }
+
+private:
+    // Comma and "key": prefix for the next member or array element.
+    void separate(const char* key);
+
+    std::string       out_;
+    std::vector<bool> first_;   // one entry per open object/array
+};
+
+// Start a stats record: opens the object and writes the fields every record
+// shares ("record", "final", "unix_ms", "elapsed_s"). Close with endObject().
+void beginStatsRecord(JsonWriter& json, const char* kind, bool final,
+                      std::chrono::steady_clock::time_point start);
+
+// JSON Lines output: one complete record per line, flushed as written so a
+// consumer can tail the file while the run is in progress.
+class JsonLinesFile {
+public:
+    JsonLinesFile() = default;
+    ~JsonLinesFile() { close(); }
+    JsonLinesFile(const JsonLinesFile&)            = delete;
+    JsonLinesFile& operator=(const JsonLinesFile&) = delete;
+
+    bool open(const std::string& path);
+    void write(const JsonWriter& record);
+    void close();
+
+    bool isOpen() const { return fp_ != nullptr; }
+
+private:
+    FILE* fp_ = nullptr;
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CSV time series of monotonically increasing counters. Each sample() writes
+// one row: wall-clock time, elapsed seconds, then every counter followed by
+// its per-second rate since the previous row. A row is formatted into the
+// stdio buffer and flushed once, so a crashed run keeps its history.
+class CounterSeries {
+public:
+    CounterSeries() = default;
+    ~CounterSeries() { close(); }
+    CounterSeries(const CounterSeries&)            = delete;
+    CounterSeries& operator=(const CounterSeries&) = delete;
+
+    bool open(const std::string& path, const std::vector<std::string>& columns);
+    // values must be in the order of the columns given to open().
+    void sample(const std::vector<uint64_t>& values);
+    void close();
+
+    bool isOpen() const { return fp_ != nullptr; }
+
+private:
+    FILE*                                 fp_ = nullptr;
+    size_t                                n_columns_ = 0;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point last_;
+    std::vector<uint64_t>                 prev_;
+};
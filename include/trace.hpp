@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Chrome Trace Event timeline recorder (--trace). Each thread records
+// complete spans into its own preallocated ring buffer, so recording is a
+// clock read and a few stores with no locking or allocation; when a ring
+// fills, the oldest spans are overwritten. Rings are left uninitialized, so
+// a thread only faults in the pages its spans actually reach. write() dumps all rings as a
+// JSON trace loadable in chrome://tracing or ui.perfetto.dev.
+namespace trace {
+
+// Span and argument names must be string literals: only pointers are stored.
+struct Event {
+    const char* name;
+    const char* arg_name;   // nullptr for no argument
+    uint64_t    arg;
+    int64_t     start_ns;
+    int64_t     end_ns;
+};
+
+namespace detail {
+extern std::atomic<bool> enabled;
+}
+
+// Start recording with room for events_per_thread spans in each thread.
+constexpr size_t DEFAULT_EVENTS_PER_THREAD = 16384;   // 640 KB
+void enable(size_t events_per_thread);
+inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+// Span timestamps are steady_clock nanoseconds.
+inline int64_t nanos(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+inline int64_t now() { return nanos(std::chrono::steady_clock::now()); }
+
+// Label the calling thread's track and allocate its ring up front, so the
+// first span does not pay for it. No-op while disabled.
+void nameThread(const std::string& name);
+
+void record(const char* name, int64_t start_ns, int64_t end_ns,
+            const char* arg_name = nullptr, uint64_t arg = 0);
+
+// Write every thread's spans to path. Call once the recording threads have
+// finished; spans recorded concurrently may be torn.
+bool write(const std::string& path);
+
+} // namespace trace
@@ -0,0 +1,99 @@
+#pragma once
+#include "event_data.hpp"
+#include <TFile.h>
+#include <TTree.h>
+#include <memory>
+#include <string>
+
+// Storage settings for written ROOT files.
+struct TreeWriterOptions {
+    // ROOT compression setting, algorithm * 100 + level (e.g. 101 zlib-1, 404 LZ4-4, 505 ZSTD-5)
+    int      compression = 101;
+    // Per-branch basket buffer size in bytes
+    int      basket_size = 32000;
+    // Cluster size (TTree::SetAutoFlush): > 0 entries, < 0 bytes of compressed data
+    Long64_t auto_flush  = -30000000;
+};
+
+// Abstract base for writing events back into a ROOT tree of a given schema.
+// The inverse of RootFileProcessor: open() creates the file and tree,
+// subclasses declare the branches and copy one event into the branch
+// variables per fill.
+class RootTreeWriter {
+public:
+    explicit RootTreeWriter(const TreeWriterOptions& opts = {}) : opts_(opts) {}
+    // Subclasses close() in their own destructor: writing the tree reads the
+    // branch variables, which are gone by the time this one runs.
+    virtual ~RootTreeWriter() = default;
+    RootTreeWriter(const RootTreeWriter&)            = delete;
+    RootTreeWriter& operator=(const RootTreeWriter&) = delete;
+
+    // Create file_path (overwriting it) with an empty tree named tree_name.
+    bool open(const std::string& file_path, const std::string& tree_name);
+    // Write the tree and close the file. Safe to call more than once.
+    bool close();
+
+    // Fill one entry from a serialized event (numDoubles() values at p).
+    virtual void fillFromBuffer(const double* p) = 0;
+    // Doubles per serialized event of this schema.
+    virtual size_t numDoubles() const = 0;
+
+    Long64_t entries() const { return entries_; }
+
+protected:
+    // Declare the schema's branches on the freshly created tree.
+    virtual void createBranches(TTree* tree) = 0;
+
+    void fillTree() { tree_->Fill(); ++entries_; }
+
+    TreeWriterOptions      opts_;
+    std::unique_ptr<TFile> file_;
+    TTree*                 tree_    = nullptr;   // owned by file_
+    Long64_t               entries_ = 0;
+};
+
+// Writes the Dalitz toy-MC schema (dalitz_root_tree): spherical
+// mag/theta/phi_{plus,neg,neutral1,neutral2}_rec branches.
+class ToyTreeWriter : public RootTreeWriter {
+public:
+    static constexpr const char* DEFAULT_TREE = "dalitz_root_tree";
+
+    using RootTreeWriter::RootTreeWriter;
+    ~ToyTreeWriter() override { close(); }
+
+    void fill(const DalitzEventData& event);
+    void fillFromBuffer(const double* p) override { fill(DalitzEventData::fromBuffer(p)); }
+    size_t numDoubles() const override { return DalitzEventData::NUM_DOUBLES; }
+
+protected:
+    void createBranches(TTree* tree) override;
+
+private:
+    Double_t mag_plus_rec_      = 0, theta_plus_rec_      = 0, phi_plus_rec_      = 0;
+    Double_t mag_neg_rec_       = 0, theta_neg_rec_       = 0, phi_neg_rec_       = 0;
+    Double_t mag_neutral1_rec_  = 0, theta_neutral1_rec_  = 0, phi_neutral1_rec_  = 0;
+    Double_t mag_neutral2_rec_  = 0, theta_neutral2_rec_  = 0, phi_neutral2_rec_  = 0;
+};
+
+// Writes the GlueX kinematic-fit schema (myTree): TLorentzVector
+// pip/pim/g1/g2_p4_kin branches plus imass_kfit, imassGG_kfit, kfit_prob.
+class GluexTreeWriter : public RootTreeWriter {
+public:
+    static constexpr const char* DEFAULT_TREE = "myTree";
+
+    using RootTreeWriter::RootTreeWriter;
+    ~GluexTreeWriter() override { close(); }
+
+    void fill(const GluexEventData& event);
+    void fillFromBuffer(const double* p) override { fill(GluexEventData::fromBuffer(p)); }
+    size_t numDoubles() const override { return GluexEventData::NUM_DOUBLES; }
+
+protected:
+    void createBranches(TTree* tree) override;
+
+private:
+    TLorentzVector  pip_, pim_, g1_, g2_;
+    TLorentzVector *pip_ptr_ = &pip_, *pim_ptr_ = &pim_;
+    TLorentzVector *g1_ptr_  = &g1_,  *g2_ptr_  = &g2_;
+    Double_t        imass_kfit_ = 0.0, imassGG_kfit_ = 0.0, kfit_prob_ = 0.0;
+};
@@ -0,0 +1,80 @@
+#include "alloc_stats.hpp"
+#include <cstdio>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// ── Globals ──────────────────────────────────────────────────────────────────
+
+std::atomic<bool> alloc_accounting{false};
+AllocCounter      batch_memory;
+AllocCounter      event_memory;
+
+// ── AllocCounter ─────────────────────────────────────────────────────────────
+
+std::string AllocCounter::summary() const {
+    return std::to_string(allocations()) + " allocated (" + formatBytes(totalBytes()) +
+           "), peak " + formatBytes(peakBytes()) + " in " + std::to_string(peakCount()) +
+           " outstanding, " + formatBytes(liveBytes()) + " live";
+}
+
+void AllocCounter::addTo(JsonWriter& json, const char* key) const {
+    json.beginObject(key)
+        .field("allocations", allocations())
+        .field("frees", frees())
+        .field("bytes", totalBytes())
+        .field("live", liveCount())
+        .field("live_bytes", liveBytes())
+        .field("peak", peakCount())
+        .field("peak_bytes", peakBytes())
+        .endObject();
+}
+
+void AllocCounter::addTo(PromText& out, const std::string& prefix, const char* what) const {
+    auto metric = [&](const char* suffix, const char* type, const std::string& help, uint64_t value) {
+        std::string name = prefix + suffix;
+        out.family(name.c_str(), type, help.c_str());
+        out.sample(name.c_str(), value);
+    };
+    metric("_allocations_total", "counter", std::string("Number of ") + what + " allocated", allocations());
+    metric("_bytes_total", "counter", std::string("Bytes of ") + what + " allocated", totalBytes());
+    metric("_live_bytes", "gauge", std::string("Bytes of ") + what + " outstanding", liveBytes());
+    metric("_peak_bytes", "gauge", std::string("Most bytes of ") + what + " outstanding at once", peakBytes());
+}
+
+// ── Process memory ───────────────────────────────────────────────────────────
+
+uint64_t currentRssBytes() {
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long size = 0, resident = 0;
+    int n = std::fscanf(f, "%lu %lu", &size, &resident);
+    std::fclose(f);
+    return n == 2 ? static_cast<uint64_t>(resident) * sysconf(_SC_PAGESIZE) : 0;
+}
+
+uint64_t peakRssBytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;   // Linux reports KiB
+}
+
+bool resetPeakRss() {
+    FILE* f = std::fopen("/proc/self/clear_refs", "w");
+    if (!f) return false;
+    bool ok = std::fputs("5", f) >= 0;
+    return std::fclose(f) == 0 && ok;
+}
+
+std::string formatBytes(uint64_t bytes) {
+    static const char* const UNITS[] = {"KB", "MB", "GB", "TB"};
+    if (bytes < 1024) return std::to_string(bytes) + " B";
+    double v = bytes / 1024.0;
+    size_t u = 0;
+    while (v >= 1024 && u + 1 < sizeof(UNITS) / sizeof(UNITS[0])) {
+        v /= 1024;
+        ++u;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f %s", v, UNITS[u]);
+    return buf;
+}
@@ -0,0 +1,205 @@
+#include "async_log.hpp"
+#include "file_processor.hpp"
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Record {
+    int64_t     ns = 0;
+    LogLevel    level = LogLevel::Info;
+    std::string text;
+};
+
+// Single-producer (the owning thread) / single-consumer (whoever holds the
+// logger's drain mutex) ring. Strings are moved in and out, so the hand-off
+// itself does not allocate; building the message in the caller still does.
+struct LogRing {
+    static constexpr size_t CAPACITY = 1024;
+
+    Record                slots[CAPACITY];
+    std::atomic<uint64_t> head{0};        // next slot to fill; producer only
+    std::atomic<uint64_t> tail{0};        // next slot to drain; consumer only
+    std::atomic<uint64_t> dropped{0};     // ring full
+    std::atomic<uint64_t> suppressed{0};  // over the rate limit
+    std::atomic<bool>     closed{false};  // owner thread exited
+
+    // Token bucket; producer only
+    double  tokens  = -1;                 // < 0 until first use
+    int64_t last_ns = 0;
+};
+
+class AsyncLogger {
+public:
+    AsyncLogger() : thread_(&AsyncLogger::run, this) {}
+    ~AsyncLogger() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+        drain();
+    }
+
+    LogRing* attach() {
+        auto ring = std::make_unique<LogRing>();
+        LogRing* raw = ring.get();
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(std::move(ring));
+        return raw;
+    }
+
+    std::atomic<double> rate_limit{100.0};
+
+    // Move every queued record out, write them in timestamp order, and
+    // release rings whose thread has exited.
+    void drain() {
+        std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+        batch_.clear();
+        uint64_t dropped = 0, suppressed = 0;
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            for (auto it = rings_.begin(); it != rings_.end();) {
+                LogRing& ring = **it;
+                bool closed = ring.closed.load(std::memory_order_acquire);
+                uint64_t head = ring.head.load(std::memory_order_acquire);
+                uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+                for (; tail < head; ++tail)
+                    batch_.push_back(std::move(ring.slots[tail % LogRing::CAPACITY]));
+                ring.tail.store(tail, std::memory_order_release);
+                dropped    += ring.dropped.exchange(0, std::memory_order_relaxed);
+                suppressed += ring.suppressed.exchange(0, std::memory_order_relaxed);
+                it = closed ? rings_.erase(it) : it + 1;
+            }
+        }
+
+        std::stable_sort(batch_.begin(), batch_.end(),
+                         [](const Record& a, const Record& b) { return a.ns < b.ns; });
+        bool to_cout = false, to_cerr = false;
+        for (const Record& r : batch_) {
+            if (r.level <= LogLevel::Warning) {
+                std::cerr << r.text << '\n';
+                to_cerr = true;
+            } else {
+                std::cout << r.text << '\n';
+                to_cout = true;
+            }
+        }
+        if (dropped > 0 || suppressed > 0) {
+            std::cerr << "[log] " << suppressed << " message(s) over the rate limit and "
+                      << dropped << " with a full queue were not shown\n";
+            to_cerr = true;
+        }
+        if (to_cout) std::cout.flush();
+        if (to_cerr) std::cerr.flush();
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        while (!stopping_) {
+            wake_.wait_for(lock, std::chrono::milliseconds(20));
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+    std::mutex                            rings_mutex_;
+    std::vector<std::unique_ptr<LogRing>> rings_;
+    std::mutex                            drain_mutex_;
+    std::vector<Record>                   batch_;
+
+    std::mutex              wake_mutex_;
+    std::condition_variable wake_;
+    bool                    stopping_ = false;
+    std::thread             thread_;
+};
+
+AsyncLogger& logger() {
+    static AsyncLogger instance;
+    return instance;
+}
+
+// Marks the thread's ring closed on thread exit; the flusher frees it once
+// drained.
+struct RingHandle {
+    LogRing* ring = nullptr;
+    ~RingHandle() { if (ring) ring->closed.store(true, std::memory_order_release); }
+};
+
+thread_local RingHandle local_ring;
+
+bool allow(LogRing& ring, int64_t now, double rate) {
+    if (rate <= 0) return true;
+    if (ring.tokens < 0) {
+        ring.tokens  = 2 * rate;
+        ring.last_ns = now;
+    }
+    ring.tokens  = std::min(2 * rate, ring.tokens + (now - ring.last_ns) * rate / 1e9);
+    ring.last_ns = now;
+    if (ring.tokens < 1) return false;
+    ring.tokens -= 1;
+    return true;
+}
+
+} // namespace
+
+// ── Public API ───────────────────────────────────────────────────────────────
+
+bool logEnabled(LogLevel level) {
+    int v = verbosity.load(std::memory_order_relaxed);
+    return level <= LogLevel::Warning ||
+           (level == LogLevel::Info && v >= 1) ||
+           (level == LogLevel::Debug && v >= 2);
+}
+
+void logMessage(LogLevel level, std::string text) {
+    if (!logEnabled(level)) return;
+
+    AsyncLogger& log = logger();
+    if (!local_ring.ring)
+        local_ring.ring = log.attach();
+    LogRing& ring = *local_ring.ring;
+
+    int64_t now = steadyNs();
+    if (level > LogLevel::Warning &&
+        !allow(ring, now, log.rate_limit.load(std::memory_order_relaxed))) {
+        ring.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= LogRing::CAPACITY) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Record& slot = ring.slots[head % LogRing::CAPACITY];
+    slot.ns    = now;
+    slot.level = level;
+    slot.text  = std::move(text);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void logFlush() {
+    logger().drain();
+}
+
+void logSetRateLimit(double per_second) {
+    logger().rate_limit.store(per_second, std::memory_order_relaxed);
+}
@@ -0,0 +1,291 @@
+#include "control_socket.hpp"
+#include "file_processor.hpp"
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <algorithm>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double parseNumber(const ControlServer::Args& args, const char* what) {
+    if (args.size() != 1)
+        throw std::runtime_error(std::string("expected one ") + what);
+    try {
+        size_t used = 0;
+        double v = std::stod(args[0], &used);
+        if (used != args[0].size() || !std::isfinite(v)) throw std::invalid_argument(args[0]);
+        return v;
+    } catch (const std::logic_error&) {
+        throw std::runtime_error(std::string("invalid ") + what + " '" + args[0] + "'");
+    }
+}
+
+// A connected control client and its partial request line.
+struct Client {
+    int         fd;
+    std::string pending;
+};
+
+} // namespace
+
+// ── SendPacer ────────────────────────────────────────────────────────────────
+
+void SendPacer::setRate(double gbps) {
+    gbps = std::min(gbps, MAX_GBPS);
+    bits_per_sec_.store(gbps > 0 ? static_cast<uint64_t>(gbps * 1e9) : 0, std::memory_order_relaxed);
+    // Forget slots reserved at the old rate and wake their holders
+    next_ns_.store(0, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        generation_.fetch_add(1, std::memory_order_relaxed);
+    }
+    rate_changed_.notify_all();
+}
+
+double SendPacer::rate() const {
+    return bits_per_sec_.load(std::memory_order_relaxed) / 1e9;
+}
+
+void SendPacer::acquire(size_t bytes) {
+    for (;;) {
+        uint64_t generation = generation_.load(std::memory_order_relaxed);
+        uint64_t bps        = bits_per_sec_.load(std::memory_order_relaxed);
+        if (bps == 0) return;
+
+        int64_t cost = static_cast<int64_t>(bytes * 8 * 1000000000ULL / bps);
+        int64_t now  = steadyNs();
+        int64_t next = next_ns_.load(std::memory_order_relaxed);
+        int64_t slot;
+        do {
+            // An idle pacer grants no burst credit: the slot is never in the past
+            slot = next > now ? next : now;
+        } while (!next_ns_.compare_exchange_weak(next, slot + cost, std::memory_order_relaxed));
+
+        if (slot <= now) return;
+
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        bool changed = rate_changed_.wait_for(lock, std::chrono::nanoseconds(slot - now), [&] {
+            return generation_.load(std::memory_order_relaxed) != generation;
+        });
+        if (!changed) return;
+    }
+}
+
+// ── ControlServer ────────────────────────────────────────────────────────────
+
+void ControlServer::addCommand(const std::string& command, const std::string& usage, Handler handler) {
+    std::lock_guard<std::mutex> lock(commands_mutex_);
+    commands_[command] = Command{usage, std::move(handler)};
+}
+
+void ControlServer::removeCommand(const std::string& command) {
+    std::lock_guard<std::mutex> lock(commands_mutex_);
+    commands_.erase(command);
+}
+
+std::string ControlServer::handle(const std::string& line) {
+    std::istringstream iss(line);
+    Args words;
+    for (std::string w; iss >> w;)
+        words.push_back(w);
+    if (words.empty())
+        return "ERR empty command";
+
+    // Held across the handler call, so removeCommand() cannot return while
+    // the handler of a command being removed still runs
+    std::lock_guard<std::mutex> lock(commands_mutex_);
+
+    if (words[0] == "help") {
+        std::string out = "OK help";
+        for (const auto& [name, cmd] : commands_)
+            out += "; " + cmd.usage;
+        return out;
+    }
+
+    // Longest match first: "set rate 2" before "set"
+    const Command* command  = nullptr;
+    size_t         consumed = 0;
+    for (size_t n = std::min<size_t>(2, words.size()); n > 0 && !command; --n) {
+        std::string name = words[0];
+        for (size_t i = 1; i < n; ++i) name += " " + words[i];
+        auto it = commands_.find(name);
+        if (it != commands_.end()) {
+            command  = &it->second;
+            consumed = n;
+        }
+    }
+    if (!command)
+        return "ERR unknown command '" + words[0] + "' (try help)";
+
+    try {
+        std::string reply = command->handler(Args(words.begin() + consumed, words.end()));
+        return reply.empty() ? "OK" : "OK " + reply;
+    } catch (const std::exception& e) {
+        return std::string("ERR ") + e.what();
+    }
+}
+
+bool ControlServer::start(const std::string& path) {
+    struct sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: control socket path too long: " << path << std::endl;
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    // Replace a stale socket left by a crashed run, but never a regular file
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path.c_str());
+
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0 ||
+        bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        chmod(path.c_str(), 0600) != 0 ||
+        listen(listen_fd_, 4) != 0) {
+        std::cerr << "Error: cannot listen on control socket " << path << ": "
+                  << strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+    path_ = path;
+
+    stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stop_fd_ < 0) {
+        std::cerr << "Error: eventfd: " << strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+
+    thread_ = std::thread(&ControlServer::run, this);
+    return true;
+}
+
+void ControlServer::stop() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        ssize_t rc = write(stop_fd_, &one, sizeof(one));
+        (void)rc;
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) close(listen_fd_);
+    if (stop_fd_ >= 0)   close(stop_fd_);
+    if (!path_.empty())  unlink(path_.c_str());
+    listen_fd_ = stop_fd_ = -1;
+    path_.clear();
+}
+
+void ControlServer::run() {
+    std::vector<Client> clients;
+    std::vector<struct pollfd> fds;
+
+    while (true) {
+        fds.assign({{stop_fd_, POLLIN, 0}, {listen_fd_, POLLIN, 0}});
+        for (const auto& c : clients)
+            fds.push_back({c.fd, POLLIN, 0});
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Control socket: poll: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (fds[0].revents) break;
+
+        if (fds[1].revents & POLLIN) {
+            int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) clients.push_back({fd, {}});
+        }
+
+        // Walk backwards so erasing keeps the fds[] ↔ clients[] mapping
+        for (size_t i = fds.size(); i-- > 2;) {
+            if (!fds[i].revents) continue;
+            Client& c = clients[i - 2];
+            char buf[1024];
+            ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+            bool drop = n <= 0;
+            if (!drop) {
+                c.pending.append(buf, n);
+                size_t eol;
+                while ((eol = c.pending.find('\n')) != std::string::npos) {
+                    std::string line = c.pending.substr(0, eol);
+                    c.pending.erase(0, eol + 1);
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    std::string reply = handle(line) + "\n";
+                    if (send(c.fd, reply.data(), reply.size(), MSG_NOSIGNAL) < 0) {
+                        drop = true;
+                        break;
+                    }
+                }
+                if (c.pending.size() > 4096) drop = true;
+            }
+            if (drop) {
+                close(c.fd);
+                clients.erase(clients.begin() + (i - 2));
+            }
+        }
+    }
+
+    for (const auto& c : clients)
+        close(c.fd);
+}
+
+// ── Standard commands ────────────────────────────────────────────────────────
+
+void addVerbosityCommands(ControlServer& server) {
+    server.addCommand("set verbosity", "set verbosity <0|1|2>", [](const ControlServer::Args& a) {
+        double v = parseNumber(a, "level");
+        if (v != 0 && v != 1 && v != 2)
+            throw std::runtime_error("verbosity must be 0 (quiet), 1 (normal) or 2 (verbose)");
+        verbosity.store(static_cast<int>(v), std::memory_order_relaxed);
+        return "verbosity=" + std::to_string(static_cast<int>(v));
+    });
+    server.addCommand("get verbosity", "get verbosity", [](const ControlServer::Args&) {
+        return "verbosity=" + std::to_string(verbosity.load(std::memory_order_relaxed));
+    });
+}
+
+void addSendControlCommands(ControlServer& server, SendControl& control) {
+    server.addCommand("set rate", "set rate <gbps|off>", [&control](const ControlServer::Args& a) {
+        double gbps = (a.size() == 1 && a[0] == "off") ? 0.0 : parseNumber(a, "rate in Gbps");
+        if (gbps < 0 || gbps > SendPacer::MAX_GBPS)
+            throw std::runtime_error("rate must be between 0 and " + std::to_string(static_cast<int>(SendPacer::MAX_GBPS)) +
+                                     " Gbps (or 'off')");
+        control.pacer.setRate(gbps);
+        std::ostringstream oss;
+        oss << "rate=" << (gbps > 0 ? std::to_string(gbps) : std::string("off"));
+        return oss.str();
+    });
+    server.addCommand("set prescale", "set prescale <N>", [&control](const ControlServer::Args& a) {
+        double n = parseNumber(a, "prescale factor");
+        if (n < 1 || n > UINT32_MAX || n != std::floor(n))
+            throw std::runtime_error("prescale must be a positive integer");
+        control.prescale.store(static_cast<uint32_t>(n), std::memory_order_relaxed);
+        return "prescale=" + std::to_string(static_cast<uint32_t>(n));
+    });
+    server.addCommand("get settings", "get settings", [&control](const ControlServer::Args&) {
+        double gbps = control.pacer.rate();
+        std::ostringstream oss;
+        oss << "rate=" << (gbps > 0 ? std::to_string(gbps) : std::string("off"))
+            << " prescale=" << control.prescale.load(std::memory_order_relaxed)
+            << " verbosity=" << verbosity.load(std::memory_order_relaxed);
+        return oss.str();
+    });
+}
@@ -0,0 +1,230 @@
+#include "cpu_affinity.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <cctype>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+std::string readFirstLine(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// True if name appears in line as a whole token: not preceded by a name
+// character and followed by '-', '@', ':', whitespace or end of line, so
+// eth1 does not claim eth10-TxRx-0.
+bool mentionsName(const std::string& line, const std::string& name) {
+    if (name.empty()) return false;
+    for (size_t pos = line.find(name); pos != std::string::npos; pos = line.find(name, pos + 1)) {
+        if (pos > 0) {
+            unsigned char before = line[pos - 1];
+            if (std::isalnum(before) || before == '_' || before == '.') continue;
+        }
+        size_t end = pos + name.size();
+        if (end == line.size()) return true;
+        unsigned char after = line[end];
+        if (after == '-' || after == '@' || after == ':' || std::isspace(after)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+// ── CPU lists ────────────────────────────────────────────────────────────────
+
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        try {
+            size_t dash = item.find('-');
+            int lo = std::stoi(item.substr(0, dash));
+            int hi = (dash == std::string::npos) ? lo : std::stoi(item.substr(dash + 1));
+            if (lo < 0 || hi < lo)
+                throw std::out_of_range(item);
+            for (int c = lo; c <= hi; ++c)
+                cpus.push_back(c);
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Invalid CPU list '" + list + "' (expected e.g. 0-3,8)");
+        }
+    }
+    return cpus;
+}
+
+std::string formatCpuList(std::vector<int> cpus) {
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    std::ostringstream oss;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (i > 0) oss << ",";
+        oss << cpus[i];
+        if (j > i) oss << "-" << cpus[j];
+        i = j + 1;
+    }
+    return oss.str();
+}
+
+// ── Thread and memory placement ──────────────────────────────────────────────
+
+bool pinCurrentThread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        std::cerr << "Warning: cannot pin thread to CPU " << cpu << ": " << strerror(rc) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool preferNumaNode(int node) {
+    constexpr size_t BITS = sizeof(unsigned long) * CHAR_BIT;
+    if (node < 0 || static_cast<size_t>(node) >= BITS) {
+        std::cerr << "Warning: NUMA node " << node << " out of range" << std::endl;
+        return false;
+    }
+    unsigned long mask = 1UL << node;
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, BITS) != 0) {
+        std::cerr << "Warning: cannot prefer NUMA node " << node << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ── NIC inspection ───────────────────────────────────────────────────────────
+
+bool inspectNic(const std::string& iface, NicPlacement& placement) {
+    const std::string sys = "/sys/class/net/" + iface;
+    if (access(sys.c_str(), F_OK) != 0) {
+        std::cerr << "Error: network interface " << iface << " not found" << std::endl;
+        return false;
+    }
+
+    placement = NicPlacement{};
+    placement.iface = iface;
+
+    char link[PATH_MAX];
+    ssize_t n = readlink((sys + "/device").c_str(), link, sizeof(link) - 1);
+    if (n > 0) {
+        link[n] = '\0';
+        const char* base = std::strrchr(link, '/');
+        placement.pci_addr = base ? base + 1 : link;
+    }
+
+    std::string node = readFirstLine(sys + "/device/numa_node");
+    if (!node.empty())
+        placement.numa_node = std::stoi(node);
+
+    std::string cpulist = placement.numa_node >= 0
+        ? readFirstLine("/sys/devices/system/node/node" + std::to_string(placement.numa_node) + "/cpulist")
+        : readFirstLine("/sys/devices/system/cpu/online");
+    if (!cpulist.empty())
+        placement.local_cpus = parseCpuList(cpulist);
+
+    // /proc/interrupts: header row of CPU columns, then
+    // "IRQ: count_cpu0 count_cpu1 ... chip hwirq name" per line. Driver names
+    // carry either the interface name or the PCI address (mlx5, ice, ...).
+    std::ifstream in("/proc/interrupts");
+    std::string header;
+    std::getline(in, header);
+    std::vector<int> columns;
+    {
+        std::istringstream hs(header);
+        std::string tok;
+        while (hs >> tok)
+            columns.push_back(std::stoi(tok.substr(3)));   // "CPU12" → 12
+    }
+
+    std::vector<bool> busy(columns.empty() ? 0 : *std::max_element(columns.begin(), columns.end()) + 1);
+    std::string line;
+    while (std::getline(in, line)) {
+        bool ours = mentionsName(line, iface) || mentionsName(line, placement.pci_addr);
+        if (!ours) continue;
+
+        std::istringstream ls(line);
+        std::string irq;
+        ls >> irq;
+        if (irq.empty() || !std::isdigit(static_cast<unsigned char>(irq[0]))) continue;
+        placement.irqs.push_back(std::stoi(irq));
+
+        for (int cpu : columns) {
+            unsigned long long count = 0;
+            if (!(ls >> count)) break;
+            if (count > 0) busy[cpu] = true;
+        }
+    }
+    for (size_t c = 0; c < busy.size(); ++c)
+        if (busy[c]) placement.irq_cpus.push_back(static_cast<int>(c));
+
+    return true;
+}
+
+void printPlacementSuggestion(const NicPlacement& placement,
+                              size_t recv_threads, size_t dequeue_threads) {
+    std::cout << "Interface " << placement.iface;
+    if (!placement.pci_addr.empty()) std::cout << " (" << placement.pci_addr << ")";
+    std::cout << std::endl;
+    std::cout << "  NUMA node: "
+              << (placement.numa_node >= 0 ? std::to_string(placement.numa_node) : "unknown") << std::endl;
+    std::cout << "  Local CPUs: " << formatCpuList(placement.local_cpus) << std::endl;
+    std::cout << "  NIC IRQs: " << placement.irqs.size();
+    if (!placement.irq_cpus.empty())
+        std::cout << ", serviced on CPUs " << formatCpuList(placement.irq_cpus);
+    std::cout << std::endl;
+
+    // Prefer local CPUs that take no NIC interrupts; fall back to the IRQ
+    // CPUs (still local) only when there are not enough of them.
+    std::vector<int> order;
+    for (int c : placement.local_cpus)
+        if (!std::binary_search(placement.irq_cpus.begin(), placement.irq_cpus.end(), c))
+            order.push_back(c);
+    for (int c : placement.local_cpus)
+        if (std::binary_search(placement.irq_cpus.begin(), placement.irq_cpus.end(), c))
+            order.push_back(c);
+
+    if (order.empty()) {
+        std::cout << "No CPU information available; no suggestion" << std::endl;
+        return;
+    }
+
+    std::vector<int> recv, deq;
+    for (size_t i = 0; i < recv_threads; ++i)
+        recv.push_back(order[i % order.size()]);
+    for (size_t i = 0; i < dequeue_threads; ++i)
+        deq.push_back(order[(recv_threads + i) % order.size()]);
+
+    if (recv_threads + dequeue_threads > order.size())
+        std::cout << "Warning: more threads than NUMA-local CPUs; some cores are shared" << std::endl;
+
+    std::cout << "\nSuggested receiver placement:\n  ";
+    if (placement.numa_node >= 0)
+        std::cout << "--numa-node " << placement.numa_node << " ";
+    // Keep repeats when wrapping: the list length sets the thread count.
+    auto join = [](const std::vector<int>& v) {
+        std::ostringstream oss;
+        for (size_t i = 0; i < v.size(); ++i) oss << (i ? "," : "") << v[i];
+        return oss.str();
+    };
+    std::cout << "--recv-cores " << join(recv)
+              << " --dequeue-cores " << join(deq) << std::endl;
+}
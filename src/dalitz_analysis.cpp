@@ -0,0 +1,133 @@
+#include "dalitz_analysis.hpp"
+#include <cmath>
+#include <utility>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+constexpr double M_ETA  = 0.547862;
+constexpr double M_PIPM = 0.139570;
+constexpr double M_PI0  = 0.134977;
+
+} // namespace
+
+// ── FixedHistogram ───────────────────────────────────────────────────────────
+
+FixedHistogram::FixedHistogram(std::string name, int nbins, double lo, double hi)
+    : name_(std::move(name)), nbins_(nbins), lo_(lo), hi_(hi),
+      scale_(nbins / (hi - lo)), counts_(nbins + 2, 0) {}
+
+void FixedHistogram::add(const FixedHistogram& other) {
+    for (size_t b = 0; b < counts_.size(); ++b)
+        counts_[b] += other.counts_[b];
+}
+
+uint64_t FixedHistogram::entries() const {
+    uint64_t n = 0;
+    for (auto c : counts_) n += c;
+    return n;
+}
+
+// ── DalitzHistograms ─────────────────────────────────────────────────────────
+
+DalitzHistograms::DalitzHistograms()
+    : X_pre_("h_X_pre", 100, -1.5, 1.5),   Y_pre_("h_Y_pre", 100, 0.0, 1.5),
+      im_pre_("h_im_pre", 100, 0.2, 1.0),  imgg_pre_("h_imgg_pre", 100, 0.0, 0.3),
+      X_post_("h_X_post", 100, -1.5, 1.5), Y_post_("h_Y_post", 100, 0.0, 1.5),
+      im_post_("h_im_post", 100, 0.2, 1.0), imgg_post_("h_imgg_post", 100, 0.0, 0.3) {}
+
+void DalitzHistograms::fillObservables(const TLorentzVector& pip, const TLorentzVector& pim,
+                                       const TLorentzVector& g1,  const TLorentzVector& g2,
+                                       double imass, double imassGG, bool pass) {
+    TLorentzVector pi0 = g1 + g2;
+    double s_pimpi0 = (pim + pi0).M2();
+    double s_pippi0 = (pip + pi0).M2();
+    double s_pippim = (pip + pim).M2();
+
+    const double Q        = M_ETA - 2 * M_PIPM - M_PI0;
+    const double s_centre = (M_ETA * M_ETA + 2 * M_PIPM * M_PIPM + M_PI0 * M_PI0) / 3.0;
+    const double denom    = Q * (Q + 3 * M_PI0);
+
+    double X = std::sqrt(3.0) * (s_pimpi0 - s_pippi0) / denom;
+    double Y = 3 * (s_pippim - s_centre) / denom;
+
+    X_pre_.fill(X);
+    Y_pre_.fill(Y);
+    im_pre_.fill(imass);
+    imgg_pre_.fill(imassGG);
+
+    if (pass) {
+        X_post_.fill(X);
+        Y_post_.fill(Y);
+        im_post_.fill(imass);
+        imgg_post_.fill(imassGG);
+    }
+}
+
+void DalitzHistograms::fill(const GluexEventData& event) {
+    bool pass = event.kfit_prob    >  0.0001 &&
+                event.imass_kfit   >= 0.45   && event.imass_kfit   < 0.58 &&
+                event.imassGG_kfit >  0.1    && event.imassGG_kfit < 0.15;
+    fillObservables(event.pip, event.pim, event.g1, event.g2,
+                    event.imass_kfit, event.imassGG_kfit, pass);
+}
+
+void DalitzHistograms::fill(const DalitzEventData& event) {
+    double imassGG = (event.gamma1 + event.gamma2).M();
+    double imass   = (event.pi_plus + event.pi_minus + event.gamma1 + event.gamma2).M();
+    double m_pippim = (event.pi_plus + event.pi_minus).M();
+    bool pass = m_pippim >= 0.278 && imassGG >= 0.08 && imassGG <= 0.15;
+    fillObservables(event.pi_plus, event.pi_minus, event.gamma1, event.gamma2,
+                    imass, imassGG, pass);
+}
+
+void DalitzHistograms::fillBuffer(const double* p, size_t num_doubles, bool gluex) {
+    if (gluex) {
+        for (size_t i = 0; i + GluexEventData::NUM_DOUBLES <= num_doubles; i += GluexEventData::NUM_DOUBLES)
+            fill(GluexEventData::fromBuffer(p + i));
+    } else {
+        for (size_t i = 0; i + DalitzEventData::NUM_DOUBLES <= num_doubles; i += DalitzEventData::NUM_DOUBLES)
+            fill(DalitzEventData::fromBuffer(p + i));
+    }
+}
+
+void DalitzHistograms::add(const DalitzHistograms& other) {
+    X_pre_.add(other.X_pre_);     Y_pre_.add(other.Y_pre_);
+    im_pre_.add(other.im_pre_);   imgg_pre_.add(other.imgg_pre_);
+    X_post_.add(other.X_post_);   Y_post_.add(other.Y_post_);
+    im_post_.add(other.im_post_); imgg_post_.add(other.imgg_post_);
+}
+
+std::vector<const FixedHistogram*> DalitzHistograms::all() const {
+    return {&X_pre_, &Y_pre_, &im_pre_, &imgg_pre_,
+            &X_post_, &Y_post_, &im_post_, &imgg_post_};
+}
+
+// ── compareHistograms() ──────────────────────────────────────────────────────
+
+size_t compareHistograms(const DalitzHistograms& source, const DalitzHistograms& received,
+                         std::ostream& out, size_t max_bins_reported) {
+    auto src = source.all();
+    auto rcv = received.all();
+    size_t differing = 0;
+
+    for (size_t i = 0; i < src.size(); ++i) {
+        const FixedHistogram& a = *src[i];
+        const FixedHistogram& b = *rcv[i];
+        size_t bad_bins = 0;
+        for (int bin = 0; bin <= a.nbins() + 1; ++bin) {
+            if (a.count(bin) == b.count(bin)) continue;
+            if (bad_bins++ < max_bins_reported)
+                out << "  BIN MISMATCH " << a.name() << " bin " << bin
+                    << ": source=" << a.count(bin) << " received=" << b.count(bin) << "\n";
+        }
+        if (bad_bins > max_bins_reported)
+            out << "  ... " << (bad_bins - max_bins_reported) << " more mismatching bins\n";
+
+        out << a.name() << ": entries source=" << a.entries()
+            << " received=" << b.entries() << "  -> " << (bad_bins ? "DIFFER" : "OK") << "\n";
+        if (bad_bins) differing++;
+    }
+    return differing;
+}
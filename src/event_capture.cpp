@@ -0,0 +1,305 @@
+#include "event_capture.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+// Write the whole iovec array, resuming after short writes.
+bool writeFully(int fd, struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        while (iovcnt > 0 && static_cast<size_t>(n) >= iov->iov_len) {
+            n -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + n;
+            iov->iov_len -= n;
+        }
+    }
+    return true;
+}
+
+// Free callback for replayed records: the payload lives in the mapped
+// capture, so only the outstanding count is released.
+void releaseReplayed(boost::any a) {
+    boost::any_cast<std::atomic<size_t>*>(a)->fetch_sub(1);
+}
+
+} // namespace
+
+// ── CaptureWriter ────────────────────────────────────────────────────────────
+
+bool CaptureWriter::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Error creating capture " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    path_  = path;
+    start_ = clock::now();
+
+    CaptureFileHeader hdr{};
+    std::memcpy(hdr.magic, CAPTURE_MAGIC, sizeof(hdr.magic));
+    hdr.version       = CAPTURE_VERSION;
+    hdr.start_unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    struct iovec iov{&hdr, sizeof(hdr)};
+    if (!writeFully(fd_, &iov, 1)) {
+        std::cerr << "Error writing capture header " << path << ": " << strerror(errno) << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    offset_ = sizeof(hdr);
+    return true;
+}
+
+bool CaptureWriter::append(clock::time_point recv_time, uint64_t event_num, uint16_t data_id,
+                           const uint8_t* data, size_t size) {
+    CaptureRecordHeader rec{};
+    rec.event_num = event_num;
+    rec.size      = size;
+    rec.data_id   = data_id;
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (fd_ < 0) return false;
+    // Several dequeue threads may race between recvEvent and append; clamp so
+    // timestamps stay monotonic in file order.
+    auto since = recv_time > start_ ? recv_time - start_ : clock::duration::zero();
+    rec.recv_ns = std::max<uint64_t>(last_ns_,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(since).count());
+    last_ns_ = rec.recv_ns;
+
+    struct iovec iov[2] = {{&rec, sizeof(rec)}, {const_cast<uint8_t*>(data), size}};
+    if (!writeFully(fd_, iov, 2)) {
+        std::cerr << "Error writing capture " << path_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    index_.push_back(offset_);
+    offset_ += sizeof(rec) + size;
+    return true;
+}
+
+bool CaptureWriter::close() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (fd_ < 0) return true;
+
+    CaptureFileTrailer trailer{};
+    trailer.index_offset = offset_;
+    trailer.record_count = index_.size();
+    std::memcpy(trailer.magic, CAPTURE_IDX_MAGIC, sizeof(trailer.magic));
+
+    struct iovec iov[2] = {{index_.data(), index_.size() * sizeof(uint64_t)},
+                           {&trailer, sizeof(trailer)}};
+    bool ok = writeFully(fd_, iov, 2);
+    if (!ok)
+        std::cerr << "Error writing capture index " << path_ << ": " << strerror(errno) << std::endl;
+    ::close(fd_);
+    fd_ = -1;
+    return ok;
+}
+
+uint64_t CaptureWriter::recordCount() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return index_.size();
+}
+
+// ── CaptureReader ────────────────────────────────────────────────────────────
+
+bool CaptureReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening capture " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(CaptureFileHeader)) {
+        std::cerr << "Error: " << path << " is not a capture file" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    len_ = st.st_size;
+    void* mapped = mmap(nullptr, len_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error memory-mapping capture " << path << ": " << strerror(errno) << std::endl;
+        len_ = 0;
+        return false;
+    }
+    base_ = static_cast<const uint8_t*>(mapped);
+    madvise(mapped, len_, MADV_SEQUENTIAL);
+
+    CaptureFileHeader hdr;
+    std::memcpy(&hdr, base_, sizeof(hdr));
+    if (std::memcmp(hdr.magic, CAPTURE_MAGIC, sizeof(hdr.magic)) != 0 || hdr.version != CAPTURE_VERSION) {
+        std::cerr << "Error: " << path << " is not a version " << CAPTURE_VERSION << " capture file" << std::endl;
+        close();
+        return false;
+    }
+    start_unix_ns_ = hdr.start_unix_ns;
+
+    if (len_ >= sizeof(CaptureFileHeader) + sizeof(CaptureFileTrailer)) {
+        CaptureFileTrailer trailer;
+        std::memcpy(&trailer, base_ + len_ - sizeof(trailer), sizeof(trailer));
+        if (std::memcmp(trailer.magic, CAPTURE_IDX_MAGIC, sizeof(trailer.magic)) == 0) {
+            if (loadIndex(trailer))
+                return true;
+            std::cerr << "Warning: capture " << path << " has a corrupt index; rescanning records" << std::endl;
+            index_.clear();
+        }
+    }
+
+    recovered_ = true;
+    if (!scanRecords()) {
+        std::cerr << "Warning: capture " << path << " is truncated; recovered "
+                  << index_.size() << " complete records" << std::endl;
+    }
+    return true;
+}
+
+bool CaptureReader::loadIndex(const CaptureFileTrailer& trailer) {
+    // Records lie between the file header and the index, the index runs up
+    // to the trailer; check sizes before multiplying so nothing overflows.
+    const uint64_t index_end = len_ - sizeof(trailer);
+    if (trailer.index_offset < sizeof(CaptureFileHeader) || trailer.index_offset > index_end ||
+        trailer.record_count != (index_end - trailer.index_offset) / sizeof(uint64_t) ||
+        (index_end - trailer.index_offset) % sizeof(uint64_t) != 0)
+        return false;
+
+    index_.resize(trailer.record_count);
+    std::memcpy(index_.data(), base_ + trailer.index_offset,
+                trailer.record_count * sizeof(uint64_t));
+    for (uint64_t off : index_) {
+        if (off < sizeof(CaptureFileHeader) || off > trailer.index_offset ||
+            trailer.index_offset - off < sizeof(CaptureRecordHeader))
+            return false;
+        CaptureRecordHeader rec;
+        std::memcpy(&rec, base_ + off, sizeof(rec));
+        if (rec.size > trailer.index_offset - off - sizeof(rec))
+            return false;
+    }
+    return true;
+}
+
+bool CaptureReader::scanRecords() {
+    uint64_t off = sizeof(CaptureFileHeader);
+    while (off + sizeof(CaptureRecordHeader) <= len_) {
+        CaptureRecordHeader rec;
+        std::memcpy(&rec, base_ + off, sizeof(rec));
+        if (rec.size > len_ - off - sizeof(rec))
+            return false;
+        index_.push_back(off);
+        off += sizeof(rec) + rec.size;
+    }
+    return off == len_;
+}
+
+void CaptureReader::close() {
+    if (base_)
+        munmap(const_cast<uint8_t*>(base_), len_);
+    base_      = nullptr;
+    len_       = 0;
+    recovered_ = false;
+    index_.clear();
+}
+
+CaptureRecord CaptureReader::record(size_t i) const {
+    CaptureRecordHeader rec;
+    std::memcpy(&rec, base_ + index_[i], sizeof(rec));
+    return {rec.recv_ns, rec.event_num, rec.data_id, static_cast<size_t>(rec.size),
+            base_ + index_[i] + sizeof(rec)};
+}
+
+// ── replayCapture() ──────────────────────────────────────────────────────────
+
+bool replayCapture(const std::string& path, double speedup, e2sar::Segmenter& segmenter) {
+    CaptureReader reader;
+    if (!reader.open(path))
+        return false;
+
+    std::cout << "\nReplaying " << reader.size() << " events from " << path;
+    if (speedup > 0) std::cout << " (speedup " << speedup << "x)";
+    else             std::cout << " (unpaced)";
+    std::cout << std::endl;
+
+    if (reader.size() == 0)
+        return true;
+
+    std::atomic<size_t> outstanding{0};
+    size_t   bytes_sent = 0;
+    int64_t  max_late_us = 0;
+    const uint64_t t0 = reader.record(0).recv_ns;
+    const auto start  = std::chrono::steady_clock::now();
+    const int MAX_RETRIES = 10000;
+
+    for (size_t i = 0; i < reader.size(); ++i) {
+        CaptureRecord rec = reader.record(i);
+
+        if (speedup > 0) {
+            auto target = start + std::chrono::nanoseconds(
+                static_cast<int64_t>((rec.recv_ns - t0) / speedup));
+            auto now = std::chrono::steady_clock::now();
+            if (now < target)
+                std::this_thread::sleep_until(target);
+            else
+                max_late_us = std::max<int64_t>(max_late_us,
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - target).count());
+        }
+
+        outstanding.fetch_add(1);
+        int retry_count = 0;
+        while (true) {
+            auto send_result = segmenter.addToSendQueue(const_cast<uint8_t*>(rec.data), rec.size,
+                rec.event_num, rec.data_id, 0, &releaseReplayed, &outstanding);
+            if (!send_result.has_error())
+                break;
+            if (send_result.error().code() == e2sar::E2SARErrorc::MemoryError &&
+                ++retry_count < MAX_RETRIES) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            std::cerr << "Replay send error at record " << i << " (event " << rec.event_num
+                      << "): " << send_result.error().message() << std::endl;
+            outstanding.fetch_sub(1);
+            // Records already queued still reference the mapping.
+            while (outstanding.load() > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return false;
+        }
+        bytes_sent += rec.size;
+    }
+
+    while (outstanding.load() > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    double recorded_s = (reader.record(reader.size() - 1).recv_ns - t0) / 1e9;
+
+    std::cout << "Replay complete: " << reader.size() << " events, "
+              << (bytes_sent / (1024.0 * 1024.0)) << " MB in " << (elapsed / 1e6) << " s"
+              << " (recorded span " << recorded_s << " s)" << std::endl;
+    if (speedup > 0)
+        std::cout << "  Max schedule slip: " << max_late_us << " us" << std::endl;
+    return true;
+}
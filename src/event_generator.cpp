@@ -0,0 +1,224 @@
+#include "event_generator.hpp"
+#include <algorithm>
+#include <cmath>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+constexpr double M_PROTON = 0.938272;
+constexpr double M_ETA    = 0.547862;
+constexpr double M_PIPM   = 0.139570;
+constexpr double M_PI0    = 0.134977;
+
+// η → π+π−π0 Dalitz parameters (KLOE-2 2016)
+constexpr double DALITZ_A = -1.095;
+constexpr double DALITZ_B =  0.145;
+constexpr double DALITZ_D =  0.081;
+constexpr double DALITZ_F =  0.141;
+// Upper bound of |A|² over the Dalitz plot, reached at Y = −1
+constexpr double DALITZ_MAX = 2.2;
+
+// Resolutions at resolution = 1: tracking σp/p and angle, calorimeter
+// stochastic and constant terms of σE/E and angle.
+constexpr double SIGMA_P_REL    = 0.015;
+constexpr double SIGMA_TRACK    = 0.001;
+constexpr double SIGMA_E_STOCH  = 0.055;
+constexpr double SIGMA_E_CONST  = 0.02;
+constexpr double SIGMA_SHOWER   = 0.004;
+
+// Non-resonant events: mass window of the π+π−γγ system and the share of
+// them whose photon pair comes from a π0.
+constexpr double BG_MASS_LO  = 0.45;   // above the π+π−π0 threshold
+constexpr double BG_MASS_HI  = 1.0;
+constexpr double BG_PI0_FRAC = 0.5;
+
+double momentum(double e, double m) {
+    return std::sqrt(std::max(0.0, e * e - m * m));
+}
+
+// Keep smeared spherical coordinates in range
+void foldAngles(double& theta, double& phi) {
+    if (theta < 0)      { theta = -theta;              phi += M_PI; }
+    if (theta > M_PI)   { theta = 2 * M_PI - theta;    phi += M_PI; }
+    phi = std::remainder(phi, 2 * M_PI);
+}
+
+} // namespace
+
+// ── PiPiGGGenerator ──────────────────────────────────────────────────────────
+
+PiPiGGGenerator::PiPiGGGenerator(uint64_t seed, const GeneratorOptions& opts)
+    : rng_(seed), opts_(opts) {}
+
+TVector3 PiPiGGGenerator::isotropic(double mag) {
+    TVector3 v;
+    v.SetMagThetaPhi(mag, std::acos(uniform(-1.0, 1.0)), uniform(-M_PI, M_PI));
+    return v;
+}
+
+TLorentzVector PiPiGGGenerator::produce(double mass) {
+    // Beam photon from the coherent peak, kept above threshold
+    const double threshold = ((mass + M_PROTON) * (mass + M_PROTON) - M_PROTON * M_PROTON) / (2 * M_PROTON);
+    double e_beam;
+    do {
+        e_beam = opts_.beam_energy + gauss(opts_.beam_spread);
+    } while (e_beam <= threshold * 1.01);
+
+    // Centre-of-mass kinematics of γp → X p
+    const double s     = M_PROTON * M_PROTON + 2 * M_PROTON * e_beam;
+    const double w     = std::sqrt(s);
+    const double k_cm  = (s - M_PROTON * M_PROTON) / (2 * w);
+    const double e_cm  = (s + mass * mass - M_PROTON * M_PROTON) / (2 * w);
+    const double p_cm  = momentum(e_cm, mass);
+
+    // |t| from exp(−b|t|) between its kinematic limits
+    const double t_min = 2 * k_cm * (e_cm - p_cm) - mass * mass;
+    const double t_max = 2 * k_cm * (e_cm + p_cm) - mass * mass;
+    double t = t_min;
+    if (opts_.t_slope > 0)
+        t -= std::log(1 - uniform() * (1 - std::exp(-opts_.t_slope * (t_max - t_min)))) / opts_.t_slope;
+    else
+        t = uniform(t_min, t_max);
+    double cos_theta = std::clamp((mass * mass + t - 2 * k_cm * e_cm) / (-2 * k_cm * p_cm), -1.0, 1.0);
+
+    TVector3 p;
+    p.SetMagThetaPhi(p_cm, std::acos(cos_theta), uniform(-M_PI, M_PI));
+    TLorentzVector x;
+    x.SetVectM(p, mass);
+    x.Boost(0, 0, e_beam / (e_beam + M_PROTON));
+    return x;
+}
+
+void PiPiGGGenerator::twoBody(const TLorentzVector& parent, double m1, double m2,
+                              TLorentzVector& d1, TLorentzVector& d2) {
+    const double m = parent.M();
+    const double e = (m * m + m1 * m1 - m2 * m2) / (2 * m);
+    TVector3 p = isotropic(momentum(e, m1));
+    d1.SetVectM(p, m1);
+    d2.SetVectM(-p, m2);
+    d1.Boost(parent.BoostVector());
+    d2.Boost(parent.BoostVector());
+}
+
+void PiPiGGGenerator::etaDecay(TLorentzVector& pip, TLorentzVector& pim, TLorentzVector& pi0) {
+    const double q     = M_ETA - 2 * M_PIPM - M_PI0;
+    const double s_lo  = (M_PIPM + M_PI0) * (M_PIPM + M_PI0);
+    const double s_hi  = (M_ETA - M_PIPM) * (M_ETA - M_PIPM);
+
+    for (;;) {
+        // Flat in (s+0, s−0) is flat in phase space
+        double s_pip_pi0 = uniform(s_lo, s_hi);
+        double s_pim_pi0 = uniform(s_lo, s_hi);
+        double e_pip = (M_ETA * M_ETA + M_PIPM * M_PIPM - s_pim_pi0) / (2 * M_ETA);
+        double e_pim = (M_ETA * M_ETA + M_PIPM * M_PIPM - s_pip_pi0) / (2 * M_ETA);
+        double e_pi0 = M_ETA - e_pip - e_pim;
+        if (e_pip < M_PIPM || e_pim < M_PIPM || e_pi0 < M_PI0)
+            continue;
+
+        double p_pip = momentum(e_pip, M_PIPM);
+        double p_pim = momentum(e_pim, M_PIPM);
+        double p_pi0 = momentum(e_pi0, M_PI0);
+        if (p_pip <= 0 || p_pim <= 0)
+            continue;
+        double cos_open = (p_pi0 * p_pi0 - p_pip * p_pip - p_pim * p_pim) / (2 * p_pip * p_pim);
+        if (cos_open < -1 || cos_open > 1)
+            continue;   // outside the Dalitz boundary
+
+        double x = std::sqrt(3.0) * ((e_pip - M_PIPM) - (e_pim - M_PIPM)) / q;
+        double y = 3 * (e_pi0 - M_PI0) / q - 1;
+        double weight = 1 + DALITZ_A * y + DALITZ_B * y * y + DALITZ_D * x * x + DALITZ_F * y * y * y;
+        if (uniform(0.0, DALITZ_MAX) > weight)
+            continue;
+
+        // Orient the decay plane at random
+        TVector3 n_pip = isotropic(1.0);
+        TVector3 n_perp = n_pip.Orthogonal().Unit();
+        n_perp.Rotate(uniform(-M_PI, M_PI), n_pip);
+        TVector3 v_pip = p_pip * n_pip;
+        TVector3 v_pim = p_pim * (cos_open * n_pip + std::sqrt(1 - cos_open * cos_open) * n_perp);
+        pip.SetVectM(v_pip, M_PIPM);
+        pim.SetVectM(v_pim, M_PIPM);
+        pi0.SetVectM(-(v_pip + v_pim), M_PI0);
+        return;
+    }
+}
+
+void PiPiGGGenerator::smearCharged(TLorentzVector& p) {
+    const double r = opts_.resolution;
+    double mag   = p.P() * (1 + gauss(SIGMA_P_REL * r));
+    double theta = p.Theta() + gauss(SIGMA_TRACK * r);
+    double phi   = p.Phi() + gauss(SIGMA_TRACK * r);
+    foldAngles(theta, phi);
+    p = createLorentzVector(std::abs(mag), theta, phi, M_PIPM);
+}
+
+void PiPiGGGenerator::smearPhoton(TLorentzVector& p) {
+    const double r = opts_.resolution;
+    double e     = p.E();
+    double sigma = std::hypot(SIGMA_E_STOCH / std::sqrt(std::max(e, 1e-3)), SIGMA_E_CONST) * r;
+    double mag   = e * (1 + gauss(sigma));
+    double theta = p.Theta() + gauss(SIGMA_SHOWER * r);
+    double phi   = p.Phi() + gauss(SIGMA_SHOWER * r);
+    foldAngles(theta, phi);
+    p = createLorentzVector(std::abs(mag), theta, phi, 0.0);
+}
+
+DalitzEventData PiPiGGGenerator::nextDalitz() {
+    TLorentzVector eta = produce(M_ETA);
+    TLorentzVector pip, pim, pi0;
+    etaDecay(pip, pim, pi0);
+    pip.Boost(eta.BoostVector());
+    pim.Boost(eta.BoostVector());
+    pi0.Boost(eta.BoostVector());
+
+    DalitzEventData ev;
+    ev.pi_plus  = pip;
+    ev.pi_minus = pim;
+    twoBody(pi0, 0.0, 0.0, ev.gamma1, ev.gamma2);
+    smearCharged(ev.pi_plus);
+    smearCharged(ev.pi_minus);
+    smearPhoton(ev.gamma1);
+    smearPhoton(ev.gamma2);
+    return ev;
+}
+
+GluexEventData PiPiGGGenerator::next() {
+    GluexEventData ev;
+    if (uniform() >= opts_.background_fraction) {
+        DalitzEventData sig = nextDalitz();
+        ev.pip = sig.pi_plus;
+        ev.pim = sig.pi_minus;
+        ev.g1  = sig.gamma1;
+        ev.g2  = sig.gamma2;
+        ev.kfit_prob = uniform();                       // flat for a correct hypothesis
+    } else {
+        // X → π+ (π− (γγ)) through phase space, the γγ pair from a π0 or a continuum
+        double m_x  = uniform(BG_MASS_LO, BG_MASS_HI);
+        double m_gg = uniform() < BG_PI0_FRAC ? M_PI0 : uniform(0.01, m_x - 2 * M_PIPM);
+        double m_r  = uniform(M_PIPM + m_gg, m_x - M_PIPM);
+        TLorentzVector x = produce(m_x);
+        TLorentzVector r, gg;
+        twoBody(x, M_PIPM, m_r, ev.pip, r);
+        twoBody(r, M_PIPM, m_gg, ev.pim, gg);
+        twoBody(gg, 0.0, 0.0, ev.g1, ev.g2);
+        smearCharged(ev.pip);
+        smearCharged(ev.pim);
+        smearPhoton(ev.g1);
+        smearPhoton(ev.g2);
+        ev.kfit_prob = std::pow(10.0, -uniform(0.0, 8.0));   // mostly poor fits
+    }
+    ev.imass_kfit   = (ev.pip + ev.pim + ev.g1 + ev.g2).M();
+    ev.imassGG_kfit = (ev.g1 + ev.g2).M();
+    return ev;
+}
+
+// ── Seeding ──────────────────────────────────────────────────────────────────
+
+uint64_t streamSeed(uint64_t seed, uint64_t index) {
+    // splitmix64 of the combined value
+    uint64_t z = seed + (index + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
@@ -0,0 +1,154 @@
+#include "event_io.hpp"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ── Filenames ────────────────────────────────────────────────────────────────
+
+namespace {
+
+// Width of the placeholder spec between "{:" and "}", e.g. "08d" → 8.
+// False unless it is digits followed by 'd'.
+bool parseWidth(const std::string& spec, int& width) {
+    width = 0;
+    if (spec.empty() || spec.back() != 'd') return false;
+    const char* first = spec.data();
+    const char* last  = spec.data() + spec.size() - 1;
+    if (first == last) return true;
+    if (*first < '0' || *first > '9') return false;   // from_chars takes a sign
+    auto [ptr, ec] = std::from_chars(first, last, width);
+    if (ec != std::errc() || ptr != last) {
+        width = 0;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool validFilenamePattern(const std::string& pattern) {
+    size_t pos = 0;
+    while (true) {
+        size_t start = pattern.find("{:", pos);
+        if (start == std::string::npos) return true;
+        size_t end = pattern.find("}", start);
+        if (end == std::string::npos) return true;   // kept literally
+        int width;
+        if (!parseWidth(pattern.substr(start + 2, end - start - 2), width))
+            return false;
+        pos = end + 1;
+    }
+}
+
+std::string formatFilename(const std::string& pattern, uint64_t event_num) {
+    std::ostringstream oss;
+    size_t pos = 0;
+
+    while (pos < pattern.size()) {
+        size_t start = pattern.find("{:", pos);
+        if (start == std::string::npos) {
+            oss << pattern.substr(pos);
+            break;
+        }
+
+        oss << pattern.substr(pos, start - pos);
+
+        size_t end = pattern.find("}", start);
+        if (end == std::string::npos) {
+            oss << pattern.substr(start);
+            break;
+        }
+
+        // Width digits before the trailing 'd', e.g. "08d"; an invalid spec
+        // (see validFilenamePattern) formats with no padding
+        int width;
+        parseWidth(pattern.substr(start + 2, end - start - 2), width);
+
+        oss << std::setfill('0') << std::setw(width) << event_num;
+        pos = end + 1;
+    }
+
+    return oss.str();
+}
+
+// ── Writing ──────────────────────────────────────────────────────────────────
+
+bool writeMemoryMappedFile(const std::string& filename, const uint8_t* data, size_t size) {
+    int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error creating file " << filename << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (ftruncate(fd, size) < 0) {
+        std::cerr << "Error resizing file " << filename << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error memory-mapping file " << filename << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    memcpy(mapped, data, size);
+
+    if (msync(mapped, size, MS_SYNC) < 0) {
+        std::cerr << "Warning: msync failed for " << filename << ": " << strerror(errno) << std::endl;
+    }
+
+    munmap(mapped, size);
+    close(fd);
+    return true;
+}
+
+// ── MappedFile ───────────────────────────────────────────────────────────────
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening file " << filename << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        std::cerr << "Error reading size of " << filename << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error memory-mapping file " << filename << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const uint8_t*>(mapped);
+    size_ = st.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_)
+        munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
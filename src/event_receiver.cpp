@@ -0,0 +1,436 @@
+#include "event_receiver.hpp"
+#include "event_io.hpp"
+#include "stats_series.hpp"
+#include "stats_json.hpp"
+#include "cpu_affinity.hpp"
+#include "alloc_stats.hpp"
+#include "async_log.hpp"
+#include "probes.hpp"
+#include "trace.hpp"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+// Counters sampled into --stats-csv, in column order of sampleCounters().
+const std::vector<std::string> SERIES_COLUMNS = {
+    "events_received", "events_written", "write_errors", "bytes_received", "data_id_mismatches",
+    "reas_packets", "reas_bytes", "reas_event_success", "reas_reassembly_loss",
+    "reas_enqueue_loss", "reas_data_errors", "reas_grpc_errors"
+};
+
+// Relaxed loads of our atomics plus getStats(), which copies the reassembler's
+// own atomic counters; nothing here locks against the dequeue threads.
+std::vector<uint64_t> sampleCounters(e2sar::Reassembler& reassembler,
+                                     const ReceiveStats& stats) {
+    auto r = reassembler.getStats();
+    return {
+        stats.events_received.load(std::memory_order_relaxed),
+        stats.events_written.load(std::memory_order_relaxed),
+        stats.write_errors.load(std::memory_order_relaxed),
+        stats.total_bytes.load(std::memory_order_relaxed),
+        stats.data_id_mismatches.load(std::memory_order_relaxed),
+        r.totalPackets, r.totalBytes, r.eventSuccess, r.reassemblyLoss,
+        r.enqueueLoss, r.dataErrCnt, r.grpcErrCnt
+    };
+}
+
+// One "receiver" record (--stats-json, control socket "stats"): our
+// counters, the overall rate and the reassembler's own statistics.
+void buildReceiverRecord(JsonWriter& json, e2sar::Reassembler& reassembler,
+                         const ReceiveStats& stats,
+                         std::chrono::steady_clock::time_point start, bool final,
+                         size_t lost_events = 0) {
+    double   elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t bytes   = stats.total_bytes.load(std::memory_order_relaxed);
+    auto     r       = reassembler.getStats();
+
+    beginStatsRecord(json, "receiver", final, start);
+    json.field("events_received", stats.events_received.load(std::memory_order_relaxed))
+        .field("events_written", stats.events_written.load(std::memory_order_relaxed))
+        .field("write_errors", stats.write_errors.load(std::memory_order_relaxed))
+        .field("data_id_mismatches", stats.data_id_mismatches.load(std::memory_order_relaxed))
+        .field("bytes", bytes)
+        .field("gbps", elapsed > 0 ? bytes * 8.0 / elapsed / 1e9 : 0.0);
+    json.beginObject("reassembler")
+        .field("total_packets", static_cast<uint64_t>(r.totalPackets))
+        .field("total_bytes", static_cast<uint64_t>(r.totalBytes))
+        .field("event_success", static_cast<uint64_t>(r.eventSuccess))
+        .field("reassembly_loss", static_cast<uint64_t>(r.reassemblyLoss))
+        .field("enqueue_loss", static_cast<uint64_t>(r.enqueueLoss))
+        .field("data_errors", static_cast<uint64_t>(r.dataErrCnt))
+        .field("grpc_errors", static_cast<uint64_t>(r.grpcErrCnt))
+        .endObject();
+    LatencyDistribution latency = stats.writeLatency();
+    json.beginObject("latency_ns")
+        .beginObject("recv_to_write")
+        .field("count", latency.count())
+        .field("p50", latency.percentile(0.50))
+        .field("p99", latency.percentile(0.99))
+        .field("p99_9", latency.percentile(0.999))
+        .field("max", latency.max())
+        .endObject()
+        .endObject();
+    if (alloc_accounting.load(std::memory_order_relaxed)) {
+        json.beginObject("memory")
+            .field("rss", currentRssBytes())
+            .field("peak_rss", peakRssBytes());
+        event_memory.addTo(json, "events");
+        json.endObject();
+    }
+    if (final)
+        json.field("lost_events", static_cast<uint64_t>(lost_events));
+    json.endObject();
+}
+
+void writeReceiverRecord(JsonLinesFile& out, e2sar::Reassembler& reassembler,
+                         const ReceiveStats& stats,
+                         std::chrono::steady_clock::time_point start, bool final,
+                         size_t lost_events = 0) {
+    JsonWriter json;
+    buildReceiverRecord(json, reassembler, stats, start, final, lost_events);
+    out.write(json);
+}
+
+// Prometheus collector for --metrics-addr. Events the reassembler completed
+// but no dequeue thread has taken yet approximate its output queue depth.
+void writeReceiverMetrics(PromText& out, e2sar::Reassembler& reassembler,
+                          const ReceiveStats& stats) {
+    auto load = [](const std::atomic<uint64_t>& a) { return a.load(std::memory_order_relaxed); };
+    auto counter = [&](const char* name, const char* help, uint64_t value) {
+        out.family(name, "counter", help);
+        out.sample(name, value);
+    };
+
+    uint64_t dequeued = load(stats.events_received) + load(stats.data_id_mismatches);
+    counter("e2sar_receiver_events_total", "Reassembled events dequeued with the expected data ID",
+            load(stats.events_received));
+    counter("e2sar_receiver_events_written_total", "Events written to file or capture",
+            load(stats.events_written));
+    counter("e2sar_receiver_write_errors_total", "Events that failed to write", load(stats.write_errors));
+    counter("e2sar_receiver_data_id_mismatches_total", "Events dropped for an unexpected data ID",
+            load(stats.data_id_mismatches));
+    counter("e2sar_receiver_bytes_total", "Bytes of dequeued events", load(stats.total_bytes));
+
+    out.family("e2sar_receiver_event_bytes", "histogram", "Size of dequeued events");
+    out.histogram("e2sar_receiver_event_bytes", stats.event_bytes, 1.0);
+
+    static const std::vector<uint64_t> write_bounds = {10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+    out.family("e2sar_receiver_write_seconds", "histogram", "Time from recvEvent return to event written");
+    out.histogram("e2sar_receiver_write_seconds", stats.writeLatency(), write_bounds, 1e-9);
+
+    auto r = reassembler.getStats();
+    counter("e2sar_reassembler_packets_total", "Packets received", r.totalPackets);
+    counter("e2sar_reassembler_bytes_total", "Bytes received", r.totalBytes);
+    counter("e2sar_reassembler_events_total", "Events reassembled", r.eventSuccess);
+    counter("e2sar_reassembler_reassembly_loss_total", "Events lost to reassembly timeout", r.reassemblyLoss);
+    counter("e2sar_reassembler_enqueue_loss_total", "Events lost to a full output queue", r.enqueueLoss);
+    counter("e2sar_reassembler_data_errors_total", "Data errors", r.dataErrCnt);
+    counter("e2sar_reassembler_grpc_errors_total", "Control-plane gRPC errors", r.grpcErrCnt);
+
+    out.family("e2sar_reassembler_queue_depth", "gauge", "Reassembled events waiting to be dequeued");
+    out.sample("e2sar_reassembler_queue_depth",
+               static_cast<uint64_t>(r.eventSuccess > dequeued ? r.eventSuccess - dequeued : 0));
+
+    if (alloc_accounting.load(std::memory_order_relaxed)) {
+        event_memory.addTo(out, "e2sar_receiver_event_buffer", "event buffers");
+        out.family("e2sar_process_resident_bytes", "gauge", "Resident set size");
+        out.sample("e2sar_process_resident_bytes", currentRssBytes());
+    }
+}
+
+// Upper bound on how long a dequeue thread can sit in recvEvent() after stop
+// is triggered; E2SAR offers no way to interrupt the wait early.
+constexpr uint64_t DEQUEUE_WAIT_MS = 50;
+
+void dequeueLoop(e2sar::Reassembler& reassembler, const CommandLineArgs& args,
+                 CaptureWriter* capture, const StopSignal& stop, ReceiveStats& stats,
+                 LatencyHistogram& write_latency, size_t index, int cpu) {
+    if (cpu >= 0)
+        pinCurrentThread(cpu);
+    trace::nameThread("dequeue " + std::to_string(index));
+
+    PerfCounterGroup perf;
+    const bool perf_on = args.perf_counters && perf.open();
+    PerfReading perf_before, perf_received, perf_written;
+
+    uint8_t* event_buffer = nullptr;
+    size_t event_size;
+    e2sar::EventNum_t event_num;
+    uint16_t data_id;
+    // Counter reads are syscalls: sample every perf_sample-th event, and only
+    // right after an event, so an idle wait never starts a sample
+    uint64_t events_seen = 0;
+    bool     got_event   = true;
+
+    while (!stop.triggered()) {
+        bool sample = perf_on && got_event && events_seen % args.perf_sample == 0 &&
+                      perf.read(perf_before);
+        auto result = reassembler.recvEvent(&event_buffer, &event_size,
+                                            &event_num, &data_id, DEQUEUE_WAIT_MS);
+        got_event = !result.has_error() && result.value() != -1;
+        if (!got_event) continue;
+        events_seen++;
+        event_memory.allocated(event_size);
+        sample = sample && perf.read(perf_received);
+        if (sample)
+            stats.perf_dequeue.add(perf, perf_before, perf_received);
+        auto dequeued = std::chrono::steady_clock::now();
+        E2SAR_PROBE3(recv_event, event_num, event_size, data_id);
+
+        if (data_id != args.data_id) {
+            stats.data_id_mismatches++;
+            logWarning("Warning: received data_id=" + std::to_string(data_id) +
+                       " expected=" + std::to_string(args.data_id) +
+                       " event_num=" + std::to_string(event_num));
+            event_memory.freed(event_size);
+            delete[] event_buffer;
+            event_buffer = nullptr;
+            continue;
+        }
+
+        stats.events_received++;
+        stats.total_bytes += event_size;
+        stats.event_bytes.observe(event_size);
+
+        E2SAR_PROBE3(write_start, event_num, event_size, data_id);
+        bool written = capture
+            ? capture->append(dequeued, event_num, data_id,
+                              event_buffer, event_size)
+            : writeMemoryMappedFile(formatFilename(args.output_pattern, event_num),
+                                    event_buffer, event_size);
+
+        auto done = std::chrono::steady_clock::now();
+        if (sample && perf.read(perf_written))
+            stats.perf_write.add(perf, perf_received, perf_written);
+        E2SAR_PROBE4(write_end, event_num, event_size, data_id, written);
+        write_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            done - dequeued).count());
+        if (trace::enabled())
+            trace::record("write", trace::nanos(dequeued), trace::nanos(done), "bytes", event_size);
+
+        if (written) {
+            stats.events_written++;
+        } else {
+            stats.write_errors++;
+            logError("Failed to write event " + std::to_string(event_num));
+        }
+
+        event_memory.freed(event_size);
+        delete[] event_buffer;
+        event_buffer = nullptr;
+    }
+}
+
+} // namespace
+
+// ── StopSignal ───────────────────────────────────────────────────────────────
+
+StopSignal::StopSignal() {
+    fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd_ < 0)
+        throw std::runtime_error(std::string("eventfd: ") + strerror(errno));
+}
+
+StopSignal::~StopSignal() {
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+void StopSignal::trigger() noexcept {
+    stopped_.store(true, std::memory_order_relaxed);
+    uint64_t one = 1;
+    ssize_t rc = write(fd_, &one, sizeof(one));
+    (void)rc;
+}
+
+bool StopSignal::waitFor(std::chrono::milliseconds timeout) const {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!triggered()) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) break;
+        struct pollfd pfd{fd_, POLLIN, 0};
+        // EINTR (e.g. the signal that triggers us) just loops back to the check
+        poll(&pfd, 1, static_cast<int>(left));
+    }
+    return triggered();
+}
+
+// ── ReceiveStats ─────────────────────────────────────────────────────────────
+
+LatencyDistribution ReceiveStats::writeLatency() const {
+    LatencyDistribution merged;
+    for (const auto& h : write_latency)
+        h->addTo(merged);
+    return merged;
+}
+
+void ReceiveStats::printProgress() const {
+    if (!logEnabled(LogLevel::Info)) return;
+    std::ostringstream oss;
+    oss << "  Events received: " << events_received
+        << " | Written: " << events_written
+        << " | Errors: " << write_errors
+        << " | DataID mismatches: " << data_id_mismatches
+        << " | Total MB: " << (total_bytes / (1024.0 * 1024.0));
+    logInfo(oss.str());
+}
+
+// ── receiveEvents() ──────────────────────────────────────────────────────────
+
+bool receiveEvents(e2sar::Reassembler& reassembler, const CommandLineArgs& args,
+                   CaptureWriter* capture, StopSignal& stop, ControlServer* control) {
+    std::cout << "\nStarting event reception..." << std::endl;
+    if (!capture)
+        std::cout << "Output pattern: " << args.output_pattern << std::endl;
+    std::cout << "Dequeue threads: " << args.dequeue_threads;
+    if (!args.dequeue_cores.empty())
+        std::cout << " (cores " << formatCpuList(args.dequeue_cores) << ")";
+    std::cout << std::endl;
+    std::cout << "Press Ctrl+C to stop\n" << std::endl;
+
+    ReceiveStats stats;
+    for (size_t i = 0; i < args.dequeue_threads; ++i)
+        stats.write_latency.push_back(std::make_unique<LatencyHistogram>());
+    CounterSeries series;
+    if (!args.stats_csv.empty()) {
+        if (!series.open(args.stats_csv, SERIES_COLUMNS))
+            return false;
+        std::cout << "Sampling statistics every " << args.stats_interval_ms
+                  << " ms into " << args.stats_csv << std::endl;
+    }
+    JsonLinesFile json;
+    if (!args.stats_json.empty()) {
+        if (!json.open(args.stats_json))
+            return false;
+        std::cout << "Writing JSON statistics every " << args.stats_interval_ms
+                  << " ms into " << args.stats_json << std::endl;
+    }
+
+    MetricsServer metrics;
+    if (!args.metrics_addr.empty()) {
+        if (!metrics.start(args.metrics_addr, [&](PromText& out) {
+                writeReceiverMetrics(out, reassembler, stats);
+            }))
+            return false;
+        std::cout << "Serving Prometheus metrics on http://" << args.metrics_addr << "/metrics" << std::endl;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    ScopedCommand stats_command(control, "stats", "stats", [&](const ControlServer::Args&) {
+        JsonWriter json;
+        buildReceiverRecord(json, reassembler, stats, start_time, false);
+        return json.str();
+    });
+
+    std::vector<std::thread> dequeuers;
+    for (size_t i = 0; i < args.dequeue_threads; ++i) {
+        int cpu = args.dequeue_cores.empty() ? -1
+                : args.dequeue_cores[i % args.dequeue_cores.size()];
+        dequeuers.emplace_back(dequeueLoop, std::ref(reassembler), std::cref(args),
+                               capture, std::cref(stop), std::ref(stats),
+                               std::ref(*stats.write_latency[i]), i, cpu);
+    }
+
+    const auto progress_interval = std::chrono::seconds(5);
+    const auto wake_interval = (series.isOpen() || json.isOpen())
+        ? std::chrono::milliseconds(args.stats_interval_ms)
+        : std::chrono::duration_cast<std::chrono::milliseconds>(progress_interval);
+    auto last_progress = start_time;
+
+    if (series.isOpen())
+        series.sample(sampleCounters(reassembler, stats));
+
+    while (!stop.waitFor(wake_interval)) {
+        if (series.isOpen())
+            series.sample(sampleCounters(reassembler, stats));
+        if (json.isOpen())
+            writeReceiverRecord(json, reassembler, stats, start_time, false);
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_progress >= progress_interval) {
+            stats.printProgress();
+            last_progress = now;
+        }
+    }
+
+    std::cout << "\nReceived stop signal, draining dequeue threads..." << std::endl;
+    for (auto& t : dequeuers)
+        t.join();
+    logFlush();
+
+    if (series.isOpen()) {
+        series.sample(sampleCounters(reassembler, stats));
+        series.close();
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+
+    std::cout << "\n========== Reception Complete ==========" << std::endl;
+    std::cout << "EJFAT Events received: "       << stats.events_received    << std::endl;
+    std::cout << "EJFAT Events written: "        << stats.events_written     << std::endl;
+    std::cout << "Write errors: "          << stats.write_errors       << std::endl;
+    std::cout << "DataID mismatches: "     << stats.data_id_mismatches << std::endl;
+    std::cout << "Total data: "            << (stats.total_bytes / (1024.0 * 1024.0)) << " MB" << std::endl;
+    std::cout << "Duration: "        << duration.count() << " ms" << std::endl;
+
+    if (stats.events_received > 0) {
+        double mbps = (stats.total_bytes * 8.0 / 1000000.0) / (duration.count() / 1000.0);
+        std::cout << "Average rate: " << mbps << " Mbps" << std::endl;
+    }
+    std::cout << "Latency recvEvent to write: " << stats.writeLatency().summary() << std::endl;
+    if (args.alloc_stats) {
+        std::cout << "Event buffers: " << event_memory.summary() << std::endl;
+        std::cout << "Process RSS: " << formatBytes(currentRssBytes())
+                  << " (peak " << formatBytes(peakRssBytes()) << ")" << std::endl;
+    }
+    if (args.perf_counters) {
+        PerfSummary dequeue, write;
+        dequeue.merge(stats.perf_dequeue);
+        write.merge(stats.perf_write);
+        std::cout << "Hardware counters (user space):" << std::endl;
+        std::cout << "  Dequeue (recvEvent): " << dequeue.summary() << std::endl;
+        std::cout << "  Write:               " << write.summary()   << std::endl;
+    }
+
+    auto reas_stats = reassembler.getStats();
+    std::cout << "\nReassembler Statistics:" << std::endl;
+    std::cout << "  Total packets: "    << reas_stats.totalPackets    << std::endl;
+    std::cout << "  Total bytes: "      << reas_stats.totalBytes      << std::endl;
+    std::cout << "  Event success: "    << reas_stats.eventSuccess    << std::endl;
+    std::cout << "  Reassembly loss: "  << reas_stats.reassemblyLoss  << std::endl;
+    std::cout << "  Enqueue loss: "     << reas_stats.enqueueLoss     << std::endl;
+    std::cout << "  Data errors: "      << reas_stats.dataErrCnt      << std::endl;
+    std::cout << "  gRPC errors: "      << reas_stats.grpcErrCnt      << std::endl;
+
+    std::vector<boost::tuple<e2sar::EventNum_t, u_int16_t, size_t>> lostEvents;
+    while (true) {
+        auto res = reassembler.get_LostEvent();
+        if (res.has_error()) break;
+        lostEvents.push_back(res.value());
+    }
+
+    std::cout << "\tEvents lost so far (<Evt ID:Data ID/num frags rcvd>): ";
+    for (auto evt : lostEvents) {
+        std::cout << "<" << evt.get<0>() << ":" << evt.get<1>() << "/" << evt.get<2>() << "> ";
+    }
+    std::cout << std::endl;
+
+    if (json.isOpen())
+        writeReceiverRecord(json, reassembler, stats, start_time, true, lostEvents.size());
+
+    return stats.write_errors == 0 && stats.data_id_mismatches == 0;
+}
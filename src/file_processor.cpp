@@ -1,4 +1,8 @@
 #include "file_processor.hpp"
+#include "alloc_stats.hpp"
+#include "async_log.hpp"
+#include "probes.hpp"
+#include "trace.hpp"
 #include <iostream>
 #include <sstream>
 #include <chrono>
@@ -7,40 +11,79 @@
 // ── Globals ──────────────────────────────────────────────────────────────────
 
 std::atomic<size_t> global_buffer_id{0};
-std::mutex          cout_mutex;
+std::atomic<int>    verbosity{1};
+std::atomic<uint64_t> inflight_buffers{0};
+std::atomic<uint64_t> inflight_bytes{0};
 
 // ── File-local helpers ───────────────────────────────────────────────────────
 
 namespace {
 
+// Single writer per counter: a relaxed load + store is enough.
+void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
 struct StreamingStats {
-    size_t total_events_processed = 0;
-    size_t total_batches_sent     = 0;
-    size_t total_bytes_sent       = 0;
+    SendCounters& c;
 
     void addBatch(size_t events, size_t bytes) {
-        total_events_processed += events;
-        total_batches_sent++;
-        total_bytes_sent   += bytes;
+        bump(c.events, events);
+        bump(c.batches, 1);
+        bump(c.bytes, bytes);
     }
 
+    uint64_t batches() const { return c.batches.load(std::memory_order_relaxed); }
+
     void printProgress(std::ostringstream& o, boost::chrono::steady_clock::time_point& start_time) const {
         auto timestamp = boost::chrono::high_resolution_clock::now();
         auto elapsedUsec = boost::chrono::duration_cast<boost::chrono::microseconds>(timestamp - start_time);
-        o << "  EJFAT Events: " << total_batches_sent
-          << " | Physics Events: " << total_events_processed
-          << " | MB sent: " << (total_bytes_sent / (1024.0 * 1024.0))
-          << " | Estimated Thread Throughput (Gbps): " << (total_bytes_sent * 8.0)/(elapsedUsec.count() * 1000);
+        uint64_t bytes = c.bytes.load(std::memory_order_relaxed);
+        o << "  EJFAT Events: " << batches()
+          << " | Physics Events: " << c.events.load(std::memory_order_relaxed)
+          << " | MB sent: " << (bytes / (1024.0 * 1024.0))
+          << " | Estimated Thread Throughput (Gbps): " << (bytes * 8.0)/(elapsedUsec.count() * 1000);
     }
 };
 
-void thread_print(size_t file_idx, const std::ostringstream& oss) {
-    std::lock_guard<std::mutex> lock(cout_mutex);
-    std::cout << "[File " << file_idx << "] " << oss.str() << std::endl;
+void thread_print(size_t file_idx, const std::ostringstream& oss, LogLevel level = LogLevel::Info) {
+    logMessage(level, "[File " + std::to_string(file_idx) + "] " + oss.str());
+}
+
+// Batches are created and destroyed only here, so --alloc-stats sees them all.
+std::vector<double>* newBatch(size_t doubles) {
+    auto* batch = new std::vector<double>();
+    batch->reserve(doubles);
+    batch_memory.allocated(batch->capacity() * sizeof(double));
+    return batch;
+}
+
+void deleteBatch(std::vector<double>* batch) {
+    if (!batch) return;
+    batch_memory.freed(batch->capacity() * sizeof(double));
+    delete batch;
 }
 
+// Callback argument for addToSendQueue: the batch plus what freeBuffer needs
+// to record its queue-to-free latency and fire the buffer_free probe.
+struct QueuedBatch {
+    std::vector<double>* batch;
+    int64_t              queued_ns;
+    LatencyHistogram*    latency;
+    size_t               buffer_id;
+    uint16_t             data_id;
+};
+
 void freeBuffer(boost::any a) {
-    delete boost::any_cast<std::vector<double>*>(a);
+    auto*   queued = boost::any_cast<QueuedBatch*>(a);
+    int64_t waited = SendCounters::now() - queued->queued_ns;
+    size_t  bytes  = queued->batch->size() * sizeof(double);
+    queued->latency->record(waited);
+    E2SAR_PROBE4(buffer_free, queued->buffer_id, bytes, queued->data_id, waited);
+    inflight_buffers.fetch_sub(1, std::memory_order_relaxed);
+    inflight_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    deleteBatch(queued->batch);
+    delete queued;
 }
 
 } // namespace
@@ -49,19 +92,27 @@ void freeBuffer(boost::any a) {
 
 bool RootFileProcessor::process(const std::string& file_path,
                                 const std::string& tree_name) {
+    trace::nameThread("file " + std::to_string(file_index_));
+    const bool tracing = trace::enabled();
+    int64_t    open_ns = tracing ? trace::now() : 0;
+
     auto file = std::unique_ptr<TFile>(TFile::Open(file_path.c_str(), "READ"));
     send_start_ = boost::chrono::high_resolution_clock::now();
+    counters_->start_ns.store(SendCounters::now(), std::memory_order_relaxed);
+    // Mark the file finished on every return path
+    struct MarkEnd {
+        SendCounters& c;
+        ~MarkEnd() { c.end_ns.store(SendCounters::now(), std::memory_order_relaxed); }
+    } mark_end{*counters_};
     if (!file || file->IsZombie()) {
-        std::lock_guard<std::mutex> lock(cout_mutex);
-        std::cerr << "[File " << file_index_ << "] Error: Cannot open file " << file_path << std::endl;
+        logError("[File " + std::to_string(file_index_) + "] Error: Cannot open file " + file_path);
         return false;
     }
 
     TTree* tree = file->Get<TTree>(tree_name.c_str());
     if (!tree) {
-        std::lock_guard<std::mutex> lock(cout_mutex);
-        std::cerr << "[File " << file_index_ << "] Error: Tree '" << tree_name
-                  << "' not found in file " << file_path << std::endl;
+        logError("[File " + std::to_string(file_index_) + "] Error: Tree '" + tree_name +
+                 "' not found in file " + file_path);
         return false;
     }
 
@@ -73,6 +124,8 @@ bool RootFileProcessor::process(const std::string& file_path,
     }
 
     bindBranches(tree);
+    if (tracing)
+        trace::record("file open", open_ns, trace::now());
 
     const size_t EVENT_SIZE        = eventSize();
     const size_t BATCH_SIZE_BYTES  = args_.bufsize_mb * 1024 * 1024;
@@ -85,7 +138,11 @@ bool RootFileProcessor::process(const std::string& file_path,
         thread_print(file_index_, oss);
     }
 
-    StreamingStats stats;
+    StreamingStats stats{*counters_};
+
+    PerfCounterGroup perf;
+    const bool perf_on = args_.perf_counters && perf.open();
+    PerfReading perf_before, perf_mid, perf_after;
 
     {
         std::ostringstream oss;
@@ -93,16 +150,55 @@ bool RootFileProcessor::process(const std::string& file_path,
         thread_print(file_index_, oss);
     }
 
-    auto* batch = new std::vector<double>();
-    batch->reserve(BATCH_DOUBLES);
-    size_t events_in_batch = 0;
+    auto* batch = newBatch(BATCH_DOUBLES);
+    size_t  events_in_batch = 0;
+    int64_t serialize_ns    = 0;
+    int64_t batch_start_ns  = tracing ? trace::now() : 0;
+
+    // The first GetEntry() of each cluster reads and decompresses its baskets
+    auto     clusters     = tree->GetClusterIterator(0);
+    Long64_t next_cluster = 0;
 
     for (Long64_t i = 0; i < nEntries; ++i) {
-        tree->GetEntry(i);
-        appendEntry(*batch);
-        events_in_batch++;
+        // Prescaled entries are not even read from the tree
+        uint32_t prescale = control_ ? control_->prescale.load(std::memory_order_relaxed) : 1;
+        if (prescale <= 1 || i % prescale == 0) {
+            bool sample = perf_on && i % args_.perf_sample == 0 && perf.read(perf_before);
+            bool cluster_start = tracing && i >= next_cluster;
+            bool timed = entry_timing_ || cluster_start;
+            int64_t t0 = timed ? SendCounters::now() : 0;
+            tree->GetEntry(i);
+            int64_t t1 = timed ? SendCounters::now() : 0;
+            if (sample) perf.read(perf_mid);
+            if (cluster_start) {
+                // Prescaling may skip whole clusters
+                while (i >= next_cluster) {
+                    clusters();
+                    next_cluster = clusters.GetNextEntry();
+                }
+                trace::record("cluster read", t0, t1, "entry", static_cast<uint64_t>(i));
+            }
+            appendEntry(*batch);
+            if (sample && perf.read(perf_after)) {
+                counters_->perf_read.add(perf, perf_before, perf_mid);
+                counters_->perf_convert.add(perf, perf_mid, perf_after);
+            }
+            if (entry_timing_) {
+                serialize_ns += SendCounters::now() - t1;
+                counters_->get_entry_ns.record(t1 - t0);
+            }
+            events_in_batch++;
+        }
+
+        bool last = (i == nEntries - 1);
+        if (events_in_batch >= BATCH_SIZE_EVENTS || (last && events_in_batch > 0)) {
+            if (entry_timing_) {
+                counters_->serialize_ns.record(serialize_ns);
+                serialize_ns = 0;
+            }
+            if (tracing)
+                trace::record("batch build", batch_start_ns, trace::now(), "events", events_in_batch);
 
-        if (events_in_batch >= BATCH_SIZE_EVENTS || i == nEntries - 1) {
             if (args_.send_data && segmenter_) {
                 uint8_t* buffer_ptr    = reinterpret_cast<uint8_t*>(batch->data());
                 size_t   buffer_size   = batch->size() * sizeof(double);
@@ -111,54 +207,99 @@ bool RootFileProcessor::process(const std::string& file_path,
                 bool sent        = false;
                 int  retry_count = 0;
                 const int MAX_RETRIES = 10000;
+                auto submit_start  = std::chrono::steady_clock::now();
+                auto blocked_since = submit_start;
+
+                E2SAR_PROBE4(batch_ready, cur_buffer_id, buffer_size, args_.data_id, events_in_batch);
+                bool perf_batch = perf_on && perf.read(perf_before);
+
+                if (control_)
+                    control_->pacer.acquire(buffer_size);
+
+                // Count before queuing: the callback may run before we return
+                inflight_buffers.fetch_add(1, std::memory_order_relaxed);
+                inflight_bytes.fetch_add(buffer_size, std::memory_order_relaxed);
+                auto* queued = new QueuedBatch{batch, 0, &counters_->queue_to_free_ns,
+                                               cur_buffer_id, args_.data_id};
 
                 while (!sent && retry_count < MAX_RETRIES) {
+                    queued->queued_ns = SendCounters::now();
+                    if (enqueue_hook_) enqueue_hook_(cur_buffer_id, queued->queued_ns);
                     auto send_result = segmenter_->addToSendQueue(buffer_ptr, buffer_size,
-                        cur_buffer_id, 0, 0, &freeBuffer, batch);
+                        cur_buffer_id, 0, 0, &freeBuffer, queued);
 
                     if (send_result.has_error()) {
                         if (send_result.error().code() == e2sar::E2SARErrorc::MemoryError) {
+                            if (retry_count == 0)
+                                blocked_since = std::chrono::steady_clock::now();
+                            E2SAR_PROBE4(enqueue_retry, cur_buffer_id, buffer_size, args_.data_id,
+                                         retry_count + 1);
                             std::this_thread::sleep_for(std::chrono::microseconds(100));
                             retry_count++;
                             continue;
                         } else {
-                            std::lock_guard<std::mutex> lock(cout_mutex);
-                            std::cerr << "[File " << file_index_ << "] Send error: "
-                                      << send_result.error().message() << std::endl;
-                            delete batch;
+                            logError("[File " + std::to_string(file_index_) + "] Send error: " +
+                                     send_result.error().message());
+                            inflight_buffers.fetch_sub(1, std::memory_order_relaxed);
+                            inflight_bytes.fetch_sub(buffer_size, std::memory_order_relaxed);
+                            deleteBatch(batch);
+                            delete queued;
                             return false;
                         }
                     }
                     sent = true;
+                    E2SAR_PROBE4(enqueue, cur_buffer_id, buffer_size, args_.data_id, retry_count);
+                }
+
+                auto submit_end = std::chrono::steady_clock::now();
+                if (perf_batch && sent && perf.read(perf_after))
+                    counters_->perf_enqueue.add(perf, perf_before, perf_after);
+                counters_->send_wait_ns.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    submit_end - submit_start).count());
+                if (tracing)   // covers rate pacing and backpressure retries
+                    trace::record("enqueue wait", trace::nanos(submit_start), trace::nanos(submit_end),
+                                  "retries", retry_count);
+                if (retry_count > 0) {
+                    bump(counters_->retries, retry_count);
+                    bump(counters_->backpressure_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        submit_end - blocked_since).count());
                 }
 
                 if (!sent) {
-                    std::ostringstream oss;
-                    oss << "[File " << file_index_ << "] Failed to send buffer after "
-                            << MAX_RETRIES << " retries" << std::endl;
-                    thread_print(file_index_, oss);
-                    delete batch;
+                    logError("[File " + std::to_string(file_index_) + "] Failed to send buffer after " +
+                             std::to_string(MAX_RETRIES) + " retries");
+                    inflight_buffers.fetch_sub(1, std::memory_order_relaxed);
+                    inflight_bytes.fetch_sub(buffer_size, std::memory_order_relaxed);
+                    deleteBatch(batch);
+                    delete queued;
                     return false;
                 }
 
                 stats.addBatch(events_in_batch, buffer_size);
 
-                if (stats.total_batches_sent % 10 == 0) {
+                // Every 10th batch at verbosity 1, every batch at verbosity 2
+                LogLevel level = stats.batches() % 10 == 0 ? LogLevel::Info : LogLevel::Debug;
+                if (logEnabled(level)) {
                     std::ostringstream oss;
                     stats.printProgress(oss, send_start_);
-                    thread_print(file_index_, oss);
+                    thread_print(file_index_, oss, level);
                 }
             } else if (!args_.send_data) {
-                delete batch;
+                if (batch_sink_) batch_sink_(*batch);
+                deleteBatch(batch);
             }
 
-            if (i < nEntries - 1) {
-                batch = new std::vector<double>();
-                batch->reserve(BATCH_DOUBLES);
+            if (!last) {
+                batch = newBatch(BATCH_DOUBLES);
                 events_in_batch = 0;
+                if (tracing) batch_start_ns = trace::now();
+            } else {
+                batch = nullptr;
             }
         }
     }
+    // Empty tree, or a final partial batch prescaled away to nothing
+    deleteBatch(batch);
 
     {
         std::ostringstream oss;
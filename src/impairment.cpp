@@ -0,0 +1,143 @@
+#include "impairment.hpp"
+#include "event_generator.hpp"
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+// ── Spec parsing ─────────────────────────────────────────────────────────────
+
+namespace {
+
+double parseProbability(const std::string& value) {
+    size_t pos = 0;
+    double p = std::stod(value, &pos);
+    if (pos != value.size() || p < 0 || p > 1)
+        throw std::out_of_range(value);
+    return p;
+}
+
+// "250us", "5ms", "0.1s" or a bare number of milliseconds
+int64_t parseDuration(const std::string& value) {
+    size_t pos = 0;
+    double v = std::stod(value, &pos);
+    std::string unit = value.substr(pos);
+    double scale;
+    if (unit.empty() || unit == "ms") scale = 1e6;
+    else if (unit == "us")            scale = 1e3;
+    else if (unit == "s")             scale = 1e9;
+    else throw std::invalid_argument(value);
+    if (v < 0)
+        throw std::out_of_range(value);
+    return static_cast<int64_t>(v * scale);
+}
+
+std::string formatDuration(int64_t ns) {
+    std::ostringstream oss;
+    if (ns % 1000000 == 0) oss << ns / 1000000 << "ms";
+    else                   oss << ns / 1e3 << "us";
+    return oss.str();
+}
+
+} // namespace
+
+bool parseImpairment(const std::string& spec, ImpairmentConfig& out) {
+    ImpairmentConfig config;
+    std::stringstream ss(spec);
+    std::string item;
+    try {
+        while (std::getline(ss, item, ',')) {
+            if (item.empty()) continue;
+            size_t eq = item.find('=');
+            if (eq == std::string::npos)
+                throw std::invalid_argument(item);
+            std::string key   = item.substr(0, eq);
+            std::string value = item.substr(eq + 1);
+            if (key == "loss") {
+                config.loss = parseProbability(value);
+            } else if (key == "burst") {
+                size_t colon = value.find(':');
+                config.burst_enter = parseProbability(value.substr(0, colon));
+                if (colon != std::string::npos) {
+                    config.burst_length = std::stod(value.substr(colon + 1));
+                    if (!(config.burst_length >= 1))
+                        throw std::out_of_range(value);
+                }
+            } else if (key == "dup") {
+                config.duplicate = parseProbability(value);
+            } else if (key == "reorder") {
+                config.reorder = parseProbability(value);
+            } else if (key == "reorder-delay") {
+                config.reorder_delay_ns = parseDuration(value);
+            } else if (key == "delay") {
+                config.delay_ns = parseDuration(value);
+            } else if (key == "jitter") {
+                config.jitter_ns = parseDuration(value);
+            } else if (key == "seed") {
+                config.seed = std::stoull(value);
+            } else {
+                throw std::invalid_argument(item);
+            }
+        }
+    } catch (const std::logic_error&) {
+        std::cerr << "Error: invalid impairment '" << spec << "' at '" << item
+                  << "' (expected e.g. loss=0.001,burst=0.0001:20,reorder=0.01,delay=5ms,jitter=1ms)"
+                  << std::endl;
+        return false;
+    }
+    out = config;
+    return true;
+}
+
+std::string ImpairmentConfig::describe() const {
+    if (!active())
+        return "none";
+    std::ostringstream oss;
+    const char* sep = "";
+    if (loss > 0)        { oss << sep << "loss=" << loss; sep = ","; }
+    if (burst_enter > 0) { oss << sep << "burst=" << burst_enter << ":" << burst_length; sep = ","; }
+    if (duplicate > 0)   { oss << sep << "dup=" << duplicate; sep = ","; }
+    if (reorder > 0)     { oss << sep << "reorder=" << reorder
+                               << ",reorder-delay=" << formatDuration(reorder_delay_ns); sep = ","; }
+    if (delay_ns > 0)    { oss << sep << "delay=" << formatDuration(delay_ns); sep = ","; }
+    if (jitter_ns > 0)   { oss << sep << "jitter=" << formatDuration(jitter_ns); }
+    return oss.str();
+}
+
+// ── Impairment ───────────────────────────────────────────────────────────────
+
+Impairment::Impairment(const ImpairmentConfig& config, uint64_t stream)
+    : config_(config), rng_(streamSeed(config.seed, stream)) {}
+
+int64_t Impairment::delayOnce() {
+    int64_t delay = config_.delay_ns;
+    if (config_.jitter_ns > 0)
+        delay += static_cast<int64_t>(uniform_(rng_) * config_.jitter_ns);
+    if (config_.reorder > 0 && uniform_(rng_) < config_.reorder) {
+        delay += config_.reorder_delay_ns;
+        reordered_++;
+    }
+    return delay;
+}
+
+Impairment::Verdict Impairment::decide() {
+    Verdict v;
+
+    if (config_.burst_enter > 0) {
+        // Leave the bad state after burst_length frames on average
+        if (bad_state_) bad_state_ = uniform_(rng_) >= 1.0 / config_.burst_length;
+        else            bad_state_ = uniform_(rng_) < config_.burst_enter;
+    }
+    if (bad_state_ || (config_.loss > 0 && uniform_(rng_) < config_.loss)) {
+        dropped_++;
+        v.copies = 0;
+        return v;
+    }
+
+    v.delay_ns[0] = delayOnce();
+    if (config_.duplicate > 0 && uniform_(rng_) < config_.duplicate) {
+        duplicated_++;
+        v.copies      = 2;
+        v.delay_ns[1] = delayOnce();
+    }
+    return v;
+}
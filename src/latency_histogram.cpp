@@ -0,0 +1,86 @@
+#include "latency_histogram.hpp"
+#include <cmath>
+#include <cstdio>
+
+// ── Buckets ──────────────────────────────────────────────────────────────────
+
+namespace latency_buckets {
+
+uint64_t bucketLow(size_t i) {
+    if (i < SUB) return i;
+    unsigned shift = i / SUB - 1;
+    return static_cast<uint64_t>(i % SUB + SUB) << shift;
+}
+
+uint64_t bucketHigh(size_t i) {
+    if (i < SUB) return i;
+    unsigned shift = i / SUB - 1;
+    return ((static_cast<uint64_t>(i % SUB + SUB + 1)) << shift) - 1;
+}
+
+} // namespace latency_buckets
+
+// ── LatencyHistogram ─────────────────────────────────────────────────────────
+
+LatencyHistogram::LatencyHistogram()
+    : counts_(new std::atomic<uint64_t>[latency_buckets::COUNT]) {
+    for (size_t i = 0; i < latency_buckets::COUNT; ++i)
+        counts_[i].store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::addTo(LatencyDistribution& out) const {
+    for (size_t i = 0; i < latency_buckets::COUNT; ++i) {
+        uint64_t c = counts_[i].load(std::memory_order_relaxed);
+        out.counts_[i] += c;
+        out.count_     += c;
+    }
+    out.sum_ += sum_.load(std::memory_order_relaxed);
+    uint64_t m = max_.load(std::memory_order_relaxed);
+    if (m > out.max_) out.max_ = m;
+}
+
+// ── LatencyDistribution ──────────────────────────────────────────────────────
+
+uint64_t LatencyDistribution::percentile(double q) const {
+    if (count_ == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * count_));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            uint64_t v = latency_buckets::bucketHigh(i);
+            return v < max_ ? v : max_;
+        }
+    }
+    return max_;
+}
+
+uint64_t LatencyDistribution::countAtOrBelow(uint64_t ns) const {
+    uint64_t n = 0;
+    for (size_t i = 0; i < counts_.size() && latency_buckets::bucketHigh(i) <= ns; ++i)
+        n += counts_[i];
+    return n;
+}
+
+std::string LatencyDistribution::summary() const {
+    if (count_ == 0) return "no samples";
+    return "p50=" + formatNanos(percentile(0.50)) +
+           " p99=" + formatNanos(percentile(0.99)) +
+           " p99.9=" + formatNanos(percentile(0.999)) +
+           " max=" + formatNanos(max_) +
+           " (n=" + std::to_string(count_) + ")";
+}
+
+std::string formatNanos(uint64_t ns) {
+    char buf[32];
+    if (ns < 1000)
+        std::snprintf(buf, sizeof(buf), "%lluns", static_cast<unsigned long long>(ns));
+    else if (ns < 1000000)
+        std::snprintf(buf, sizeof(buf), "%.1fus", ns / 1e3);
+    else if (ns < 1000000000)
+        std::snprintf(buf, sizeof(buf), "%.1fms", ns / 1e6);
+    else
+        std::snprintf(buf, sizeof(buf), "%.2fs", ns / 1e9);
+    return buf;
+}
@@ -0,0 +1,544 @@
+#include "lb_emulator.hpp"
+#include "alloc_stats.hpp"
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ── LB header ────────────────────────────────────────────────────────────────
+
+bool parseLBHeader(const uint8_t* data, size_t len, LBHeader& out) {
+    if (len < LB_HEADER_BYTES || data[0] != 'L' || data[1] != 'B')
+        return false;
+    if (data[2] != 2 && data[2] != 3)
+        return false;
+    out.version = data[2];
+    out.entropy = static_cast<uint16_t>(data[6] << 8 | data[7]);
+    uint64_t event_num = 0;
+    for (int i = 8; i < 16; ++i)
+        event_num = event_num << 8 | data[i];
+    out.event_num = event_num;
+    return true;
+}
+
+void writeLBHeader(uint8_t* data, const LBHeader& header) {
+    data[0] = 'L';
+    data[1] = 'B';
+    data[2] = 2;
+    data[3] = 1;
+    data[4] = data[5] = 0;
+    data[6] = static_cast<uint8_t>(header.entropy >> 8);
+    data[7] = static_cast<uint8_t>(header.entropy);
+    for (int i = 15; i >= 8; --i)
+        data[i] = static_cast<uint8_t>(header.event_num >> (8 * (15 - i)));
+}
+
+// ── Workers and calendar ─────────────────────────────────────────────────────
+
+bool parseLBWorker(const std::string& spec, LBWorker& out) {
+    LBWorker worker;
+    std::string addr = spec.substr(0, spec.find(','));
+    size_t colon = addr.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+        std::cerr << "Error: worker '" << spec << "' must be host:port[,ports=N][,weight=W]" << std::endl;
+        return false;
+    }
+    worker.host = addr.substr(0, colon);
+    if (worker.host.size() >= 2 && worker.host.front() == '[' && worker.host.back() == ']')
+        worker.host = worker.host.substr(1, worker.host.size() - 2);
+
+    try {
+        int port = std::stoi(addr.substr(colon + 1));
+        if (port <= 0 || port > 65535)
+            throw std::out_of_range("port");
+        worker.port = static_cast<uint16_t>(port);
+
+        for (size_t pos = addr.size(); pos < spec.size();) {
+            size_t next = spec.find(',', pos + 1);
+            std::string opt = spec.substr(pos + 1, next == std::string::npos ? std::string::npos : next - pos - 1);
+            pos = next == std::string::npos ? spec.size() : next;
+            if (opt.rfind("ports=", 0) == 0) {
+                int ports = std::stoi(opt.substr(6));
+                if (ports <= 0 || ports > 32768)
+                    throw std::out_of_range("ports");
+                worker.ports = 1;
+                while (worker.ports < ports)
+                    worker.ports = static_cast<uint16_t>(worker.ports << 1);
+            } else if (opt.rfind("weight=", 0) == 0) {
+                worker.weight = std::stod(opt.substr(7));
+                if (!(worker.weight > 0))
+                    throw std::out_of_range("weight");
+            } else {
+                throw std::invalid_argument(opt);
+            }
+        }
+    } catch (const std::logic_error&) {
+        std::cerr << "Error: invalid worker '" << spec << "' (expected e.g. 127.0.0.1:19600,ports=4,weight=2)"
+                  << std::endl;
+        return false;
+    }
+    if (worker.port + worker.ports - 1 > 65535) {
+        std::cerr << "Error: worker '" << spec << "' port range exceeds 65535" << std::endl;
+        return false;
+    }
+    out = worker;
+    return true;
+}
+
+LBCalendar::LBCalendar(const std::vector<double>& weights, size_t slots)
+    : slots_(std::max<size_t>(slots, 1), 0) {
+    const size_t n = weights.size();
+    double total = 0;
+    for (double w : weights)
+        total += std::max(w, 0.0);
+    if (n == 0 || total <= 0)
+        return;
+
+    // Largest-remainder share of the slots, at least one per weighted worker
+    std::vector<size_t> quota(n, 0);
+    std::vector<double> remainder(n, 0);
+    size_t assigned = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double exact = slots_.size() * std::max(weights[i], 0.0) / total;
+        quota[i]     = static_cast<size_t>(exact);
+        remainder[i] = exact - quota[i];
+        assigned    += quota[i];
+    }
+    while (assigned < slots_.size()) {
+        size_t best = 0;
+        for (size_t i = 1; i < n; ++i)
+            if (remainder[i] > remainder[best]) best = i;
+        quota[best]++;
+        remainder[best] = -1;
+        assigned++;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (weights[i] > 0 && quota[i] == 0 && slots_.size() >= n) {
+            size_t donor = static_cast<size_t>(std::max_element(quota.begin(), quota.end()) - quota.begin());
+            quota[donor]--;
+            quota[i]++;
+        }
+    }
+
+    // Smooth weighted round robin: spreads each worker's slots evenly
+    std::vector<long> current(n, 0);
+    for (size_t s = 0; s < slots_.size(); ++s) {
+        size_t pick = 0;
+        for (size_t i = 0; i < n; ++i) {
+            current[i] += static_cast<long>(quota[i]);
+            if (current[i] > current[pick]) pick = i;
+        }
+        current[pick] -= static_cast<long>(slots_.size());
+        slots_[s] = static_cast<uint32_t>(pick);
+    }
+}
+
+size_t LBCalendar::slotsFor(size_t worker) const {
+    return static_cast<size_t>(std::count(slots_.begin(), slots_.end(), worker));
+}
+
+// ── Emulator ─────────────────────────────────────────────────────────────────
+
+namespace {
+
+std::vector<double> weightsOf(const std::vector<LBWorker>& workers) {
+    std::vector<double> weights;
+    for (const auto& w : workers)
+        weights.push_back(w.weight);
+    return weights;
+}
+
+bool resolve(const std::string& host, uint16_t port, sockaddr_storage& addr, socklen_t& len) {
+    struct addrinfo hints{};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags    = AI_NUMERICHOST | AI_NUMERICSERV;
+    struct addrinfo* res = nullptr;
+    int rc = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res);
+    if (rc != 0) {
+        std::cerr << "Error: address '" << host << "': " << gai_strerror(rc) << std::endl;
+        return false;
+    }
+    std::memcpy(&addr, res->ai_addr, res->ai_addrlen);
+    len = res->ai_addrlen;
+    freeaddrinfo(res);
+    return true;
+}
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Frames larger than this (jumbo MTU plus headroom) are dropped as truncated
+constexpr size_t MAX_FRAME = 9216;
+constexpr size_t BATCH     = 64;
+
+// A new calendar takes over this many events past the highest one seen, so
+// frames of events a sender is part way through keep their worker; events
+// up to EPOCH_OVERLAP below that boundary stay on the previous calendar.
+constexpr uint64_t EPOCH_LEAD    = 64;
+constexpr uint64_t EPOCH_OVERLAP = 1u << 20;
+
+} // namespace
+
+const LBEmulator::Routing& LBEmulator::Epoch::routeFor(uint64_t event_num) const {
+    if (previous && event_num < start_event && start_event - event_num <= EPOCH_OVERLAP)
+        return *previous;
+    return *current;
+}
+
+LBEmulator::LBEmulator(LBEmulatorConfig config)
+    : config_(std::move(config)) {}
+
+bool LBEmulator::buildRouting(std::vector<LBWorker> workers,
+                              std::vector<std::shared_ptr<LBWorkerCounters>> counters,
+                              std::shared_ptr<Routing>& out) const {
+    auto routing = std::make_shared<Routing>(Routing{{}, LBCalendar(weightsOf(workers), config_.calendar_slots),
+                                                     {}, {}, {}});
+    for (size_t w = 0; w < workers.size(); ++w) {
+        const LBWorker& worker = workers[w];
+        std::vector<Destination> ports;
+        for (uint16_t p = 0; p < worker.ports; ++p) {
+            Destination d;
+            if (!resolve(worker.host, static_cast<uint16_t>(worker.port + p), d.addr, d.len))
+                return false;
+            if (d.addr.ss_family != family_) {
+                std::cerr << "Error: workers must all be IPv4 or all IPv6" << std::endl;
+                return false;
+            }
+            ports.push_back(d);
+        }
+        routing->destinations.push_back(std::move(ports));
+        routing->skip.push_back(config_.strip_lb_header || worker.strip_lb_header ? LB_HEADER_BYTES : 0);
+        routing->counters.push_back(w < counters.size() && counters[w] ? counters[w]
+                                                                       : std::make_shared<LBWorkerCounters>());
+    }
+    routing->workers = std::move(workers);
+    out = std::move(routing);
+    return true;
+}
+
+bool LBEmulator::start() {
+    sockaddr_storage listen_addr;
+    socklen_t        listen_len;
+    if (!resolve(config_.listen_ip, config_.listen_port, listen_addr, listen_len))
+        return false;
+
+    // Workers and the send sockets share one address family
+    family_ = listen_addr.ss_family;
+    if (!config_.workers.empty()) {
+        sockaddr_storage first;
+        socklen_t        first_len;
+        if (!resolve(config_.workers[0].host, config_.workers[0].port, first, first_len))
+            return false;
+        family_ = first.ss_family;
+    }
+    std::shared_ptr<Routing> routing;
+    if (!buildRouting(config_.workers, {}, routing))
+        return false;
+    auto epoch     = std::make_shared<Epoch>();
+    epoch->id      = 1;
+    epoch->current = std::move(routing);
+    std::atomic_store(&epoch_, std::shared_ptr<const Epoch>(std::move(epoch)));
+
+    stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stop_fd_ < 0) {
+        std::cerr << "Error: eventfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    const int one     = 1;
+    const int bufsize = config_.socket_buffer_mb * 1024 * 1024;
+    for (size_t t = 0; t < std::max<size_t>(config_.threads, 1); ++t) {
+        int in  = socket(listen_addr.ss_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        int out = socket(family_, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (in >= 0)  fds_.push_back(in);
+        if (out >= 0) fds_.push_back(out);
+        if (in < 0 || out < 0 ||
+            setsockopt(in, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+            setsockopt(in, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0 ||
+            bind(in, reinterpret_cast<sockaddr*>(&listen_addr), listen_len) != 0) {
+            std::cerr << "Error: cannot listen on " << config_.listen_ip << ":" << config_.listen_port
+                      << ": " << strerror(errno) << std::endl;
+            stop();
+            return false;
+        }
+        // Best effort; the kernel caps these at net.core.{r,w}mem_max
+        setsockopt(in, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+        setsockopt(out, SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(bufsize));
+        threads_.emplace_back(&LBEmulator::forwardLoop, this, in, out, t);
+    }
+    return true;
+}
+
+void LBEmulator::stop() {
+    if (stop_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t rc = write(stop_fd_, &one, sizeof(one));
+        (void)rc;
+    }
+    for (auto& t : threads_)
+        if (t.joinable()) t.join();
+    threads_.clear();
+    for (int fd : fds_)
+        close(fd);
+    fds_.clear();
+    if (stop_fd_ >= 0) close(stop_fd_);
+    stop_fd_ = -1;
+}
+
+bool LBEmulator::setWorkers(std::vector<LBWorker> workers,
+                            std::vector<std::shared_ptr<LBWorkerCounters>> counters) {
+    std::lock_guard<std::mutex> lock(epoch_mutex_);
+    auto current = std::atomic_load(&epoch_);
+    if (!current) {
+        std::cerr << "Error: the LB emulator is not running" << std::endl;
+        return false;
+    }
+    std::shared_ptr<Routing> routing;
+    if (!buildRouting(std::move(workers), std::move(counters), routing))
+        return false;
+
+    auto epoch         = std::make_shared<Epoch>();
+    epoch->id          = current->id + 1;
+    epoch->start_event = max_event_.load(std::memory_order_relaxed) + EPOCH_LEAD;
+    epoch->current     = std::move(routing);
+    epoch->previous    = current->current;
+    std::atomic_store(&epoch_, std::shared_ptr<const Epoch>(std::move(epoch)));
+    return true;
+}
+
+uint64_t LBEmulator::epoch() const {
+    auto epoch = std::atomic_load(&epoch_);
+    return epoch ? epoch->id : 0;
+}
+
+std::vector<LBWorker> LBEmulator::workers() const {
+    auto epoch = std::atomic_load(&epoch_);
+    return epoch ? epoch->current->workers : config_.workers;
+}
+
+LBCalendar LBEmulator::calendar() const {
+    auto epoch = std::atomic_load(&epoch_);
+    return epoch ? epoch->current->calendar : LBCalendar(weightsOf(config_.workers), config_.calendar_slots);
+}
+
+std::shared_ptr<LBWorkerCounters> LBEmulator::workerCounters(size_t worker) const {
+    auto epoch = std::atomic_load(&epoch_);
+    if (!epoch || worker >= epoch->current->counters.size())
+        return nullptr;
+    return epoch->current->counters[worker];
+}
+
+void LBEmulator::forwardLoop(int listen_fd, int send_fd, size_t index) {
+    // Room for every frame of a receive batch to be duplicated
+    constexpr size_t OUT_BATCH = 2 * BATCH;
+
+    std::vector<uint8_t>  buffers(BATCH * MAX_FRAME);
+    struct iovec          in_iov[BATCH], out_iov[OUT_BATCH];
+    struct mmsghdr        in_msgs[BATCH], out_msgs[OUT_BATCH];
+    // Per worker of the current calendar, added to its counters per batch
+    std::vector<uint64_t> frames, bytes;
+    const bool            impaired = config_.impairment.active();
+    Impairment            impairment(config_.impairment, index);
+    struct { uint64_t dropped, duplicated, reordered; } reported{0, 0, 0};
+
+    // Frames held back by delay or reordering, earliest first (min-heap),
+    // those released into the current send batch, and recycled ones
+    std::vector<std::unique_ptr<DelayedFrame>> delayed, releasing, spare;
+    auto later = [](const std::unique_ptr<DelayedFrame>& a, const std::unique_ptr<DelayedFrame>& b) {
+        return a->due_ns > b->due_ns;
+    };
+
+    std::memset(in_msgs, 0, sizeof(in_msgs));
+    for (size_t i = 0; i < BATCH; ++i) {
+        in_iov[i] = {buffers.data() + i * MAX_FRAME, MAX_FRAME};
+        in_msgs[i].msg_hdr.msg_iov    = &in_iov[i];
+        in_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t   out_n  = 0;
+    uint64_t errors = 0;
+    auto flush = [&]() {
+        for (size_t sent = 0; sent < out_n;) {
+            int rc = sendmmsg(send_fd, out_msgs + sent, static_cast<unsigned>(out_n - sent), 0);
+            if (rc < 0) {
+                if (errno == EINTR) continue;
+                errors++;   // skip the frame that failed and carry on
+                sent++;
+                continue;
+            }
+            sent += static_cast<size_t>(rc);
+        }
+        out_n = 0;
+        for (auto& f : releasing)
+            spare.push_back(std::move(f));
+        releasing.clear();
+    };
+    auto enqueue = [&](uint8_t* data, size_t len, const Destination& dest) {
+        if (out_n == OUT_BATCH) flush();
+        out_iov[out_n] = {data, len};
+        std::memset(&out_msgs[out_n], 0, sizeof(out_msgs[out_n]));
+        out_msgs[out_n].msg_hdr.msg_name    = const_cast<sockaddr_storage*>(&dest.addr);
+        out_msgs[out_n].msg_hdr.msg_namelen = dest.len;
+        out_msgs[out_n].msg_hdr.msg_iov     = &out_iov[out_n];
+        out_msgs[out_n].msg_hdr.msg_iovlen  = 1;
+        out_n++;
+    };
+
+    struct pollfd fds[2] = {{listen_fd, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+    while (true) {
+        struct timespec  wait{};
+        struct timespec* timeout = nullptr;
+        if (!delayed.empty()) {
+            int64_t left = std::max<int64_t>(delayed.front()->due_ns - nowNs(), 0);
+            wait.tv_sec  = left / 1000000000;
+            wait.tv_nsec = left % 1000000000;
+            timeout      = &wait;
+        }
+        if (ppoll(fds, 2, timeout, nullptr) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "LB emulator: poll: " << strerror(errno) << std::endl;
+            return;
+        }
+        if (fds[1].revents) return;
+
+        // Held for the batch, so setWorkers cannot free the routing under us
+        std::shared_ptr<const Epoch> epoch = std::atomic_load(&epoch_);
+        const Routing& current = *epoch->current;
+        uint64_t frames_in = 0, bytes_in = 0, dropped = 0, max_event = 0;
+        frames.assign(current.workers.size(), 0);
+        bytes.assign(current.workers.size(), 0);
+
+        int n = (fds[0].revents & POLLIN) ? recvmmsg(listen_fd, in_msgs, BATCH, MSG_DONTWAIT, nullptr) : 0;
+        for (int i = 0; i < n; ++i) {
+            uint8_t* frame = static_cast<uint8_t*>(in_iov[i].iov_base);
+            size_t   len   = in_msgs[i].msg_len;
+            LBHeader header;
+            frames_in++;
+            bytes_in += len;
+            if ((in_msgs[i].msg_hdr.msg_flags & MSG_TRUNC) || !parseLBHeader(frame, len, header)) {
+                dropped++;
+                continue;
+            }
+            max_event = std::max(max_event, header.event_num);
+            const Routing& routing = epoch->routeFor(header.event_num);
+            if (routing.workers.empty()) {
+                dropped++;
+                continue;
+            }
+            // Calendar picks the worker for the whole event, entropy the port
+            size_t w = routing.calendar.workerFor(header.event_num);
+            const auto& ports = routing.destinations[w];
+            const Destination& dest = ports[header.entropy & (ports.size() - 1)];
+            const size_t skip = routing.skip[w];
+
+            Impairment::Verdict verdict;
+            if (impaired)
+                verdict = impairment.decide();
+            for (int c = 0; c < verdict.copies; ++c) {
+                if (verdict.delay_ns[c] == 0) {
+                    enqueue(frame + skip, len - skip, dest);
+                    if (&routing == &current) {
+                        frames[w]++;
+                        bytes[w] += len - skip;
+                    } else {
+                        routing.counters[w]->frames.fetch_add(1, std::memory_order_relaxed);
+                        routing.counters[w]->bytes.fetch_add(len - skip, std::memory_order_relaxed);
+                    }
+                    continue;
+                }
+                std::unique_ptr<DelayedFrame> held;
+                if (spare.empty()) {
+                    held = std::make_unique<DelayedFrame>();
+                } else {
+                    held = std::move(spare.back());
+                    spare.pop_back();
+                }
+                held->due_ns   = nowNs() + verdict.delay_ns[c];
+                held->dest     = dest;
+                held->counters = routing.counters[w];
+                held->frame.assign(frame + skip, frame + len);
+                delayed.push_back(std::move(held));
+                std::push_heap(delayed.begin(), delayed.end(), later);
+            }
+        }
+        flush();   // before the receive buffers are reused
+
+        // Release everything that has come due
+        for (int64_t now = nowNs(); !delayed.empty() && delayed.front()->due_ns <= now;) {
+            std::pop_heap(delayed.begin(), delayed.end(), later);
+            if (out_n == OUT_BATCH) flush();
+            releasing.push_back(std::move(delayed.back()));
+            delayed.pop_back();
+            DelayedFrame& f = *releasing.back();
+            enqueue(f.frame.data(), f.frame.size(), f.dest);
+            f.counters->frames.fetch_add(1, std::memory_order_relaxed);
+            f.counters->bytes.fetch_add(f.frame.size(), std::memory_order_relaxed);
+            f.counters.reset();
+        }
+        flush();
+
+        counters_.frames_in.fetch_add(frames_in, std::memory_order_relaxed);
+        counters_.bytes_in.fetch_add(bytes_in, std::memory_order_relaxed);
+        if (dropped) counters_.dropped.fetch_add(dropped, std::memory_order_relaxed);
+        if (errors)  counters_.send_errors.fetch_add(errors, std::memory_order_relaxed);
+        errors = 0;
+        for (size_t w = 0; w < frames.size(); ++w) {
+            if (!frames[w]) continue;
+            current.counters[w]->frames.fetch_add(frames[w], std::memory_order_relaxed);
+            current.counters[w]->bytes.fetch_add(bytes[w], std::memory_order_relaxed);
+        }
+        for (uint64_t seen = max_event_.load(std::memory_order_relaxed);
+             max_event > seen && !max_event_.compare_exchange_weak(seen, max_event, std::memory_order_relaxed);) {}
+        if (impaired) {
+            counters_.impaired_drops.fetch_add(impairment.dropped() - reported.dropped, std::memory_order_relaxed);
+            counters_.duplicated.fetch_add(impairment.duplicated() - reported.duplicated, std::memory_order_relaxed);
+            counters_.reordered.fetch_add(impairment.reordered() - reported.reordered, std::memory_order_relaxed);
+            reported = {impairment.dropped(), impairment.duplicated(), impairment.reordered()};
+        }
+    }
+}
+
+void LBEmulator::printSummary(std::ostream& out) const {
+    auto epoch = std::atomic_load(&epoch_);
+    if (!epoch) return;
+    const Routing& routing = *epoch->current;
+    uint64_t forwarded = 0;
+    for (const auto& c : routing.counters)
+        forwarded += c->frames.load();
+
+    out << "LB emulator: " << counters_.frames_in.load() << " frames in ("
+        << formatBytes(counters_.bytes_in.load()) << "), " << forwarded << " forwarded, "
+        << counters_.dropped.load() << " dropped, " << counters_.send_errors.load() << " send errors";
+    if (epoch->id > 1)
+        out << ", epoch " << epoch->id;
+    out << "\n";
+    if (config_.impairment.active())
+        out << "  impairment " << config_.impairment.describe() << ": "
+            << counters_.impaired_drops.load() << " dropped, " << counters_.duplicated.load()
+            << " duplicated, " << counters_.reordered.load() << " reordered\n";
+    for (size_t w = 0; w < routing.workers.size(); ++w) {
+        const LBWorker& worker = routing.workers[w];
+        uint64_t frames = routing.counters[w]->frames.load();
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "  worker %zu  %s:%u x%u  weight %.2f  slots %zu/%zu  frames %lu (%.1f%%)  %s\n",
+                      w, worker.host.c_str(), static_cast<unsigned>(worker.port),
+                      static_cast<unsigned>(worker.ports), worker.weight, routing.calendar.slotsFor(w),
+                      routing.calendar.size(), static_cast<unsigned long>(frames),
+                      forwarded ? 100.0 * frames / forwarded : 0.0,
+                      formatBytes(routing.counters[w]->bytes.load()).c_str());
+        out << line;
+    }
+    out << std::flush;
+}
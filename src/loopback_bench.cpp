@@ -0,0 +1,404 @@
+#include "loopback_bench.hpp"
+#include "file_processor.hpp"
+#include "event_receiver.hpp"
+#include "async_log.hpp"
+#include "lb_emulator.hpp"
+#include "mock_cp.hpp"
+#include "alloc_stats.hpp"
+#include <e2sar.hpp>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <sys/resource.h>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+// Enqueue time per buffer id, looked up by the dequeue threads. Sized well
+// beyond the number of buffers ever in flight at once.
+constexpr size_t STAMP_SLOTS = 1 << 16;
+
+// Beyond one epoch, how long a registered receiver may take to get slots
+constexpr int CP_STARTUP_TIMEOUT_MS = 5000;
+
+struct TrialState {
+    std::unique_ptr<std::atomic<int64_t>[]> stamps{new std::atomic<int64_t>[STAMP_SLOTS]};
+    std::atomic<uint64_t> buffers_received{0};
+    std::atomic<uint64_t> bytes_received{0};
+    std::atomic<uint64_t> bytes_sent{0};
+    std::atomic<int64_t>  last_recv_ns{0};
+    std::vector<std::unique_ptr<LatencyHistogram>> latency;
+
+    TrialState() {
+        for (size_t i = 0; i < STAMP_SLOTS; ++i)
+            stamps[i].store(0, std::memory_order_relaxed);
+    }
+    void stamp(size_t buffer_id, int64_t ns) {
+        stamps[buffer_id % STAMP_SLOTS].store(ns, std::memory_order_relaxed);
+    }
+};
+
+double cpuSeconds() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+void pageFaults(uint64_t& minor, uint64_t& major) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return;
+    minor = static_cast<uint64_t>(usage.ru_minflt);
+    major = static_cast<uint64_t>(usage.ru_majflt);
+}
+
+std::string benchUri(uint16_t port) {
+    return "ejfat://bench@127.0.0.1:18347/lb/0?sync=127.0.0.1:19010&data=127.0.0.1:" +
+           std::to_string(port);
+}
+
+CommandLineArgs processorArgs(const BenchConfig& config, bool send) {
+    CommandLineArgs args{};
+    args.tree_name  = config.tree_name;
+    args.send_data  = send;
+    args.bufsize_mb = config.bufsize_mb;
+    args.mtu        = config.mtu;
+    args.use_toy    = config.use_toy;
+    args.use_gluex  = !config.use_toy;
+    return args;
+}
+
+std::unique_ptr<RootFileProcessor> makeProcessor(const BenchConfig& config, const CommandLineArgs& args,
+                                                 e2sar::Segmenter* segmenter, size_t index) {
+    if (config.use_toy)
+        return std::make_unique<ToyFileProcessor>(args, segmenter, index);
+    return std::make_unique<GluexFileProcessor>(args, segmenter, index);
+}
+
+// Send one file's preloaded batches the way process() does, minus the ROOT
+// reads. The batches outlive the trial, so the segmenter needs no free
+// callback.
+bool replayBatches(e2sar::Segmenter& segmenter, const BenchBatches& batches, TrialState& state) {
+    const int MAX_RETRIES = 10000;
+    for (const auto& batch : batches) {
+        auto*  data      = reinterpret_cast<uint8_t*>(const_cast<double*>(batch.data()));
+        size_t bytes     = batch.size() * sizeof(double);
+        size_t buffer_id = global_buffer_id.fetch_add(1);
+
+        int retry_count = 0;
+        for (;;) {
+            state.stamp(buffer_id, SendCounters::now());
+            auto result = segmenter.addToSendQueue(data, bytes, buffer_id, 0, 0);
+            if (!result.has_error())
+                break;
+            if (result.error().code() != e2sar::E2SARErrorc::MemoryError || ++retry_count >= MAX_RETRIES) {
+                logError("Send error on buffer " + std::to_string(buffer_id) + ": " +
+                         result.error().message());
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        state.bytes_sent.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// Dequeue and discard events, recording enqueue → recvEvent latency.
+void drainLoop(e2sar::Reassembler& reassembler, const StopSignal& stop, TrialState& state,
+               LatencyHistogram& latency) {
+    uint8_t*          event_buffer = nullptr;
+    size_t            event_size   = 0;
+    e2sar::EventNum_t event_num    = 0;
+    uint16_t          data_id      = 0;
+
+    while (!stop.triggered()) {
+        auto result = reassembler.recvEvent(&event_buffer, &event_size, &event_num, &data_id, 50);
+        if (result.has_error() || result.value() == -1) continue;
+
+        int64_t now  = SendCounters::now();
+        int64_t sent = state.stamps[event_num % STAMP_SLOTS].load(std::memory_order_relaxed);
+        if (sent > 0 && now > sent)
+            latency.record(static_cast<uint64_t>(now - sent));
+        state.bytes_received.fetch_add(event_size, std::memory_order_relaxed);
+        state.buffers_received.fetch_add(1, std::memory_order_relaxed);
+        state.last_recv_ns.store(now, std::memory_order_relaxed);
+        delete[] event_buffer;
+        event_buffer = nullptr;
+    }
+}
+
+} // namespace
+
+// ── Preloading ───────────────────────────────────────────────────────────────
+
+bool loadBenchBatches(const BenchConfig& config, std::vector<BenchBatches>& out) {
+    CommandLineArgs args = processorArgs(config, false);
+    out.assign(config.files.size(), {});
+    for (size_t i = 0; i < config.files.size(); ++i) {
+        auto proc = makeProcessor(config, args, nullptr, i);
+        BenchBatches& batches = out[i];
+        proc->setBatchSink([&batches](const std::vector<double>& batch) { batches.push_back(batch); });
+        if (!proc->process(config.files[i], config.tree_name))
+            return false;
+    }
+    return true;
+}
+
+// ── Trial ────────────────────────────────────────────────────────────────────
+
+BenchResult runLoopbackTrial(const BenchConfig& config, const std::vector<BenchBatches>* preloaded) {
+    BenchResult result;
+    if (config.files.empty() || (config.from_memory && (!preloaded || preloaded->size() != config.files.size()))) {
+        std::cerr << "Error: benchmark trial has no source data" << std::endl;
+        return result;
+    }
+
+    // Control plane first: it decides the URI everyone uses
+    std::unique_ptr<MockControlPlane> cp;
+    if (config.control_plane) {
+        MockCPConfig cpconfig;
+        cpconfig.cp_port                = config.cp_port;
+        cpconfig.epoch_ms               = config.cp_epoch_ms;
+        cpconfig.data_plane.listen_port = config.proxy_port;
+        cpconfig.data_plane.impairment  = config.impairment;
+        cp = std::make_unique<MockControlPlane>(cpconfig);
+        if (!cp->start())
+            return result;
+    }
+
+    const uint16_t data_port = config.routed() ? config.proxy_port : config.port;
+    auto uri_result = e2sar::EjfatURI::getFromString(cp ? cp->uri() : benchUri(data_port),
+        e2sar::EjfatURI::TokenType::instance, false);
+    if (uri_result.has_error()) {
+        std::cerr << "Error parsing URI: " << uri_result.error().message() << std::endl;
+        return result;
+    }
+    e2sar::EjfatURI uri = uri_result.value();
+
+    // Receiver first, so nothing sent is lost to a closed port
+    e2sar::Reassembler::ReassemblerFlags rflags;
+    rflags.useCP           = config.control_plane;
+    rflags.withLBHeader    = !config.control_plane;
+    rflags.eventTimeout_ms = config.event_timeout_ms;
+    rflags.validateCert    = false;
+    e2sar::Reassembler reassembler(uri, boost::asio::ip::make_address("127.0.0.1"), config.port,
+                                   config.recv_threads, rflags);
+    if (cp) {
+        auto regres = reassembler.registerWorker("e2sar-bench");
+        if (regres.has_error()) {
+            std::cerr << "Error registering worker: " << regres.error().message() << std::endl;
+            return result;
+        }
+    }
+    auto reas_open = reassembler.openAndStart();
+    if (reas_open.has_error()) {
+        std::cerr << "Error starting reassembler: " << reas_open.error().message() << std::endl;
+        return result;
+    }
+
+    // Proxy between the two, entropy spreading frames over the receive ports
+    std::unique_ptr<LBEmulator> proxy;
+    if (config.routed() && !cp) {
+        LBEmulatorConfig pconfig;
+        pconfig.listen_port = config.proxy_port;
+        pconfig.impairment  = config.impairment;
+        LBWorker worker;
+        worker.host = "127.0.0.1";
+        worker.port = config.port;
+        while (worker.ports < config.recv_threads)
+            worker.ports = static_cast<uint16_t>(worker.ports << 1);
+        pconfig.workers.push_back(worker);
+        proxy = std::make_unique<LBEmulator>(pconfig);
+        if (!proxy->start()) {
+            reassembler.stopThreads();
+            return result;
+        }
+    }
+
+    // With a control plane, wait for the receiver's first state reports to
+    // earn it slots; that wait is the worker startup latency
+    if (cp) {
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(config.cp_epoch_ms + CP_STARTUP_TIMEOUT_MS);
+        while (result.cp_startup_ms == 0 && std::chrono::steady_clock::now() < deadline) {
+            for (const auto& w : cp->workers())
+                if (w.routed_ns > 0)
+                    result.cp_startup_ms = (w.routed_ns - w.registered_ns) / 1e6;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (result.cp_startup_ms == 0) {
+            std::cerr << "Error: the receiver never got slots from the mock control plane" << std::endl;
+            reassembler.deregisterWorker();
+            reassembler.stopThreads();
+            return result;
+        }
+        e2sar::LBManager lbm(uri, false);
+        auto addres = lbm.addSenderSelf();
+        if (addres.has_error()) {
+            std::cerr << "Unable to add sender to allow list: " << addres.error().message() << std::endl;
+            reassembler.deregisterWorker();
+            reassembler.stopThreads();
+            return result;
+        }
+    }
+
+    // One data id and event source per Segmenter, as separate senders would have
+    e2sar::Segmenter::SegmenterFlags sflags;
+    sflags.mtu            = config.mtu;
+    sflags.useCP          = config.control_plane;
+    sflags.numSendSockets = 4;
+    sflags.rateGbps       = config.rate_gbps;
+    std::vector<std::unique_ptr<e2sar::Segmenter>> segmenters;
+    for (size_t s = 0; s < std::max<size_t>(config.segmenters, 1); ++s) {
+        segmenters.push_back(std::make_unique<e2sar::Segmenter>(uri, static_cast<uint16_t>(s),
+                                                                 static_cast<uint32_t>(s + 1), sflags));
+        auto seg_open = segmenters.back()->openAndStart();
+        if (seg_open.has_error()) {
+            std::cerr << "Error starting segmenter: " << seg_open.error().message() << std::endl;
+            for (auto& seg : segmenters)
+                seg->stopThreads();
+            if (proxy) proxy->stop();
+            if (cp) reassembler.deregisterWorker();
+            reassembler.stopThreads();
+            return result;
+        }
+    }
+
+    TrialState state;
+    StopSignal stop;
+    std::vector<std::thread> dequeue;
+    for (size_t i = 0; i < config.dequeue_threads; ++i) {
+        state.latency.push_back(std::make_unique<LatencyHistogram>());
+        dequeue.emplace_back(drainLoop, std::ref(reassembler), std::cref(stop), std::ref(state),
+                             std::ref(*state.latency.back()));
+    }
+
+    global_buffer_id = 0;
+    const CommandLineArgs args = processorArgs(config, true);
+    std::unique_ptr<SendCounters[]> counters(new SendCounters[config.sender_threads]);
+    std::atomic<size_t> failed{0};
+    std::atomic<size_t> next_send{0};
+
+    // File for sender thread t's next send after `done` of its own; false
+    // once its share (or the shared queue) is used up
+    auto nextFile = [&](size_t t, size_t done, size_t& f) {
+        if (config.file_sends == 0) {
+            f = t % config.files.size();
+            return done < config.passes;
+        }
+        size_t k = next_send.fetch_add(1, std::memory_order_relaxed);
+        f = k % config.files.size();
+        return k < config.file_sends;
+    };
+
+    uint64_t minor_start = 0, major_start = 0;
+    if (config.memory) {
+        alloc_accounting = true;
+        batch_memory.resetPeak();
+        resetPeakRss();
+        result.start_rss_bytes = currentRssBytes();
+        pageFaults(minor_start, major_start);
+    }
+
+    double  cpu_start = cpuSeconds();
+    int64_t start_ns  = SendCounters::now();
+
+    std::vector<std::thread> senders;
+    for (size_t t = 0; t < config.sender_threads; ++t) {
+        senders.emplace_back([&, t]() {
+            e2sar::Segmenter& segmenter = *segmenters[t % segmenters.size()];
+            size_t f = 0;
+            for (size_t done = 0; nextFile(t, done, f); ++done) {
+                if (config.from_memory) {
+                    if (!replayBatches(segmenter, (*preloaded)[f], state)) {
+                        failed++;
+                        return;
+                    }
+                    continue;
+                }
+                auto proc = makeProcessor(config, args, &segmenter, t);
+                proc->setCounters(&counters[t]);
+                proc->setEnqueueHook([&state](size_t id, int64_t ns) { state.stamp(id, ns); });
+                uint64_t before = counters[t].bytes.load(std::memory_order_relaxed);
+                if (!proc->process(config.files[f], config.tree_name)) {
+                    failed++;
+                    return;
+                }
+                state.bytes_sent.fetch_add(counters[t].bytes.load(std::memory_order_relaxed) - before,
+                                           std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& t : senders)
+        t.join();
+    const uint64_t submitted = global_buffer_id.load();
+
+    // Wait for the reassembler to catch up; stop once it stalls
+    uint64_t seen       = state.buffers_received.load();
+    auto     last_moved = std::chrono::steady_clock::now();
+    while (seen < submitted) {
+        stop.waitFor(std::chrono::milliseconds(10));
+        uint64_t now_seen = state.buffers_received.load();
+        if (now_seen != seen) {
+            seen       = now_seen;
+            last_moved = std::chrono::steady_clock::now();
+        } else if (std::chrono::steady_clock::now() - last_moved >
+                   std::chrono::milliseconds(config.drain_timeout_ms)) {
+            break;
+        }
+    }
+    int64_t end_ns = state.last_recv_ns.load();
+    if (end_ns <= start_ns) end_ns = SendCounters::now();
+    double cpu_end = cpuSeconds();
+    if (config.memory) {
+        result.peak_rss_bytes        = peakRssBytes();
+        result.inflight_peak_bytes   = batch_memory.peakBytes();
+        result.inflight_peak_batches = batch_memory.peakCount();
+        pageFaults(result.minor_faults, result.major_faults);
+        result.minor_faults -= minor_start;
+        result.major_faults -= major_start;
+    }
+
+    stop.trigger();
+    for (auto& t : dequeue)
+        t.join();
+    logFlush();
+
+    uint64_t send_errors = 0;
+    for (auto& seg : segmenters) {
+        send_errors += seg->getSendStats().errCnt;
+        seg->stopThreads();
+    }
+    auto reas_stats = reassembler.getStats();
+    if (proxy) proxy->stop();
+    if (cp) {
+        reassembler.deregisterWorker();
+        cp->stop();
+    }
+    reassembler.stopThreads();
+
+    const size_t event_bytes = config.use_toy ? DalitzEventData{}.size() : GluexEventData{}.size();
+    result.seconds          = (end_ns - start_ns) / 1e9;
+    result.cpu_seconds      = cpu_end - cpu_start;
+    result.buffers_sent     = submitted;
+    result.buffers_received = state.buffers_received.load();
+    result.bytes_sent       = state.bytes_sent.load();
+    result.bytes_received   = state.bytes_received.load();
+    result.events_received  = result.bytes_received / event_bytes;
+    result.send_errors      = send_errors;
+    result.reassembly_loss  = reas_stats.reassemblyLoss;
+    result.enqueue_loss     = reas_stats.enqueueLoss;
+    if (const LBEmulator* data_plane = cp ? &cp->dataPlane() : proxy.get()) {
+        result.impaired_drops = data_plane->counters().impaired_drops.load();
+        result.duplicated     = data_plane->counters().duplicated.load();
+        result.reordered      = data_plane->counters().reordered.load();
+    }
+    for (const auto& h : state.latency)
+        h->addTo(result.latency);
+    result.ok = failed == 0;
+    return result;
+}
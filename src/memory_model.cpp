@@ -0,0 +1,124 @@
+#include "memory_model.hpp"
+#include <algorithm>
+#include <cmath>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+constexpr double MB = 1024.0 * 1024.0;
+
+double rateKey(double rate_gbps) { return rate_gbps > 0 ? rate_gbps : 0.0; }
+
+// Solve the n×n system a·x = b in place (Gaussian elimination, partial
+// pivoting). False if it is singular.
+bool solve(std::vector<std::vector<double>>& a, std::vector<double>& b, std::vector<double>& x) {
+    const size_t n = b.size();
+    for (size_t col = 0; col < n; ++col) {
+        size_t pivot = col;
+        for (size_t r = col + 1; r < n; ++r)
+            if (std::fabs(a[r][col]) > std::fabs(a[pivot][col])) pivot = r;
+        if (std::fabs(a[pivot][col]) < 1e-12) return false;
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+        for (size_t r = col + 1; r < n; ++r) {
+            double f = a[r][col] / a[col][col];
+            for (size_t c = col; c < n; ++c)
+                a[r][c] -= f * a[col][c];
+            b[r] -= f * b[col];
+        }
+    }
+    x.assign(n, 0);
+    for (size_t i = n; i-- > 0;) {
+        double sum = b[i];
+        for (size_t c = i + 1; c < n; ++c)
+            sum -= a[i][c] * x[c];
+        x[i] = sum / a[i][i];
+    }
+    return true;
+}
+
+} // namespace
+
+// ── MemoryModel ──────────────────────────────────────────────────────────────
+
+void MemoryModel::add(const MemorySample& sample) {
+    samples_.push_back(sample);
+    if (sample.threads == 0) return;
+    double& d = depths_[rateKey(sample.rate_gbps)];
+    d = std::max(d, static_cast<double>(sample.inflight_peak_batches) / sample.threads);
+}
+
+bool MemoryModel::fit() {
+    base_ = per_thread_ = per_inflight_ = 0;
+    if (samples_.empty()) return false;
+
+    // Design columns: intercept, then each regressor that varies
+    auto threads  = [](const MemorySample& s) { return static_cast<double>(s.threads); };
+    auto inflight = [](const MemorySample& s) { return static_cast<double>(s.inflight_peak_bytes); };
+    auto varies   = [this](auto column) {
+        for (const auto& s : samples_)
+            if (column(s) != column(samples_.front())) return true;
+        return false;
+    };
+    const bool use_threads  = varies(threads);
+    const bool use_inflight = varies(inflight);
+
+    auto row = [&](const MemorySample& s) {
+        std::vector<double> r{1.0};
+        if (use_threads)  r.push_back(threads(s));
+        if (use_inflight) r.push_back(inflight(s) / MB);   // MB keeps the system well scaled
+        return r;
+    };
+
+    const size_t n = 1 + use_threads + use_inflight;
+    std::vector<std::vector<double>> ata(n, std::vector<double>(n, 0));
+    std::vector<double> aty(n, 0), x;
+    for (const auto& s : samples_) {
+        auto r = row(s);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j)
+                ata[i][j] += r[i] * r[j];
+            aty[i] += r[i] * static_cast<double>(s.peak_rss_bytes);
+        }
+    }
+    if (!solve(ata, aty, x)) {
+        // Collinear regressors (e.g. in-flight memory tracking threads
+        // exactly): fall back to the mean
+        double sum = 0;
+        for (const auto& s : samples_)
+            sum += static_cast<double>(s.peak_rss_bytes);
+        base_ = sum / samples_.size();
+        return true;
+    }
+
+    size_t i = 0;
+    base_ = x[i++];
+    if (use_threads)  per_thread_   = x[i++];
+    if (use_inflight) per_inflight_ = x[i++] / MB;
+    return true;
+}
+
+double MemoryModel::depth(double rate_gbps) const {
+    auto it = depths_.find(rateKey(rate_gbps));
+    if (it != depths_.end()) return it->second;
+    double deepest = 0;
+    for (const auto& [rate, d] : depths_)
+        deepest = std::max(deepest, d);
+    return deepest;
+}
+
+double MemoryModel::predictBytes(size_t threads, size_t bufsize_mb, double rate_gbps) const {
+    double inflight = threads * bufsize_mb * MB * depth(rate_gbps);
+    return base_ + per_thread_ * threads + per_inflight_ * inflight;
+}
+
+double MemoryModel::maxUnderPrediction() const {
+    double worst = 0;
+    for (const auto& s : samples_) {
+        if (s.peak_rss_bytes == 0) continue;
+        double predicted = predictBytes(s.threads, s.bufsize_mb, s.rate_gbps);
+        worst = std::max(worst, (s.peak_rss_bytes - predicted) / s.peak_rss_bytes);
+    }
+    return worst;
+}
@@ -0,0 +1,204 @@
+#include "metrics.hpp"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cinttypes>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// ── AtomicHistogram ──────────────────────────────────────────────────────────
+
+AtomicHistogram::AtomicHistogram(std::vector<uint64_t> bounds)
+    : bounds_(std::move(bounds)),
+      buckets_(new std::atomic<uint64_t>[bounds_.size() + 1]) {
+    for (size_t b = 0; b <= bounds_.size(); ++b)
+        buckets_[b].store(0, std::memory_order_relaxed);
+}
+
+// ── PromText ─────────────────────────────────────────────────────────────────
+
+void PromText::family(const char* name, const char* type, const char* help) {
+    out_ += "# HELP "; out_ += name; out_ += ' '; out_ += help; out_ += '\n';
+    out_ += "# TYPE "; out_ += name; out_ += ' '; out_ += type; out_ += '\n';
+}
+
+void PromText::sample(const char* name, double value, const std::string& labels) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", value);
+    out_ += name;
+    if (!labels.empty()) { out_ += '{'; out_ += labels; out_ += '}'; }
+    out_ += ' '; out_ += buf; out_ += '\n';
+}
+
+void PromText::sample(const char* name, uint64_t value, const std::string& labels) {
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "%" PRIu64, value);
+    out_ += name;
+    if (!labels.empty()) { out_ += '{'; out_ += labels; out_ += '}'; }
+    out_ += ' '; out_ += buf; out_ += '\n';
+}
+
+void PromText::histogram(const char* name, const AtomicHistogram& h, double scale,
+                         const std::string& labels) {
+    const std::string bucket = std::string(name) + "_bucket";
+    const std::string prefix = labels.empty() ? "" : labels + ",";
+    uint64_t cumulative = 0;
+    char le[32];
+    for (size_t b = 0; b < h.bounds().size(); ++b) {
+        cumulative += h.bucket(b);
+        std::snprintf(le, sizeof(le), "%.9g", h.bounds()[b] * scale);
+        sample(bucket.c_str(), cumulative, prefix + "le=\"" + le + "\"");
+    }
+    cumulative += h.bucket(h.bounds().size());
+    sample(bucket.c_str(), cumulative, prefix + "le=\"+Inf\"");
+    sample((std::string(name) + "_sum").c_str(), h.sum() * scale, labels);
+    sample((std::string(name) + "_count").c_str(), cumulative, labels);
+}
+
+void PromText::histogram(const char* name, const LatencyDistribution& d,
+                         const std::vector<uint64_t>& bounds_ns, double scale,
+                         const std::string& labels) {
+    const std::string bucket = std::string(name) + "_bucket";
+    const std::string prefix = labels.empty() ? "" : labels + ",";
+    char le[32];
+    for (uint64_t bound : bounds_ns) {
+        std::snprintf(le, sizeof(le), "%.9g", bound * scale);
+        sample(bucket.c_str(), d.countAtOrBelow(bound), prefix + "le=\"" + le + "\"");
+    }
+    sample(bucket.c_str(), d.count(), prefix + "le=\"+Inf\"");
+    sample((std::string(name) + "_sum").c_str(), d.sum() * scale, labels);
+    sample((std::string(name) + "_count").c_str(), d.count(), labels);
+}
+
+std::string label(const char* key, const std::string& value) {
+    std::string out = key;
+    out += "=\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') out += '\\';
+        if (c == '\n') { out += "\\n"; continue; }
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+
+// ── MetricsServer ────────────────────────────────────────────────────────────
+
+bool MetricsServer::start(const std::string& addr, Collector collector) {
+    size_t colon = addr.rfind(':');
+    if (colon == std::string::npos) {
+        std::cerr << "Error: metrics address '" << addr << "' must be host:port" << std::endl;
+        return false;
+    }
+    std::string host = addr.substr(0, colon);
+    std::string port = addr.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+        host = host.substr(1, host.size() - 2);
+
+    struct addrinfo hints{};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = AI_NUMERICHOST | AI_NUMERICSERV | AI_PASSIVE;
+    struct addrinfo* res = nullptr;
+    int rc = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &res);
+    if (rc != 0) {
+        std::cerr << "Error: metrics address '" << addr << "': " << gai_strerror(rc) << std::endl;
+        return false;
+    }
+
+    listen_fd_ = socket(res->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    if (listen_fd_ < 0 ||
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(listen_fd_, res->ai_addr, res->ai_addrlen) != 0 ||
+        listen(listen_fd_, 16) != 0) {
+        std::cerr << "Error: cannot listen on " << addr << ": " << strerror(errno) << std::endl;
+        freeaddrinfo(res);
+        stop();
+        return false;
+    }
+    freeaddrinfo(res);
+
+    stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stop_fd_ < 0) {
+        std::cerr << "Error: eventfd: " << strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+
+    collector_ = std::move(collector);
+    thread_ = std::thread(&MetricsServer::run, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        ssize_t rc = write(stop_fd_, &one, sizeof(one));
+        (void)rc;
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) close(listen_fd_);
+    if (stop_fd_ >= 0)   close(stop_fd_);
+    listen_fd_ = stop_fd_ = -1;
+}
+
+void MetricsServer::run() {
+    struct pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Metrics server: poll: " << strerror(errno) << std::endl;
+            return;
+        }
+        if (fds[1].revents) return;
+        if (fds[0].revents & POLLIN) {
+            int client = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) continue;
+            serve(client);
+            close(client);
+        }
+    }
+}
+
+void MetricsServer::serve(int client) {
+    // A stalled client must not hold up the next scrape for long
+    struct timeval tv{1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        ssize_t n = recv(client, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        request.append(buf, n);
+    }
+
+    std::string status = "200 OK";
+    std::string body;
+    if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0) {
+        PromText text;
+        collector_(text);
+        body = text.str();
+    } else {
+        status = "404 Not Found";
+        body   = "Not found; metrics are served at /metrics\n";
+    }
+
+    std::string response = "HTTP/1.0 " + status + "\r\n"
+        "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+
+    for (size_t off = 0; off < response.size();) {
+        ssize_t n = send(client, response.data() + off, response.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        off += n;
+    }
+}
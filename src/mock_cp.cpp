@@ -0,0 +1,520 @@
+#include "mock_cp.hpp"
+#include "alloc_stats.hpp"
+#include <grpcpp/grpcpp.h>
+#include <grpc/loadbalancer.grpc.pb.h>   // generated from E2SAR's loadbalancer.proto
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ── Steering ─────────────────────────────────────────────────────────────────
+
+double steeringWeight(double weight, double control_signal, double min_factor, double max_factor) {
+    double factor = 1.0 + control_signal;
+    if (max_factor > 0) factor = std::min(factor, max_factor);
+    if (min_factor > 0) factor = std::max(factor, min_factor);
+    // A worker that is ready keeps a sliver of the calendar even when its
+    // signal says back off, as long as no lower bound was asked for
+    return weight * std::max(factor, 0.01);
+}
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+using grpc::ServerContext;
+using grpc::Status;
+using grpc::StatusCode;
+
+int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t unixNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string hostPort(const std::string& host, uint16_t port) {
+    return (host.find(':') != std::string::npos ? "[" + host + "]" : host) + ":" + std::to_string(port);
+}
+
+// Address family of a numeric IPv4 / IPv6 address, AF_UNSPEC if it is neither
+int familyOf(const std::string& host) {
+    unsigned char buf[sizeof(struct in6_addr)];
+    if (inet_pton(AF_INET, host.c_str(), buf) == 1)  return AF_INET;
+    if (inet_pton(AF_INET6, host.c_str(), buf) == 1) return AF_INET6;
+    return AF_UNSPEC;
+}
+
+// Token from the call's "authorization: Bearer <token>" metadata
+std::string bearerToken(const ServerContext* context) {
+    const auto& metadata = context->client_metadata();
+    auto it = metadata.find("authorization");
+    if (it == metadata.end())
+        return "";
+    std::string value(it->second.data(), it->second.size());
+    const std::string prefix = "Bearer ";
+    return value.rfind(prefix, 0) == 0 ? value.substr(prefix.size()) : value;
+}
+
+// Segmenter sync packet (network byte order):
+//   0-1 "LC"  2 version  3 reserved  4-7 event source id  8-15 event number
+//   16-19 average event rate (Hz)  20-27 Unix time (ns)
+constexpr size_t SYNC_BYTES = 28;
+
+uint64_t readBE(const uint8_t* p, size_t n) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; ++i)
+        v = v << 8 | p[i];
+    return v;
+}
+
+// Calendars whose weights are within this fraction are considered the same
+constexpr double WEIGHT_TOLERANCE = 0.01;
+
+// Workers only ever come from registrations, and the LB strips the header
+LBEmulatorConfig dataPlaneConfig(const MockCPConfig& config) {
+    LBEmulatorConfig data_plane = config.data_plane;
+    data_plane.workers.clear();
+    data_plane.strip_lb_header = false;
+    return data_plane;
+}
+
+} // namespace
+
+// ── gRPC service ─────────────────────────────────────────────────────────────
+
+// The calls E2SAR senders and receivers make. Everything else (reserving
+// and freeing load balancers, status, tokens) is left UNIMPLEMENTED.
+class MockControlPlane::Service final : public loadbalancer::LoadBalancer::Service {
+public:
+    explicit Service(MockControlPlane& cp) : cp_(cp) {}
+
+    Status AddSenders(ServerContext* context, const loadbalancer::AddSendersRequest* request,
+                      loadbalancer::AddSendersReply*) override {
+        Status status = check(context, request->lbid());
+        if (status.ok())
+            cp_.addSenders({request->senderaddresses().begin(), request->senderaddresses().end()});
+        return status;
+    }
+
+    Status RemoveSenders(ServerContext* context, const loadbalancer::RemoveSendersRequest* request,
+                         loadbalancer::RemoveSendersReply*) override {
+        Status status = check(context, request->lbid());
+        if (status.ok())
+            cp_.removeSenders({request->senderaddresses().begin(), request->senderaddresses().end()});
+        return status;
+    }
+
+    Status Register(ServerContext* context, const loadbalancer::RegisterRequest* request,
+                    loadbalancer::RegisterReply* reply) override {
+        Status status = check(context, request->lbid());
+        if (!status.ok())
+            return status;
+        if (request->udpport() == 0 || request->udpport() > 65535 || request->portrange() > 14)
+            return Status(StatusCode::INVALID_ARGUMENT, "udpPort must be 1-65535 and portRange 0-14");
+
+        MockCPWorker worker;
+        worker.name                 = request->name();
+        worker.address.host         = request->ipaddress();
+        worker.address.port         = static_cast<uint16_t>(request->udpport());
+        worker.address.ports        = static_cast<uint16_t>(1u << request->portrange());
+        worker.address.strip_lb_header = true;
+        worker.weight               = request->weight() > 0 ? request->weight() : 1.0;
+        worker.min_factor           = request->minfactor();
+        worker.max_factor           = request->maxfactor();
+
+        std::string session_id, token, error;
+        if (!cp_.registerWorker(std::move(worker), session_id, token, error))
+            return Status(StatusCode::INVALID_ARGUMENT, error);
+        reply->set_sessionid(session_id);
+        reply->set_token(token);
+        return Status::OK;
+    }
+
+    Status Deregister(ServerContext* context, const loadbalancer::DeregisterRequest* request,
+                      loadbalancer::DeregisterReply*) override {
+        std::string error;
+        if (!cp_.authorized(bearerToken(context)))
+            return Status(StatusCode::UNAUTHENTICATED, "invalid token");
+        if (!cp_.deregisterWorker(request->sessionid(), error))
+            return Status(StatusCode::NOT_FOUND, error);
+        return Status::OK;
+    }
+
+    Status SendState(ServerContext* context, const loadbalancer::SendStateRequest* request,
+                     loadbalancer::SendStateReply*) override {
+        std::string error;
+        if (!cp_.authorized(bearerToken(context)))
+            return Status(StatusCode::UNAUTHENTICATED, "invalid token");
+        int64_t sent_ns = request->has_timestamp()
+            ? request->timestamp().seconds() * 1000000000LL + request->timestamp().nanos()
+            : 0;
+        if (!cp_.reportState(request->sessionid(), request->fillpercent(), request->controlsignal(),
+                             request->isready(), sent_ns, error))
+            return Status(StatusCode::NOT_FOUND, error);
+        return Status::OK;
+    }
+
+    Status Version(ServerContext* context, const loadbalancer::VersionRequest*,
+                   loadbalancer::VersionReply* reply) override {
+        if (!cp_.authorized(bearerToken(context)))
+            return Status(StatusCode::UNAUTHENTICATED, "invalid token");
+        reply->set_commit("e2sar-mock-cp");
+        reply->set_build("mock");
+        reply->set_compattag("mock");
+        return Status::OK;
+    }
+
+private:
+    Status check(const ServerContext* context, const std::string& lb_id) const {
+        if (!cp_.authorized(bearerToken(context)))
+            return Status(StatusCode::UNAUTHENTICATED, "invalid token");
+        if (lb_id != cp_.config_.lb_id)
+            return Status(StatusCode::NOT_FOUND, "no load balancer '" + lb_id + "'");
+        return Status::OK;
+    }
+
+    MockControlPlane& cp_;
+};
+
+// ── Control plane ────────────────────────────────────────────────────────────
+
+MockControlPlane::MockControlPlane(MockCPConfig config)
+    : config_(std::move(config)), data_plane_(dataPlaneConfig(config_)) {}
+
+MockControlPlane::~MockControlPlane() {
+    stop();
+}
+
+bool MockControlPlane::start() {
+    if (!config_.state_log.empty()) {
+        state_log_.open(config_.state_log);
+        if (!state_log_) {
+            std::cerr << "Error: cannot write " << config_.state_log << std::endl;
+            return false;
+        }
+        state_log_ << "time_s,session,name,fill_percent,control_signal,ready,report_age_ms\n";
+    }
+    started_ns_ = steadyNs();
+
+    if (!data_plane_.start())
+        return false;
+
+    stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct addrinfo hints{};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags    = AI_NUMERICHOST | AI_NUMERICSERV;
+    struct addrinfo* res = nullptr;
+    if (stop_fd_ < 0 ||
+        getaddrinfo(config_.data_plane.listen_ip.c_str(), std::to_string(config_.sync_port).c_str(),
+                    &hints, &res) != 0) {
+        std::cerr << "Error: cannot set up the sync listener on "
+                  << hostPort(config_.data_plane.listen_ip, config_.sync_port) << std::endl;
+        stop();
+        return false;
+    }
+    sync_fd_ = socket(res->ai_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (sync_fd_ < 0 || bind(sync_fd_, res->ai_addr, res->ai_addrlen) != 0) {
+        std::cerr << "Error: cannot listen for sync packets on "
+                  << hostPort(config_.data_plane.listen_ip, config_.sync_port) << ": " << strerror(errno)
+                  << std::endl;
+        freeaddrinfo(res);
+        stop();
+        return false;
+    }
+    freeaddrinfo(res);
+
+    service_ = std::make_unique<Service>(*this);
+    grpc::ServerBuilder builder;
+    int bound_port = 0;
+    builder.AddListeningPort(hostPort(config_.cp_ip, config_.cp_port), grpc::InsecureServerCredentials(),
+                             &bound_port);
+    builder.RegisterService(service_.get());
+    server_ = builder.BuildAndStart();
+    if (!server_ || bound_port == 0) {
+        std::cerr << "Error: cannot start the gRPC server on " << hostPort(config_.cp_ip, config_.cp_port)
+                  << std::endl;
+        stop();
+        return false;
+    }
+
+    epoch_thread_ = std::thread(&MockControlPlane::epochLoop, this);
+    sync_thread_  = std::thread(&MockControlPlane::syncLoop, this, sync_fd_);
+    return true;
+}
+
+void MockControlPlane::stop() {
+    if (server_) {
+        server_->Shutdown();
+        server_.reset();
+    }
+    if (stop_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t rc = write(stop_fd_, &one, sizeof(one));
+        (void)rc;
+    }
+    if (epoch_thread_.joinable()) epoch_thread_.join();
+    if (sync_thread_.joinable())  sync_thread_.join();
+    data_plane_.stop();
+    if (sync_fd_ >= 0) close(sync_fd_);
+    if (stop_fd_ >= 0) close(stop_fd_);
+    sync_fd_ = stop_fd_ = -1;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_log_.is_open())
+        state_log_.close();
+}
+
+std::string MockControlPlane::uri() const {
+    const std::string& data_ip = config_.data_plane.listen_ip;
+    return "ejfat://" + (config_.token.empty() ? std::string("mock") : config_.token) + "@" +
+           hostPort(config_.cp_ip, config_.cp_port) + "/lb/" + config_.lb_id +
+           "?sync=" + hostPort(data_ip, config_.sync_port) +
+           "&data=" + hostPort(data_ip, config_.data_plane.listen_port);
+}
+
+// ── Handlers ─────────────────────────────────────────────────────────────────
+
+bool MockControlPlane::authorized(const std::string& bearer) const {
+    if (config_.token.empty() || bearer == config_.token)
+        return true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : workers_)
+        if (entry.second.token == bearer)
+            return true;
+    return false;
+}
+
+void MockControlPlane::addSenders(const std::vector<std::string>& addresses) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& a : addresses)
+        if (std::find(senders_.begin(), senders_.end(), a) == senders_.end())
+            senders_.push_back(a);
+}
+
+void MockControlPlane::removeSenders(const std::vector<std::string>& addresses) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& a : addresses)
+        senders_.erase(std::remove(senders_.begin(), senders_.end(), a), senders_.end());
+}
+
+bool MockControlPlane::registerWorker(MockCPWorker worker, std::string& session_id, std::string& token,
+                                      std::string& error) {
+    int family = familyOf(worker.address.host);
+    if (family == AF_UNSPEC) {
+        error = "ipAddress '" + worker.address.host + "' is not a numeric IPv4 or IPv6 address";
+        return false;
+    }
+    if (family != familyOf(config_.data_plane.listen_ip)) {
+        error = "ipAddress '" + worker.address.host + "' is not in the data address family";
+        return false;
+    }
+    if (worker.address.port + worker.address.ports - 1 > 65535) {
+        error = "port range exceeds 65535";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    session_id           = std::to_string(next_session_++);
+    token                = "session-" + session_id;
+    worker.session_id    = session_id;
+    worker.token         = token;
+    worker.registered_ns = steadyNs();
+    workers_.emplace(session_id, std::move(worker));
+    return true;
+}
+
+bool MockControlPlane::deregisterWorker(const std::string& session_id, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (workers_.erase(session_id) == 0) {
+        error = "no session '" + session_id + "'";
+        return false;
+    }
+    // Straight away, so nothing more is sent to a receiver that is going
+    rebalanceLocked(steadyNs());
+    return true;
+}
+
+bool MockControlPlane::reportState(const std::string& session_id, double fill_percent, double control_signal,
+                                   bool ready, int64_t report_unix_ns, std::string& error) {
+    const int64_t now = steadyNs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = workers_.find(session_id);
+    if (it == workers_.end()) {
+        error = "no session '" + session_id + "'";
+        return false;
+    }
+    MockCPWorker& w  = it->second;
+    w.fill_percent   = fill_percent;
+    w.control_signal = control_signal;
+    w.ready          = ready;
+    w.reports++;
+    w.last_report_ns = now;
+    w.report_age_ms  = report_unix_ns > 0 ? (unixNs() - report_unix_ns) / 1e6 : 0;
+    if (ready && w.ready_ns == 0)
+        w.ready_ns = now;
+
+    if (state_log_.is_open()) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%.6f,%s,%s,%.4f,%.6f,%d,%.3f\n", (now - started_ns_) / 1e9,
+                      w.session_id.c_str(), w.name.c_str(), fill_percent, control_signal, ready ? 1 : 0,
+                      w.report_age_ms);
+        state_log_ << line;
+    }
+    return true;
+}
+
+// ── Epochs ───────────────────────────────────────────────────────────────────
+
+bool MockControlPlane::rebalance() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rebalanceLocked(steadyNs());
+}
+
+bool MockControlPlane::rebalanceLocked(int64_t now_ns) {
+    const int64_t timeout_ns = static_cast<int64_t>(config_.state_timeout_ms) * 1000000;
+
+    std::vector<LBWorker> routed;
+    std::vector<std::shared_ptr<LBWorkerCounters>> counters;
+    std::vector<std::pair<std::string, double>> next;
+    for (const auto& entry : workers_) {
+        const MockCPWorker& w = entry.second;
+        if (!w.ready || now_ns - w.last_report_ns > timeout_ns)
+            continue;
+        LBWorker address = w.address;
+        address.weight   = steeringWeight(w.weight, w.control_signal, w.min_factor, w.max_factor);
+        next.emplace_back(w.session_id, address.weight);
+        routed.push_back(address);
+        counters.push_back(w.counters);
+    }
+
+    // Same workers at about the same weights: keep the calendar (and epoch)
+    bool same = next.size() == installed_.size();
+    for (size_t i = 0; same && i < next.size(); ++i)
+        same = next[i].first == installed_[i].first &&
+               std::fabs(next[i].second - installed_[i].second) <= WEIGHT_TOLERANCE * installed_[i].second;
+    if (same)
+        return false;
+    if (!data_plane_.setWorkers(std::move(routed), std::move(counters)))
+        return false;
+
+    installed_ = std::move(next);
+    for (auto& entry : workers_)
+        entry.second.slot_weight = 0;
+    for (const auto& [session_id, weight] : installed_) {
+        MockCPWorker& w = workers_.at(session_id);
+        w.slot_weight   = weight;
+        if (w.routed_ns == 0)
+            w.routed_ns = now_ns;
+    }
+    return true;
+}
+
+void MockControlPlane::epochLoop() {
+    struct pollfd pfd{stop_fd_, POLLIN, 0};
+    while (true) {
+        int rc = poll(&pfd, 1, std::max(config_.epoch_ms, 1));
+        if (rc > 0 || (rc < 0 && errno != EINTR))
+            return;
+        if (rc == 0)
+            rebalance();
+    }
+}
+
+void MockControlPlane::syncLoop(int fd) {
+    struct pollfd fds[2] = {{fd, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+    uint8_t packet[64];
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (fds[1].revents) return;
+        ssize_t len = recv(fd, packet, sizeof(packet), MSG_DONTWAIT);
+        if (len < static_cast<ssize_t>(SYNC_BYTES) || packet[0] != 'L' || packet[1] != 'C')
+            continue;
+        uint32_t src_id = static_cast<uint32_t>(readBE(packet + 4, 4));
+        std::lock_guard<std::mutex> lock(mutex_);
+        MockCPSyncSource& s = sync_sources_[src_id];
+        s.src_id     = src_id;
+        s.packets++;
+        s.last_event = readBE(packet + 8, 8);
+        s.rate_hz    = static_cast<uint32_t>(readBE(packet + 16, 4));
+    }
+}
+
+// ── Reporting ────────────────────────────────────────────────────────────────
+
+std::vector<MockCPWorker> MockControlPlane::workers() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<MockCPWorker> out;
+    for (const auto& entry : workers_)
+        out.push_back(entry.second);
+    return out;
+}
+
+std::vector<std::string> MockControlPlane::senders() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return senders_;
+}
+
+std::vector<MockCPSyncSource> MockControlPlane::syncSources() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<MockCPSyncSource> out;
+    for (const auto& entry : sync_sources_)
+        out.push_back(entry.second);
+    return out;
+}
+
+void MockControlPlane::printSummary(std::ostream& out) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const LBCalendar calendar = data_plane_.calendar();
+        out << "Mock CP: lb " << config_.lb_id << ", epoch " << data_plane_.epoch() << ", "
+            << workers_.size() << " worker(s), " << senders_.size() << " sender(s)\n";
+        auto sinceRegister = [](int64_t t, int64_t registered) {
+            char buf[32];
+            if (t == 0) return std::string("-");
+            std::snprintf(buf, sizeof(buf), "%.1fms", (t - registered) / 1e6);
+            return std::string(buf);
+        };
+        for (const auto& entry : workers_) {
+            const MockCPWorker& w = entry.second;
+            size_t slots = 0;
+            for (size_t i = 0; i < installed_.size(); ++i)
+                if (installed_[i].first == w.session_id)
+                    slots = calendar.slotsFor(i);
+            char line[512];
+            std::snprintf(line, sizeof(line),
+                          "  session %s  %s  %s x%u  weight %.2f -> %.2f  slots %zu/%zu  fill %.1f%%  "
+                          "ctrl %+.3f  %s  reports %lu  frames %lu  ready %s  routed %s\n",
+                          w.session_id.c_str(), w.name.c_str(), hostPort(w.address.host, w.address.port).c_str(),
+                          static_cast<unsigned>(w.address.ports), w.weight, w.slot_weight, slots,
+                          calendar.size(), 100.0 * w.fill_percent, w.control_signal,
+                          w.ready ? "ready" : "not ready", static_cast<unsigned long>(w.reports),
+                          static_cast<unsigned long>(w.counters->frames.load()),
+                          sinceRegister(w.ready_ns, w.registered_ns).c_str(),
+                          sinceRegister(w.routed_ns, w.registered_ns).c_str());
+            out << line;
+        }
+        for (const auto& s : senders_)
+            out << "  sender " << s << "\n";
+        for (const auto& entry : sync_sources_)
+            out << "  sync source " << entry.second.src_id << ": " << entry.second.packets
+                << " packets, last event " << entry.second.last_event << ", " << entry.second.rate_hz
+                << " Hz\n";
+    }
+    data_plane_.printSummary(out);
+}
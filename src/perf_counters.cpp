@@ -0,0 +1,135 @@
+#include "perf_counters.hpp"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+struct EventSpec {
+    const char* name;
+    uint32_t    type;
+    uint64_t    config;
+};
+
+constexpr uint64_t cacheMiss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+// Indexed by PerfEvent
+const EventSpec EVENTS[PERF_EVENT_COUNT] = {
+    {"cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"LLC-misses",    PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL)},
+    {"dTLB-misses",   PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB)},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+int openEvent(const EventSpec& spec, int group_fd) {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = spec.type;
+    attr.config         = spec.config;
+    attr.disabled       = group_fd < 0;   // the leader starts the whole group
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                          PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+
+std::atomic<bool> warned{false};
+
+} // namespace
+
+// ── PerfCounterGroup ─────────────────────────────────────────────────────────
+
+PerfCounterGroup::~PerfCounterGroup() {
+    for (int fd : fds_)
+        if (fd >= 0) close(fd);
+}
+
+bool PerfCounterGroup::open() {
+    fds_[PERF_CYCLES] = openEvent(EVENTS[PERF_CYCLES], -1);
+    if (fds_[PERF_CYCLES] < 0) {
+        if (!warned.exchange(true))
+            std::cerr << "Warning: hardware counters unavailable: " << strerror(errno)
+                      << " (check /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+        return false;
+    }
+    slot_[PERF_CYCLES] = members_++;
+    available_         = 1u << PERF_CYCLES;
+
+    for (int e = PERF_CYCLES + 1; e < PERF_EVENT_COUNT; ++e) {
+        fds_[e] = openEvent(EVENTS[e], fds_[PERF_CYCLES]);
+        if (fds_[e] < 0) continue;
+        slot_[e]    = members_++;
+        available_ |= 1u << e;
+    }
+
+    ioctl(fds_[PERF_CYCLES], PERF_EVENT_IOC_RESET,  PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+bool PerfCounterGroup::read(PerfReading& out) const {
+    // nr, time_enabled, time_running, then one value per member
+    uint64_t buf[3 + PERF_EVENT_COUNT];
+    ssize_t n = ::read(fds_[PERF_CYCLES], buf, sizeof(buf));
+    if (n < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buf[2] == 0)
+        return false;
+
+    const double scale = static_cast<double>(buf[1]) / buf[2];
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        out.value[e] = (available_ & (1u << e)) ? static_cast<uint64_t>(buf[3 + slot_[e]] * scale) : 0;
+    return true;
+}
+
+// ── PerfStageTotals ──────────────────────────────────────────────────────────
+
+void PerfStageTotals::add(const PerfCounterGroup& group, const PerfReading& before,
+                          const PerfReading& after) {
+    samples_.fetch_add(1, std::memory_order_relaxed);
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        if (after.value[e] > before.value[e])
+            value_[e].fetch_add(after.value[e] - before.value[e], std::memory_order_relaxed);
+    available_.fetch_or(group.available(), std::memory_order_relaxed);
+}
+
+// ── PerfSummary ──────────────────────────────────────────────────────────────
+
+void PerfSummary::merge(const PerfStageTotals& t) {
+    samples += t.samples();
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e)
+        value[e] += t.value(static_cast<PerfEvent>(e));
+    available |= t.available();
+}
+
+std::string PerfSummary::summary() const {
+    if (samples == 0) return "no samples";
+
+    std::string out;
+    char buf[64];
+    if ((available & (1u << PERF_INSTRUCTIONS)) && value[PERF_CYCLES] > 0) {
+        std::snprintf(buf, sizeof(buf), "IPC=%.2f ",
+                      static_cast<double>(value[PERF_INSTRUCTIONS]) / value[PERF_CYCLES]);
+        out += buf;
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (available & (1u << e))
+            std::snprintf(buf, sizeof(buf), "%s=%.1f ", EVENTS[e].name,
+                          static_cast<double>(value[e]) / samples);
+        else
+            std::snprintf(buf, sizeof(buf), "%s=n/a ", EVENTS[e].name);
+        out += buf;
+    }
+    out += "per event (n=" + std::to_string(samples) + ")";
+    return out;
+}
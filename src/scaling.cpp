@@ -0,0 +1,58 @@
+#include "scaling.hpp"
+
+// ── Modes ────────────────────────────────────────────────────────────────────
+
+bool parseScalingMode(const std::string& text, ScalingMode& mode) {
+    if (text == "strong") {
+        mode = ScalingMode::Strong;
+        return true;
+    }
+    if (text == "weak") {
+        mode = ScalingMode::Weak;
+        return true;
+    }
+    return false;
+}
+
+const char* scalingModeName(ScalingMode mode) {
+    switch (mode) {
+        case ScalingMode::Strong: return "strong";
+        case ScalingMode::Weak:   return "weak";
+        default:                  return "none";
+    }
+}
+
+// ── ScalingCurve ─────────────────────────────────────────────────────────────
+
+void ScalingCurve::add(size_t threads, double gbps) {
+    Sum& sum = sums_[threads];
+    sum.gbps += gbps;
+    sum.trials++;
+}
+
+std::vector<ScalingPoint> ScalingCurve::points() const {
+    std::vector<ScalingPoint> out;
+    for (const auto& [threads, sum] : sums_) {
+        ScalingPoint p;
+        p.threads = threads;
+        p.trials  = sum.trials;
+        p.gbps    = sum.gbps / sum.trials;
+        out.push_back(p);
+    }
+    if (out.empty())
+        return out;
+
+    const ScalingPoint base = out.front();
+    for (auto& p : out) {
+        p.speedup    = base.gbps > 0 ? p.gbps / base.gbps : 0.0;
+        p.efficiency = p.speedup * base.threads / p.threads;
+    }
+    return out;
+}
+
+size_t ScalingCurve::knee(double threshold) const {
+    for (const auto& p : points())
+        if (p.efficiency < threshold)
+            return p.threads;
+    return 0;
+}
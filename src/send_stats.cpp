@@ -0,0 +1,238 @@
+#include "send_stats.hpp"
+#include "alloc_stats.hpp"
+#include <iostream>
+#include <iomanip>
+
+// ── File-local helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+struct Stage {
+    const char*                      key;
+    const char*                      title;
+    LatencyHistogram SendCounters::* histogram;
+};
+
+const Stage STAGES[] = {
+    {"get_entry",     "GetEntry (per entry)",     &SendCounters::get_entry_ns},
+    {"serialize",     "Serialize (per batch)",    &SendCounters::serialize_ns},
+    {"send_wait",     "addToSendQueue wait",      &SendCounters::send_wait_ns},
+    {"queue_to_free", "Queue to free callback",   &SendCounters::queue_to_free_ns},
+};
+
+} // namespace
+
+SendStatsReporter::SendStatsReporter(const std::vector<std::string>& files,
+                                     const SendCounters* counters,
+                                     e2sar::Segmenter* segmenter)
+    : files_(files), counters_(counters), segmenter_(segmenter),
+      start_(std::chrono::steady_clock::now()) {}
+
+bool SendStatsReporter::start(const std::string& path, int interval_ms) {
+    if (!out_.open(path))
+        return false;
+    thread_ = std::thread(&SendStatsReporter::run, this, std::chrono::milliseconds(interval_ms));
+    return true;
+}
+
+void SendStatsReporter::finish() {
+    if (!out_.isOpen()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable())
+        thread_.join();
+    writeRecord(true);
+    out_.close();
+}
+
+LatencyDistribution SendStatsReporter::mergeStage(LatencyHistogram SendCounters::* stage) const {
+    LatencyDistribution merged;
+    for (size_t i = 0; i < files_.size(); ++i)
+        (counters_[i].*stage).addTo(merged);
+    return merged;
+}
+
+void SendStatsReporter::printLatency(std::ostream& out) const {
+    out << "\nLatency (all files):" << std::endl;
+    for (const auto& stage : STAGES)
+        out << "  " << std::left << std::setw(26) << (std::string(stage.title) + ":")
+            << mergeStage(stage.histogram).summary() << std::endl;
+    out << std::right;
+}
+
+void SendStatsReporter::printPerfCounters(std::ostream& out) const {
+    struct { const char* title; PerfStageTotals SendCounters::* totals; } stages[] = {
+        {"Read (GetEntry)",        &SendCounters::perf_read},
+        {"Convert (appendEntry)",  &SendCounters::perf_convert},
+        {"Enqueue (per batch)",    &SendCounters::perf_enqueue},
+    };
+    out << "\nHardware counters (all files, user space):" << std::endl;
+    for (const auto& stage : stages) {
+        PerfSummary merged;
+        for (size_t i = 0; i < files_.size(); ++i)
+            merged.merge(counters_[i].*stage.totals);
+        out << "  " << std::left << std::setw(26) << (std::string(stage.title) + ":")
+            << merged.summary() << std::endl;
+    }
+    out << std::right;
+}
+
+void SendStatsReporter::printMemory(std::ostream& out) const {
+    out << "\nMemory:" << std::endl;
+    out << "  Batches:     " << batch_memory.summary() << std::endl;
+    out << "  Process RSS: " << formatBytes(currentRssBytes())
+        << " (peak " << formatBytes(peakRssBytes()) << ")" << std::endl;
+}
+
+void SendStatsReporter::run(std::chrono::milliseconds interval) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, interval, [this] { return stopping_; }))
+        writeRecord(false);
+}
+
+void SendStatsReporter::writeRecord(bool final) {
+    json_.clear();
+    buildRecord(json_, final);
+    out_.write(json_);
+}
+
+void SendStatsReporter::buildRecord(JsonWriter& json, bool final) const {
+    const int64_t now = SendCounters::now();
+    auto gbps = [](uint64_t bytes, int64_t ns) { return ns > 0 ? bytes * 8.0 / ns : 0.0; };
+
+    uint64_t events = 0, batches = 0, bytes = 0, retries = 0, backpressure_ns = 0;
+    int64_t  first_start = 0;
+
+    beginStatsRecord(json, "sender", final, start_);
+    json.beginArray("files");
+    for (size_t i = 0; i < files_.size(); ++i) {
+        const SendCounters& c = counters_[i];
+        uint64_t f_events  = c.events.load(std::memory_order_relaxed);
+        uint64_t f_batches = c.batches.load(std::memory_order_relaxed);
+        uint64_t f_bytes   = c.bytes.load(std::memory_order_relaxed);
+        uint64_t f_retries = c.retries.load(std::memory_order_relaxed);
+        uint64_t f_bp_ns   = c.backpressure_ns.load(std::memory_order_relaxed);
+        int64_t  f_start   = c.start_ns.load(std::memory_order_relaxed);
+        int64_t  f_end     = c.end_ns.load(std::memory_order_relaxed);
+        int64_t  f_elapsed = f_start ? (f_end ? f_end : now) - f_start : 0;
+
+        // One thread per file: these are also the per-thread figures
+        json.beginObject()
+             .field("thread", static_cast<uint64_t>(i))
+             .field("path", files_[i])
+             .field("done", f_end != 0)
+             .field("events", f_events)
+             .field("batches", f_batches)
+             .field("bytes", f_bytes)
+             .field("gbps", gbps(f_bytes, f_elapsed))
+             .field("retries", f_retries)
+             .field("backpressure_s", f_bp_ns / 1e9)
+             .endObject();
+
+        events += f_events;  batches += f_batches;  bytes += f_bytes;
+        retries += f_retries;  backpressure_ns += f_bp_ns;
+        if (f_start && (!first_start || f_start < first_start))
+            first_start = f_start;
+    }
+    json.endArray();
+
+    json.beginObject("totals")
+         .field("events", events)
+         .field("batches", batches)
+         .field("bytes", bytes)
+         .field("buffers_submitted", static_cast<uint64_t>(global_buffer_id.load()))
+         .field("gbps", gbps(bytes, first_start ? now - first_start : 0))
+         .field("retries", retries)
+         .field("backpressure_s", backpressure_ns / 1e9)
+         .endObject();
+
+    json.beginObject("latency_ns");
+    for (const auto& stage : STAGES) {
+        LatencyDistribution d = mergeStage(stage.histogram);
+        json.beginObject(stage.key)
+            .field("count", d.count())
+            .field("p50", d.percentile(0.50))
+            .field("p99", d.percentile(0.99))
+            .field("p99_9", d.percentile(0.999))
+            .field("max", d.max())
+            .endObject();
+    }
+    json.endObject();
+
+    if (alloc_accounting.load(std::memory_order_relaxed)) {
+        json.beginObject("memory")
+            .field("rss", currentRssBytes())
+            .field("peak_rss", peakRssBytes());
+        batch_memory.addTo(json, "batches");
+        json.endObject();
+    }
+
+    if (segmenter_) {
+        auto send_stats = segmenter_->getSendStats();
+        json.beginObject("segmenter")
+             .field("msg_cnt", static_cast<uint64_t>(send_stats.msgCnt))
+             .field("err_cnt", static_cast<uint64_t>(send_stats.errCnt))
+             .endObject();
+    }
+    json.endObject();
+}
+
+void SendStatsReporter::writeMetrics(PromText& out) const {
+    auto per_file = [&](const char* name, const char* type, const char* help, auto value) {
+        out.family(name, type, help);
+        for (size_t i = 0; i < files_.size(); ++i)
+            out.sample(name, value(counters_[i]), label("file", std::to_string(i)));
+    };
+    auto load = [](const std::atomic<uint64_t>& a) { return a.load(std::memory_order_relaxed); };
+
+    out.family("e2sar_sender_file_info", "gauge", "Input file handled by each file thread");
+    for (size_t i = 0; i < files_.size(); ++i)
+        out.sample("e2sar_sender_file_info", uint64_t{1},
+                   label("file", std::to_string(i)) + "," + label("path", files_[i]));
+
+    per_file("e2sar_sender_events_total", "counter", "Physics events queued for sending",
+             [&](const SendCounters& c) { return load(c.events); });
+    per_file("e2sar_sender_batches_total", "counter", "Batches (EJFAT events) queued for sending",
+             [&](const SendCounters& c) { return load(c.batches); });
+    per_file("e2sar_sender_bytes_total", "counter", "Bytes queued for sending",
+             [&](const SendCounters& c) { return load(c.bytes); });
+    per_file("e2sar_sender_retries_total", "counter", "addToSendQueue retries on a full queue",
+             [&](const SendCounters& c) { return load(c.retries); });
+    per_file("e2sar_sender_backpressure_seconds_total", "counter", "Time spent retrying a full send queue",
+             [&](const SendCounters& c) { return load(c.backpressure_ns) / 1e9; });
+    per_file("e2sar_sender_file_done", "gauge", "1 once the file thread has finished",
+             [&](const SendCounters& c) {
+                 return uint64_t{c.end_ns.load(std::memory_order_relaxed) != 0};
+             });
+
+    static const std::vector<uint64_t> wait_bounds = {10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+    out.family("e2sar_sender_send_wait_seconds", "histogram", "Time per batch spent in addToSendQueue");
+    for (size_t i = 0; i < files_.size(); ++i) {
+        LatencyDistribution wait;
+        counters_[i].send_wait_ns.addTo(wait);
+        out.histogram("e2sar_sender_send_wait_seconds", wait, wait_bounds, 1e-9,
+                      label("file", std::to_string(i)));
+    }
+
+    out.family("e2sar_sender_inflight_buffers", "gauge", "Batches queued in the segmenter, not yet released");
+    out.sample("e2sar_sender_inflight_buffers", load(inflight_buffers));
+    out.family("e2sar_sender_inflight_bytes", "gauge", "Bytes held by batches queued in the segmenter");
+    out.sample("e2sar_sender_inflight_bytes", load(inflight_bytes));
+
+    if (alloc_accounting.load(std::memory_order_relaxed)) {
+        batch_memory.addTo(out, "e2sar_sender_batch", "batches");
+        out.family("e2sar_process_resident_bytes", "gauge", "Resident set size");
+        out.sample("e2sar_process_resident_bytes", currentRssBytes());
+    }
+
+    if (segmenter_) {
+        auto send_stats = segmenter_->getSendStats();
+        out.family("e2sar_segmenter_frames_total", "counter", "Network frames sent by the segmenter");
+        out.sample("e2sar_segmenter_frames_total", static_cast<uint64_t>(send_stats.msgCnt));
+        out.family("e2sar_segmenter_errors_total", "counter", "Segmenter send errors");
+        out.sample("e2sar_segmenter_errors_total", static_cast<uint64_t>(send_stats.errCnt));
+    }
+}
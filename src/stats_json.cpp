@@ -0,0 +1,134 @@
+#include "stats_json.hpp"
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <cinttypes>
+
+// ── JsonWriter ───────────────────────────────────────────────────────────────
+
+void JsonWriter::separate(const char* key) {
+    if (!first_.empty()) {
+        if (!first_.back()) out_ += ',';
+        first_.back() = false;
+    }
+    if (key) {
+        out_ += '"';
+        out_ += key;
+        out_ += "\":";
+    }
+}
+
+JsonWriter& JsonWriter::beginObject(const char* key) {
+    separate(key);
+    out_ += '{';
+    first_.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    out_ += '}';
+    first_.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray(const char* key) {
+    separate(key);
+    out_ += '[';
+    first_.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    out_ += ']';
+    first_.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, uint64_t value) {
+    separate(key);
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "%" PRIu64, value);
+    out_ += buf;
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, double value) {
+    separate(key);
+    if (!std::isfinite(value)) {
+        out_ += "null";
+        return *this;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6g", value);
+    out_ += buf;
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, bool value) {
+    separate(key);
+    out_ += value ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, const std::string& value) {
+    separate(key);
+    out_ += '"';
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"':  out_ += "\\\""; break;
+            case '\\': out_ += "\\\\"; break;
+            case '\n': out_ += "\\n";  break;
+            case '\t': out_ += "\\t";  break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out_ += buf;
+                } else {
+                    out_ += static_cast<char>(c);
+                }
+        }
+    }
+    out_ += '"';
+    return *this;
+}
+
+void beginStatsRecord(JsonWriter& json, const char* kind, bool final,
+                      std::chrono::steady_clock::time_point start) {
+    auto wall = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    json.beginObject()
+        .field("record", kind)
+        .field("final", final)
+        .field("unix_ms", static_cast<uint64_t>(wall))
+        .field("elapsed_s", elapsed);
+}
+
+// ── JsonLinesFile ────────────────────────────────────────────────────────────
+
+bool JsonLinesFile::open(const std::string& path) {
+    close();
+    fp_ = std::fopen(path.c_str(), "w");
+    if (!fp_) {
+        std::cerr << "Error creating stats file " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::setvbuf(fp_, nullptr, _IOFBF, 1 << 16);
+    return true;
+}
+
+void JsonLinesFile::write(const JsonWriter& record) {
+    if (!fp_) return;
+    std::fwrite(record.str().data(), 1, record.str().size(), fp_);
+    std::fputc('\n', fp_);
+    std::fflush(fp_);
+}
+
+void JsonLinesFile::close() {
+    if (fp_)
+        std::fclose(fp_);
+    fp_ = nullptr;
+}
@@ -0,0 +1,54 @@
+#include "stats_series.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cinttypes>
+
+bool CounterSeries::open(const std::string& path, const std::vector<std::string>& columns) {
+    close();
+    fp_ = std::fopen(path.c_str(), "w");
+    if (!fp_) {
+        std::cerr << "Error creating stats file " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::setvbuf(fp_, nullptr, _IOFBF, 1 << 16);
+
+    std::fputs("unix_ms,elapsed_s", fp_);
+    for (const auto& c : columns)
+        std::fprintf(fp_, ",%s,%s_per_s", c.c_str(), c.c_str());
+    std::fputc('\n', fp_);
+    std::fflush(fp_);
+
+    n_columns_ = columns.size();
+    prev_.assign(n_columns_, 0);
+    start_ = last_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+void CounterSeries::sample(const std::vector<uint64_t>& values) {
+    if (!fp_ || values.size() != n_columns_) return;
+
+    auto now   = std::chrono::steady_clock::now();
+    auto wall  = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    double dt      = std::chrono::duration<double>(now - last_).count();
+    double elapsed = std::chrono::duration<double>(now - start_).count();
+
+    std::fprintf(fp_, "%lld,%.3f", static_cast<long long>(wall), elapsed);
+    for (size_t i = 0; i < n_columns_; ++i) {
+        // Counters only grow, but guard against a source that was reset.
+        double rate = (dt > 0 && values[i] >= prev_[i]) ? (values[i] - prev_[i]) / dt : 0.0;
+        std::fprintf(fp_, ",%" PRIu64 ",%.1f", values[i], rate);
+    }
+    std::fputc('\n', fp_);
+    std::fflush(fp_);
+
+    prev_ = values;
+    last_ = now;
+}
+
+void CounterSeries::close() {
+    if (fp_)
+        std::fclose(fp_);
+    fp_ = nullptr;
+}
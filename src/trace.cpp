@@ -0,0 +1,139 @@
+#include "trace.hpp"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+
+namespace trace {
+
+namespace detail {
+std::atomic<bool> enabled{false};
+}
+
+// ── Per-thread rings ─────────────────────────────────────────────────────────
+
+namespace {
+
+struct ThreadRing {
+    int                   tid;
+    std::string           name;
+    std::unique_ptr<Event[]> events;     // default-initialized: untouched until written
+    size_t                size = 0;
+    std::atomic<uint64_t> written{0};   // total ever recorded; slot = written % size
+};
+
+std::mutex                               rings_mutex;
+std::vector<std::unique_ptr<ThreadRing>> rings;
+size_t                                   ring_capacity = 0;
+int64_t                                  origin_ns     = 0;
+
+thread_local ThreadRing* local_ring = nullptr;
+
+ThreadRing& localRing() {
+    if (!local_ring) {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        auto ring = std::make_unique<ThreadRing>();
+        ring->tid  = static_cast<int>(rings.size()) + 1;
+        ring->name = "thread " + std::to_string(ring->tid);
+        ring->events.reset(new Event[ring_capacity]);
+        ring->size = ring_capacity;
+        local_ring = ring.get();
+        rings.push_back(std::move(ring));
+    }
+    return *local_ring;
+}
+
+void writeEscaped(FILE* out, const std::string& s) {
+    for (char c : s) {
+        if (c == '"' || c == '\\') std::fputc('\\', out);
+        if (static_cast<unsigned char>(c) < 0x20) { std::fprintf(out, "\\u%04x", c); continue; }
+        std::fputc(c, out);
+    }
+}
+
+} // namespace
+
+// ── Recording ────────────────────────────────────────────────────────────────
+
+void enable(size_t events_per_thread) {
+    ring_capacity = events_per_thread > 0 ? events_per_thread : 1;
+    origin_ns     = now();
+    detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+void nameThread(const std::string& name) {
+    if (!enabled()) return;
+    ThreadRing& ring = localRing();
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    ring.name = name;
+}
+
+void record(const char* name, int64_t start_ns, int64_t end_ns,
+            const char* arg_name, uint64_t arg) {
+    ThreadRing& ring = localRing();
+    uint64_t n = ring.written.load(std::memory_order_relaxed);
+    ring.events[n % ring.size] = Event{name, arg_name, arg, start_ns, end_ns};
+    ring.written.store(n + 1, std::memory_order_release);
+}
+
+// ── Output ───────────────────────────────────────────────────────────────────
+
+bool write(const std::string& path) {
+    FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        std::cerr << "Error: cannot write trace " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    const int pid = static_cast<int>(getpid());
+    uint64_t kept = 0, dropped = 0;
+    bool first = true;
+    auto separator = [&]() { std::fputs(first ? "\n" : ",\n", out); first = false; };
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", out);
+    for (const auto& ring : rings) {
+        separator();
+        std::fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                          "\"args\":{\"name\":\"", pid, ring->tid);
+        writeEscaped(out, ring->name);
+        std::fputs("\"}}", out);
+
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        uint64_t size    = ring->size;
+        uint64_t begin   = written > size ? written - size : 0;
+        kept    += written - begin;
+        dropped += begin;
+        for (uint64_t i = begin; i < written; ++i) {
+            const Event& e = ring->events[i % size];
+            separator();
+            // Microseconds since enable(), with nanosecond precision
+            std::fprintf(out, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                              "\"ts\":%.3f,\"dur\":%.3f",
+                         e.name, pid, ring->tid,
+                         (e.start_ns - origin_ns) / 1e3, (e.end_ns - e.start_ns) / 1e3);
+            if (e.arg_name)
+                std::fprintf(out, ",\"args\":{\"%s\":%" PRIu64 "}", e.arg_name, e.arg);
+            std::fputc('}', out);
+        }
+    }
+    std::fputs("\n]}\n", out);
+
+    if (std::fclose(out) != 0) {
+        std::cerr << "Error: cannot write trace " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::cout << "Trace: " << kept << " spans from " << rings.size() << " thread(s) written to "
+              << path;
+    if (dropped > 0)
+        std::cout << " (" << dropped << " oldest overwritten; raise --trace-buffer)";
+    std::cout << std::endl;
+    return true;
+}
+
+} // namespace trace
@@ -0,0 +1,85 @@
+#include "tree_writer.hpp"
+#include <iostream>
+
+// ── RootTreeWriter ───────────────────────────────────────────────────────────
+
+bool RootTreeWriter::open(const std::string& file_path, const std::string& tree_name) {
+    close();
+    file_.reset(TFile::Open(file_path.c_str(), "RECREATE", "", opts_.compression));
+    if (!file_ || file_->IsZombie()) {
+        std::cerr << "Error: Cannot create file " << file_path << std::endl;
+        file_.reset();
+        return false;
+    }
+
+    file_->cd();
+    tree_ = new TTree(tree_name.c_str(), tree_name.c_str());
+    tree_->SetDirectory(file_.get());
+    tree_->SetAutoFlush(opts_.auto_flush);
+    createBranches(tree_);
+    entries_ = 0;
+    return true;
+}
+
+bool RootTreeWriter::close() {
+    if (!file_) return true;
+    bool ok = file_->Write(nullptr, TObject::kOverwrite) > 0;
+    if (!ok)
+        std::cerr << "Error: Failed to write tree to " << file_->GetName() << std::endl;
+    file_->Close();
+    file_.reset();
+    tree_ = nullptr;
+    return ok;
+}
+
+// ── ToyTreeWriter ────────────────────────────────────────────────────────────
+
+void ToyTreeWriter::createBranches(TTree* tree) {
+    const int b = opts_.basket_size;
+    tree->Branch("mag_plus_rec",       &mag_plus_rec_,       "mag_plus_rec/D",       b);
+    tree->Branch("theta_plus_rec",     &theta_plus_rec_,     "theta_plus_rec/D",     b);
+    tree->Branch("phi_plus_rec",       &phi_plus_rec_,       "phi_plus_rec/D",       b);
+    tree->Branch("mag_neg_rec",        &mag_neg_rec_,        "mag_neg_rec/D",        b);
+    tree->Branch("theta_neg_rec",      &theta_neg_rec_,      "theta_neg_rec/D",      b);
+    tree->Branch("phi_neg_rec",        &phi_neg_rec_,        "phi_neg_rec/D",        b);
+    tree->Branch("mag_neutral1_rec",   &mag_neutral1_rec_,   "mag_neutral1_rec/D",   b);
+    tree->Branch("theta_neutral1_rec", &theta_neutral1_rec_, "theta_neutral1_rec/D", b);
+    tree->Branch("phi_neutral1_rec",   &phi_neutral1_rec_,   "phi_neutral1_rec/D",   b);
+    tree->Branch("mag_neutral2_rec",   &mag_neutral2_rec_,   "mag_neutral2_rec/D",   b);
+    tree->Branch("theta_neutral2_rec", &theta_neutral2_rec_, "theta_neutral2_rec/D", b);
+    tree->Branch("phi_neutral2_rec",   &phi_neutral2_rec_,   "phi_neutral2_rec/D",   b);
+}
+
+// Inverse of createLorentzVector(): only the momentum direction and magnitude
+// are stored, the mass is re-applied by ToyFileProcessor on read.
+void ToyTreeWriter::fill(const DalitzEventData& event) {
+    mag_plus_rec_      = event.pi_plus.P();  theta_plus_rec_     = event.pi_plus.Theta();  phi_plus_rec_     = event.pi_plus.Phi();
+    mag_neg_rec_       = event.pi_minus.P(); theta_neg_rec_      = event.pi_minus.Theta(); phi_neg_rec_      = event.pi_minus.Phi();
+    mag_neutral1_rec_  = event.gamma1.P();   theta_neutral1_rec_ = event.gamma1.Theta();   phi_neutral1_rec_ = event.gamma1.Phi();
+    mag_neutral2_rec_  = event.gamma2.P();   theta_neutral2_rec_ = event.gamma2.Theta();   phi_neutral2_rec_ = event.gamma2.Phi();
+    fillTree();
+}
+
+// ── GluexTreeWriter ──────────────────────────────────────────────────────────
+
+void GluexTreeWriter::createBranches(TTree* tree) {
+    const int b = opts_.basket_size;
+    tree->Branch("pip_p4_kin",   "TLorentzVector", &pip_ptr_, b);
+    tree->Branch("pim_p4_kin",   "TLorentzVector", &pim_ptr_, b);
+    tree->Branch("g1_p4_kin",    "TLorentzVector", &g1_ptr_,  b);
+    tree->Branch("g2_p4_kin",    "TLorentzVector", &g2_ptr_,  b);
+    tree->Branch("imass_kfit",   &imass_kfit_,   "imass_kfit/D",   b);
+    tree->Branch("imassGG_kfit", &imassGG_kfit_, "imassGG_kfit/D", b);
+    tree->Branch("kfit_prob",    &kfit_prob_,    "kfit_prob/D",    b);
+}
+
+void GluexTreeWriter::fill(const GluexEventData& event) {
+    pip_          = event.pip;
+    pim_          = event.pim;
+    g1_           = event.g1;
+    g2_           = event.g2;
+    imass_kfit_   = event.imass_kfit;
+    imassGG_kfit_ = event.imassGG_kfit;
+    kfit_prob_    = event.kfit_prob;
+    fillTree();
+}
@@ -0,0 +1,237 @@
+#include "event_capture.hpp"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Payload of record i: i + 1 bytes of value i (record 0 is one byte)
+std::vector<uint8_t> payload(size_t i) {
+    return std::vector<uint8_t>(i + 1, static_cast<uint8_t>(i));
+}
+
+std::vector<uint8_t> readAll(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+void writeAll(const std::string& path, const std::vector<uint8_t>& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+} // namespace
+
+class CaptureTest : public ::testing::Test {
+protected:
+    static constexpr size_t RECORDS = 4;
+
+    void SetUp() override {
+        char tmpl[] = "/tmp/e2sar_utils_test_XXXXXX";
+        ASSERT_TRUE(mkdtemp(tmpl) != nullptr);
+        dir_  = tmpl;
+        path_ = dir_ + "/run.e2cap";
+    }
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(dir_, ec);
+    }
+
+    // RECORDS records, 1 ms apart, event numbers 100.., data id 7
+    void writeCapture() {
+        CaptureWriter writer;
+        ASSERT_TRUE(writer.open(path_));
+        auto t = CaptureWriter::clock::now();
+        for (size_t i = 0; i < RECORDS; ++i) {
+            auto data = payload(i);
+            ASSERT_TRUE(writer.append(t + std::chrono::milliseconds(i), 100 + i, 7,
+                                      data.data(), data.size()));
+        }
+        EXPECT_EQ(writer.recordCount(), RECORDS);
+        ASSERT_TRUE(writer.close());
+    }
+
+    // Offset just past the last record, i.e. where the index starts
+    static uint64_t recordsEnd() {
+        uint64_t off = sizeof(CaptureFileHeader);
+        for (size_t i = 0; i < RECORDS; ++i)
+            off += sizeof(CaptureRecordHeader) + payload(i).size();
+        return off;
+    }
+
+    std::string dir_;
+    std::string path_;
+};
+
+// ── Format ───────────────────────────────────────────────────────────────────
+
+TEST_F(CaptureTest, FileLayout) {
+    writeCapture();
+    auto bytes = readAll(path_);
+    ASSERT_EQ(bytes.size(), recordsEnd() + RECORDS * sizeof(uint64_t) + sizeof(CaptureFileTrailer));
+
+    CaptureFileHeader hdr;
+    std::memcpy(&hdr, bytes.data(), sizeof(hdr));
+    EXPECT_EQ(std::memcmp(hdr.magic, CAPTURE_MAGIC, sizeof(hdr.magic)), 0);
+    EXPECT_EQ(hdr.version, CAPTURE_VERSION);
+    EXPECT_GT(hdr.start_unix_ns, 0u);
+
+    CaptureFileTrailer trailer;
+    std::memcpy(&trailer, bytes.data() + bytes.size() - sizeof(trailer), sizeof(trailer));
+    EXPECT_EQ(std::memcmp(trailer.magic, CAPTURE_IDX_MAGIC, sizeof(trailer.magic)), 0);
+    EXPECT_EQ(trailer.record_count, RECORDS);
+    EXPECT_EQ(trailer.index_offset, recordsEnd());
+
+    uint64_t expected = sizeof(CaptureFileHeader);
+    for (size_t i = 0; i < RECORDS; ++i) {
+        uint64_t off;
+        std::memcpy(&off, bytes.data() + trailer.index_offset + i * sizeof(off), sizeof(off));
+        EXPECT_EQ(off, expected) << "index entry " << i;
+
+        CaptureRecordHeader rec;
+        std::memcpy(&rec, bytes.data() + off, sizeof(rec));
+        EXPECT_EQ(rec.event_num, 100 + i);
+        EXPECT_EQ(rec.data_id, 7);
+        EXPECT_EQ(rec.size, payload(i).size());
+        expected += sizeof(rec) + rec.size;
+    }
+}
+
+TEST_F(CaptureTest, RoundTrip) {
+    writeCapture();
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path_));
+    EXPECT_FALSE(reader.recovered());
+    EXPECT_GT(reader.startUnixNs(), 0u);
+    ASSERT_EQ(reader.size(), RECORDS);
+
+    for (size_t i = 0; i < RECORDS; ++i) {
+        CaptureRecord rec = reader.record(i);
+        auto data = payload(i);
+        EXPECT_EQ(rec.event_num, 100 + i);
+        EXPECT_EQ(rec.data_id, 7);
+        ASSERT_EQ(rec.size, data.size());
+        EXPECT_EQ(std::memcmp(rec.data, data.data(), data.size()), 0);
+        if (i > 0)   // appended 1 ms apart
+            EXPECT_EQ(rec.recv_ns - reader.record(i - 1).recv_ns, 1000000u);
+    }
+}
+
+TEST_F(CaptureTest, RejectsOtherFiles) {
+    writeAll(path_, std::vector<uint8_t>(sizeof(CaptureFileHeader), 'x'));
+    CaptureReader reader;
+    EXPECT_FALSE(reader.open(path_));
+    EXPECT_FALSE(reader.open(dir_ + "/missing.e2cap"));
+}
+
+// ── Recovery ─────────────────────────────────────────────────────────────────
+
+TEST_F(CaptureTest, UnclosedCaptureIsScanned) {
+    writeCapture();
+    std::filesystem::resize_file(path_, recordsEnd());   // as if never closed
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path_));
+    EXPECT_TRUE(reader.recovered());
+    ASSERT_EQ(reader.size(), RECORDS);
+    EXPECT_EQ(reader.record(RECORDS - 1).event_num, 100 + RECORDS - 1);
+}
+
+TEST_F(CaptureTest, TruncatedRecordIsDropped) {
+    writeCapture();
+    std::filesystem::resize_file(path_, recordsEnd() - 1);   // last payload cut short
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path_));
+    EXPECT_TRUE(reader.recovered());
+    ASSERT_EQ(reader.size(), RECORDS - 1);
+    EXPECT_EQ(reader.record(RECORDS - 2).event_num, 100 + RECORDS - 2);
+}
+
+TEST_F(CaptureTest, IndexEntryPastTheEndIsRejected) {
+    writeCapture();
+    auto bytes = readAll(path_);
+    uint64_t bad = bytes.size() - sizeof(CaptureRecordHeader) / 2;
+    std::memcpy(bytes.data() + recordsEnd() + 2 * sizeof(uint64_t), &bad, sizeof(bad));
+    writeAll(path_, bytes);
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path_));
+    EXPECT_TRUE(reader.recovered());
+    ASSERT_EQ(reader.size(), RECORDS);
+    EXPECT_EQ(reader.record(2).event_num, 102u);
+}
+
+TEST_F(CaptureTest, RecordOverrunningTheIndexIsRejected) {
+    writeCapture();
+    auto bytes = readAll(path_);
+    // The last record claims one byte more than it has, reaching into the index
+    uint64_t off = recordsEnd() - sizeof(CaptureRecordHeader) - payload(RECORDS - 1).size();
+    CaptureRecordHeader rec;
+    std::memcpy(&rec, bytes.data() + off, sizeof(rec));
+    rec.size += 1;
+    std::memcpy(bytes.data() + off, &rec, sizeof(rec));
+    writeAll(path_, bytes);
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path_));
+    EXPECT_TRUE(reader.recovered());
+    ASSERT_GE(reader.size(), RECORDS - 1);
+    EXPECT_EQ(reader.record(0).event_num, 100u);
+}
+
+TEST_F(CaptureTest, ImplausibleRecordCountIsRejected) {
+    writeCapture();
+    auto bytes = readAll(path_);
+    CaptureFileTrailer trailer;
+    std::memcpy(&trailer, bytes.data() + bytes.size() - sizeof(trailer), sizeof(trailer));
+    trailer.record_count = (1ull << 61) + RECORDS;   // wraps to the right byte count
+    std::memcpy(bytes.data() + bytes.size() - sizeof(trailer), &trailer, sizeof(trailer));
+    writeAll(path_, bytes);
+
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path_));
+    EXPECT_TRUE(reader.recovered());
+    EXPECT_EQ(reader.size(), RECORDS);
+}
+
+// ── Timestamps ───────────────────────────────────────────────────────────────
+
+TEST_F(CaptureTest, TimestampsAreClampedMonotonic) {
+    {
+        CaptureWriter writer;
+        ASSERT_TRUE(writer.open(path_));
+        auto t = CaptureWriter::clock::now();
+        uint8_t byte = 0;
+        // Dequeue threads can reach append() out of receive order
+        ASSERT_TRUE(writer.append(t + std::chrono::milliseconds(5), 0, 1, &byte, 1));
+        ASSERT_TRUE(writer.append(t + std::chrono::milliseconds(2), 1, 1, &byte, 1));
+        ASSERT_TRUE(writer.append(t + std::chrono::milliseconds(9), 2, 1, &byte, 1));
+        ASSERT_TRUE(writer.close());
+    }
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path_));
+    ASSERT_EQ(reader.size(), 3u);
+    EXPECT_EQ(reader.record(1).recv_ns, reader.record(0).recv_ns);
+    EXPECT_EQ(reader.record(2).recv_ns - reader.record(0).recv_ns, 4000000u);
+}
+
+TEST_F(CaptureTest, TimeBeforeStartIsZero) {
+    auto before = CaptureWriter::clock::now() - std::chrono::seconds(1);
+    {
+        CaptureWriter writer;
+        ASSERT_TRUE(writer.open(path_));
+        uint8_t byte = 0;
+        ASSERT_TRUE(writer.append(before, 0, 1, &byte, 1));
+        ASSERT_TRUE(writer.close());
+    }
+    CaptureReader reader;
+    ASSERT_TRUE(reader.open(path_));
+    ASSERT_EQ(reader.size(), 1u);
+    EXPECT_EQ(reader.record(0).recv_ns, 0u);
+}
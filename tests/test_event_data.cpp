@@ -0,0 +1,133 @@
+#include "event_data.hpp"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+// ── Fixtures ─────────────────────────────────────────────────────────────────
+
+namespace {
+
+DalitzEventData makeDalitz(double offset) {
+    DalitzEventData ev;
+    ev.pi_plus.SetPxPyPzE( 0.1 + offset,  0.2,  1.5, 1.52);
+    ev.pi_minus.SetPxPyPzE(-0.3 + offset, 0.1,  2.0, 2.03);
+    ev.gamma1.SetPxPyPzE(  0.05,  -0.4 + offset, 1.1, 1.17);
+    ev.gamma2.SetPxPyPzE( -0.02,   0.3, 0.9 + offset, 0.95);
+    return ev;
+}
+
+GluexEventData makeGluex(double offset) {
+    GluexEventData ev;
+    ev.pip.SetPxPyPzE( 0.1 + offset,  0.2,  1.5, 1.52);
+    ev.pim.SetPxPyPzE(-0.3 + offset,  0.1,  2.0, 2.03);
+    ev.g1.SetPxPyPzE(  0.05, -0.4 + offset, 1.1, 1.17);
+    ev.g2.SetPxPyPzE( -0.02,  0.3, 0.9 + offset, 0.95);
+    ev.imass_kfit   = 0.548 + offset;
+    ev.imassGG_kfit = 0.135;
+    ev.kfit_prob    = 0.42;
+    return ev;
+}
+
+void expectSame(const TLorentzVector& a, const TLorentzVector& b) {
+    EXPECT_EQ(a.E(),  b.E());
+    EXPECT_EQ(a.Px(), b.Px());
+    EXPECT_EQ(a.Py(), b.Py());
+    EXPECT_EQ(a.Pz(), b.Pz());
+}
+
+} // namespace
+
+// ── DalitzEventData ──────────────────────────────────────────────────────────
+
+TEST(DalitzEventData, SizeMatchesWireLayout) {
+    EXPECT_EQ(DalitzEventData::NUM_DOUBLES, 16u);
+    EXPECT_EQ(DalitzEventData{}.size(), 16 * sizeof(double));
+}
+
+TEST(DalitzEventData, LayoutIsEnergyThenMomentum) {
+    DalitzEventData ev = makeDalitz(0.0);
+    std::vector<double> buf;
+    ev.appendToBuffer(buf);
+    ASSERT_EQ(buf.size(), DalitzEventData::NUM_DOUBLES);
+    EXPECT_EQ(buf[0],  ev.pi_plus.E());
+    EXPECT_EQ(buf[1],  ev.pi_plus.Px());
+    EXPECT_EQ(buf[4],  ev.pi_minus.E());
+    EXPECT_EQ(buf[8],  ev.gamma1.E());
+    EXPECT_EQ(buf[15], ev.gamma2.Pz());
+}
+
+TEST(DalitzEventData, RoundTrip) {
+    DalitzEventData ev = makeDalitz(0.0);
+    std::vector<double> buf;
+    ev.appendToBuffer(buf);
+    DalitzEventData back = DalitzEventData::fromBuffer(buf.data());
+    expectSame(back.pi_plus,  ev.pi_plus);
+    expectSame(back.pi_minus, ev.pi_minus);
+    expectSame(back.gamma1,   ev.gamma1);
+    expectSame(back.gamma2,   ev.gamma2);
+}
+
+TEST(DalitzEventData, AppendsAfterExistingEvents) {
+    std::vector<double> buf;
+    for (int i = 0; i < 3; ++i)
+        makeDalitz(i).appendToBuffer(buf);
+    ASSERT_EQ(buf.size(), 3 * DalitzEventData::NUM_DOUBLES);
+    for (int i = 0; i < 3; ++i) {
+        DalitzEventData back = DalitzEventData::fromBuffer(buf.data() + i * DalitzEventData::NUM_DOUBLES);
+        expectSame(back.pi_plus, makeDalitz(i).pi_plus);
+        expectSame(back.gamma2,  makeDalitz(i).gamma2);
+    }
+}
+
+// ── GluexEventData ───────────────────────────────────────────────────────────
+
+TEST(GluexEventData, SizeMatchesWireLayout) {
+    EXPECT_EQ(GluexEventData::NUM_DOUBLES, 19u);
+    EXPECT_EQ(GluexEventData{}.size(), 19 * sizeof(double));
+}
+
+TEST(GluexEventData, ScalarsFollowFourVectors) {
+    GluexEventData ev = makeGluex(0.0);
+    std::vector<double> buf;
+    ev.appendToBuffer(buf);
+    ASSERT_EQ(buf.size(), GluexEventData::NUM_DOUBLES);
+    EXPECT_EQ(buf[0],  ev.pip.E());
+    EXPECT_EQ(buf[12], ev.g2.E());
+    EXPECT_EQ(buf[16], ev.imass_kfit);
+    EXPECT_EQ(buf[17], ev.imassGG_kfit);
+    EXPECT_EQ(buf[18], ev.kfit_prob);
+}
+
+TEST(GluexEventData, RoundTrip) {
+    std::vector<double> buf;
+    makeGluex(0.0).appendToBuffer(buf);
+    makeGluex(0.5).appendToBuffer(buf);
+    ASSERT_EQ(buf.size(), 2 * GluexEventData::NUM_DOUBLES);
+
+    for (int i = 0; i < 2; ++i) {
+        GluexEventData ev   = makeGluex(0.5 * i);
+        GluexEventData back = GluexEventData::fromBuffer(buf.data() + i * GluexEventData::NUM_DOUBLES);
+        expectSame(back.pip, ev.pip);
+        expectSame(back.pim, ev.pim);
+        expectSame(back.g1,  ev.g1);
+        expectSame(back.g2,  ev.g2);
+        EXPECT_EQ(back.imass_kfit,   ev.imass_kfit);
+        EXPECT_EQ(back.imassGG_kfit, ev.imassGG_kfit);
+        EXPECT_EQ(back.kfit_prob,    ev.kfit_prob);
+    }
+}
+
+// ── createLorentzVector ──────────────────────────────────────────────────────
+
+TEST(CreateLorentzVector, SphericalToCartesian) {
+    const double mass = 0.139;
+    TLorentzVector v = createLorentzVector(2.0, M_PI / 2, 0.0, mass);
+    EXPECT_NEAR(v.Px(), 2.0, 1e-12);
+    EXPECT_NEAR(v.Py(), 0.0, 1e-12);
+    EXPECT_NEAR(v.Pz(), 0.0, 1e-12);
+    EXPECT_NEAR(v.E(), std::sqrt(4.0 + mass * mass), 1e-12);
+
+    TLorentzVector photon = createLorentzVector(1.5, 0.0, 0.0, 0.0);
+    EXPECT_NEAR(photon.Pz(), 1.5, 1e-12);
+    EXPECT_NEAR(photon.E(),  1.5, 1e-12);
+}
@@ -0,0 +1,107 @@
+#include "event_io.hpp"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// ── formatFilename ───────────────────────────────────────────────────────────
+
+TEST(FormatFilename, ZeroPadsToWidth) {
+    EXPECT_EQ(formatFilename("event_{:08d}.dat", 42), "event_00000042.dat");
+    EXPECT_EQ(formatFilename("data_{:06d}.bin", 0), "data_000000.bin");
+}
+
+TEST(FormatFilename, WidthIsAMinimum) {
+    EXPECT_EQ(formatFilename("event_{:03d}.dat", 123456), "event_123456.dat");
+}
+
+TEST(FormatFilename, NoWidth) {
+    EXPECT_EQ(formatFilename("file_{:d}.root", 7), "file_7.root");
+}
+
+TEST(FormatFilename, EveryPlaceholderIsReplaced) {
+    EXPECT_EQ(formatFilename("run{:02d}/event_{:04d}.dat", 5), "run05/event_0005.dat");
+}
+
+TEST(FormatFilename, WithoutPlaceholderIsUnchanged) {
+    EXPECT_EQ(formatFilename("fixed.dat", 9), "fixed.dat");
+    EXPECT_EQ(formatFilename("", 9), "");
+}
+
+TEST(FormatFilename, UnterminatedPlaceholderIsKept) {
+    EXPECT_EQ(formatFilename("event_{:08d.dat", 1), "event_{:08d.dat");
+}
+
+TEST(FormatFilename, LargeEventNumbers) {
+    EXPECT_EQ(formatFilename("e{:d}", 18446744073709551615ull), "e18446744073709551615");
+}
+
+TEST(FormatFilename, MalformedSpecIsNotPadded) {
+    EXPECT_EQ(formatFilename("event_{:ab}.dat", 42), "event_42.dat");
+    EXPECT_EQ(formatFilename("event_{:08x}.dat", 42), "event_42.dat");
+    EXPECT_EQ(formatFilename("event_{:99999999999d}.dat", 42), "event_42.dat");
+}
+
+TEST(ValidFilenamePattern, AcceptsWidthAndPlainPlaceholders) {
+    EXPECT_TRUE(validFilenamePattern("event_{:08d}.dat"));
+    EXPECT_TRUE(validFilenamePattern("run{:02d}/event_{:d}.dat"));
+    EXPECT_TRUE(validFilenamePattern("fixed.dat"));
+    EXPECT_TRUE(validFilenamePattern("event_{:08d.dat"));   // unterminated, kept literally
+}
+
+TEST(ValidFilenamePattern, RejectsMalformedPlaceholders) {
+    EXPECT_FALSE(validFilenamePattern("event_{:ab}.dat"));
+    EXPECT_FALSE(validFilenamePattern("event_{:08}.dat"));
+    EXPECT_FALSE(validFilenamePattern("event_{:}.dat"));
+    EXPECT_FALSE(validFilenamePattern("event_{:d}_{:-3d}.dat"));
+}
+
+// ── Memory-mapped files ──────────────────────────────────────────────────────
+
+class MappedFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char tmpl[] = "/tmp/e2sar_utils_test_XXXXXX";
+        ASSERT_TRUE(mkdtemp(tmpl) != nullptr);
+        dir_ = tmpl;
+    }
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(dir_, ec);
+    }
+
+    std::string dir_;
+};
+
+TEST_F(MappedFileTest, WriteThenMap) {
+    std::vector<double> data = {1.0, -2.5, 3.25, 1e300};
+    std::string path = dir_ + "/event.dat";
+    ASSERT_TRUE(writeMemoryMappedFile(path, reinterpret_cast<const uint8_t*>(data.data()),
+                                      data.size() * sizeof(double)));
+
+    MappedFile in;
+    ASSERT_TRUE(in.open(path));
+    ASSERT_EQ(in.size(), data.size() * sizeof(double));
+    const double* p = reinterpret_cast<const double*>(in.data());
+    for (size_t i = 0; i < data.size(); ++i)
+        EXPECT_EQ(p[i], data[i]);
+}
+
+TEST_F(MappedFileTest, OverwriteTruncates) {
+    std::string path = dir_ + "/event.dat";
+    std::vector<uint8_t> big(4096, 0xab), small(10, 0xcd);
+    ASSERT_TRUE(writeMemoryMappedFile(path, big.data(), big.size()));
+    ASSERT_TRUE(writeMemoryMappedFile(path, small.data(), small.size()));
+
+    MappedFile in;
+    ASSERT_TRUE(in.open(path));
+    EXPECT_EQ(in.size(), small.size());
+    EXPECT_EQ(in.data()[0], 0xcd);
+}
+
+TEST_F(MappedFileTest, MissingFileFails) {
+    MappedFile in;
+    EXPECT_FALSE(in.open(dir_ + "/missing.dat"));
+    EXPECT_EQ(in.size(), 0u);
+}
@@ -0,0 +1,214 @@
+#include "file_processor.hpp"
+#include "event_generator.hpp"
+#include "tree_writer.hpp"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Runs RootFileProcessor::process() in read-only mode (no segmenter) over
+// files written with the tree writers, collecting every batch it would send.
+
+// ── Fixtures ─────────────────────────────────────────────────────────────────
+
+namespace {
+
+constexpr size_t BATCH_BYTES = 1024 * 1024;   // --bufsize 1
+
+class ProcessorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char tmpl[] = "/tmp/e2sar_utils_test_XXXXXX";
+        ASSERT_TRUE(mkdtemp(tmpl) != nullptr);
+        dir_ = tmpl;
+        verbosity = 0;
+        args_.bufsize_mb = 1;
+        args_.send_data  = false;
+    }
+    void TearDown() override {
+        verbosity = 1;
+        std::error_code ec;
+        std::filesystem::remove_all(dir_, ec);
+    }
+
+    // Write n generated toy events and return them.
+    std::vector<DalitzEventData> writeToy(const std::string& path, size_t n) {
+        std::vector<DalitzEventData> events;
+        PiPiGGGenerator gen(1234);
+        ToyTreeWriter writer;
+        EXPECT_TRUE(writer.open(path, ToyTreeWriter::DEFAULT_TREE));
+        for (size_t i = 0; i < n; ++i) {
+            events.push_back(gen.nextDalitz());
+            writer.fill(events.back());
+        }
+        EXPECT_TRUE(writer.close());
+        return events;
+    }
+
+    std::vector<GluexEventData> writeGluex(const std::string& path, size_t n) {
+        std::vector<GluexEventData> events;
+        PiPiGGGenerator gen(5678);
+        GluexTreeWriter writer;
+        EXPECT_TRUE(writer.open(path, GluexTreeWriter::DEFAULT_TREE));
+        for (size_t i = 0; i < n; ++i) {
+            events.push_back(gen.next());
+            writer.fill(events.back());
+        }
+        EXPECT_TRUE(writer.close());
+        return events;
+    }
+
+    // process() the file and return the batches handed to the sink.
+    std::vector<std::vector<double>> run(RootFileProcessor& proc, const std::string& path,
+                                         const std::string& tree, bool& ok) {
+        std::vector<std::vector<double>> batches;
+        proc.setBatchSink([&](const std::vector<double>& batch) { batches.push_back(batch); });
+        ok = proc.process(path, tree);
+        return batches;
+    }
+
+    std::string     dir_;
+    CommandLineArgs args_{};
+};
+
+std::vector<size_t> batchSizes(const std::vector<std::vector<double>>& batches) {
+    std::vector<size_t> sizes;
+    for (const auto& b : batches)
+        sizes.push_back(b.size());
+    return sizes;
+}
+
+} // namespace
+
+// ── Batch sizing ─────────────────────────────────────────────────────────────
+
+TEST_F(ProcessorTest, FullBatchesThenPartialLast) {
+    const size_t per_batch = BATCH_BYTES / DalitzEventData{}.size();
+    const size_t n         = 2 * per_batch + 5;
+    std::string path = dir_ + "/toy.root";
+    writeToy(path, n);
+
+    ToyFileProcessor proc(args_, nullptr, 0);
+    bool ok = false;
+    auto batches = run(proc, path, ToyTreeWriter::DEFAULT_TREE, ok);
+    ASSERT_TRUE(ok);
+
+    const size_t d = DalitzEventData::NUM_DOUBLES;
+    std::vector<size_t> expected = {per_batch * d, per_batch * d, 5 * d};
+    EXPECT_EQ(batchSizes(batches), expected);
+}
+
+TEST_F(ProcessorTest, ExactMultipleHasNoEmptyBatch) {
+    const size_t per_batch = BATCH_BYTES / DalitzEventData{}.size();
+    std::string path = dir_ + "/toy.root";
+    writeToy(path, per_batch);
+
+    ToyFileProcessor proc(args_, nullptr, 0);
+    bool ok = false;
+    auto batches = run(proc, path, ToyTreeWriter::DEFAULT_TREE, ok);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(batches.size(), 1u);
+    EXPECT_EQ(batches[0].size(), per_batch * DalitzEventData::NUM_DOUBLES);
+}
+
+TEST_F(ProcessorTest, EmptyTreeSendsNothing) {
+    std::string path = dir_ + "/empty.root";
+    writeToy(path, 0);
+
+    ToyFileProcessor proc(args_, nullptr, 0);
+    bool ok = false;
+    auto batches = run(proc, path, ToyTreeWriter::DEFAULT_TREE, ok);
+    EXPECT_TRUE(ok);
+    EXPECT_TRUE(batches.empty());
+}
+
+TEST_F(ProcessorTest, PrescaleKeepsEveryNthEntry) {
+    const size_t n = 1000;
+    std::string path = dir_ + "/toy.root";
+    writeToy(path, n);
+
+    SendControl control;
+    control.prescale = 3;
+    ToyFileProcessor proc(args_, nullptr, 0);
+    proc.setControl(&control);
+    bool ok = false;
+    auto batches = run(proc, path, ToyTreeWriter::DEFAULT_TREE, ok);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(batches.size(), 1u);
+    EXPECT_EQ(batches[0].size(), ((n + 2) / 3) * DalitzEventData::NUM_DOUBLES);
+}
+
+// ── Processors against generated files ───────────────────────────────────────
+
+TEST_F(ProcessorTest, ToyEventsSurviveTheRoundTrip) {
+    const size_t n = 500;
+    std::string path = dir_ + "/toy.root";
+    auto events = writeToy(path, n);
+
+    ToyFileProcessor proc(args_, nullptr, 0);
+    bool ok = false;
+    auto batches = run(proc, path, ToyTreeWriter::DEFAULT_TREE, ok);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(batches.size(), 1u);
+    ASSERT_EQ(batches[0].size(), n * DalitzEventData::NUM_DOUBLES);
+
+    // The toy schema stores |p|, θ, φ; energies are rebuilt from the
+    // processor's own masses, so compare momenta only.
+    auto near = [](const TLorentzVector& got, const TLorentzVector& want) {
+        double tol = 1e-9 * std::max(1.0, want.P());
+        EXPECT_NEAR(got.Px(), want.Px(), tol);
+        EXPECT_NEAR(got.Py(), want.Py(), tol);
+        EXPECT_NEAR(got.Pz(), want.Pz(), tol);
+    };
+    for (size_t i = 0; i < n; ++i) {
+        auto got = DalitzEventData::fromBuffer(batches[0].data() + i * DalitzEventData::NUM_DOUBLES);
+        near(got.pi_plus,  events[i].pi_plus);
+        near(got.pi_minus, events[i].pi_minus);
+        near(got.gamma1,   events[i].gamma1);
+        near(got.gamma2,   events[i].gamma2);
+        EXPECT_NEAR(got.gamma1.E(), got.gamma1.P(), 1e-12);
+    }
+}
+
+TEST_F(ProcessorTest, GluexEventsAreBitExact) {
+    const size_t per_batch = BATCH_BYTES / GluexEventData{}.size();
+    const size_t n         = per_batch + 17;
+    std::string path = dir_ + "/gluex.root";
+    auto events = writeGluex(path, n);
+
+    GluexFileProcessor proc(args_, nullptr, 0);
+    bool ok = false;
+    auto batches = run(proc, path, GluexTreeWriter::DEFAULT_TREE, ok);
+    ASSERT_TRUE(ok);
+
+    const size_t d = GluexEventData::NUM_DOUBLES;
+    std::vector<size_t> expected_sizes = {per_batch * d, 17 * d};
+    ASSERT_EQ(batchSizes(batches), expected_sizes);
+
+    std::vector<double> expected, got;
+    for (const auto& ev : events)
+        ev.appendToBuffer(expected);
+    for (const auto& b : batches)
+        got.insert(got.end(), b.begin(), b.end());
+    EXPECT_TRUE(got == expected);
+}
+
+TEST_F(ProcessorTest, MissingFileFails) {
+    ToyFileProcessor proc(args_, nullptr, 0);
+    bool ok = true;
+    auto batches = run(proc, dir_ + "/missing.root", ToyTreeWriter::DEFAULT_TREE, ok);
+    EXPECT_FALSE(ok);
+    EXPECT_TRUE(batches.empty());
+}
+
+TEST_F(ProcessorTest, MissingTreeFails) {
+    std::string path = dir_ + "/toy.root";
+    writeToy(path, 10);
+
+    ToyFileProcessor proc(args_, nullptr, 0);
+    bool ok = true;
+    run(proc, path, "no_such_tree", ok);
+    EXPECT_FALSE(ok);
+}
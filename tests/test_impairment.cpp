@@ -0,0 +1,112 @@
+#include "impairment.hpp"
+#include <gtest/gtest.h>
+
+// ── Spec parsing ─────────────────────────────────────────────────────────────
+
+TEST(ImpairmentSpec, ParsesEveryKey) {
+    ImpairmentConfig c;
+    ASSERT_TRUE(parseImpairment("loss=0.01,burst=0.001:20,dup=0.002,reorder=0.05,"
+                                "reorder-delay=500us,delay=5,jitter=0.5ms,seed=7", c));
+    EXPECT_DOUBLE_EQ(c.loss, 0.01);
+    EXPECT_DOUBLE_EQ(c.burst_enter, 0.001);
+    EXPECT_DOUBLE_EQ(c.burst_length, 20);
+    EXPECT_DOUBLE_EQ(c.duplicate, 0.002);
+    EXPECT_DOUBLE_EQ(c.reorder, 0.05);
+    EXPECT_EQ(c.reorder_delay_ns, 500000);
+    EXPECT_EQ(c.delay_ns, 5000000);          // bare numbers are ms
+    EXPECT_EQ(c.jitter_ns, 500000);
+    EXPECT_EQ(c.seed, 7u);
+    EXPECT_TRUE(c.active());
+}
+
+TEST(ImpairmentSpec, RejectsBadSpecs) {
+    ImpairmentConfig c;
+    EXPECT_FALSE(parseImpairment("loss=1.5", c));
+    EXPECT_FALSE(parseImpairment("loss", c));
+    EXPECT_FALSE(parseImpairment("delay=5h", c));
+    EXPECT_FALSE(parseImpairment("burst=0.1:0.5", c));
+    EXPECT_FALSE(parseImpairment("colour=red", c));
+}
+
+TEST(ImpairmentSpec, DescribeRoundTrips) {
+    ImpairmentConfig c, back;
+    EXPECT_EQ(c.describe(), "none");
+    ASSERT_TRUE(parseImpairment("loss=0.01,delay=5ms,jitter=250us", c));
+    ASSERT_TRUE(parseImpairment(c.describe(), back));
+    EXPECT_DOUBLE_EQ(back.loss, c.loss);
+    EXPECT_EQ(back.delay_ns, c.delay_ns);
+    EXPECT_EQ(back.jitter_ns, c.jitter_ns);
+}
+
+// ── Decisions ────────────────────────────────────────────────────────────────
+
+namespace {
+constexpr int FRAMES = 200000;
+}
+
+TEST(Impairment, InactivePassesEverythingUndelayed) {
+    Impairment imp(ImpairmentConfig{}, 0);
+    for (int i = 0; i < 1000; ++i) {
+        auto v = imp.decide();
+        ASSERT_EQ(v.copies, 1);
+        ASSERT_EQ(v.delay_ns[0], 0);
+    }
+}
+
+TEST(Impairment, RandomLossRate) {
+    ImpairmentConfig c;
+    c.loss = 0.05;
+    Impairment imp(c, 0);
+    for (int i = 0; i < FRAMES; ++i)
+        imp.decide();
+    EXPECT_NEAR(static_cast<double>(imp.dropped()) / FRAMES, 0.05, 0.005);
+}
+
+TEST(Impairment, BurstsHaveTheMeanLength) {
+    ImpairmentConfig c;
+    c.burst_enter  = 0.001;
+    c.burst_length = 20;
+    Impairment imp(c, 1);
+    int bursts = 0, lost = 0;
+    bool in_burst = false;
+    for (int i = 0; i < 2 * FRAMES; ++i) {
+        bool drop = imp.decide().copies == 0;
+        if (drop && !in_burst) bursts++;
+        lost += drop;
+        in_burst = drop;
+    }
+    ASSERT_GT(bursts, 100);
+    EXPECT_NEAR(static_cast<double>(lost) / bursts, 20.0, 3.0);
+}
+
+TEST(Impairment, DuplicatesAndDelays) {
+    ImpairmentConfig c;
+    c.duplicate = 0.1;
+    c.delay_ns  = 1000000;
+    c.jitter_ns = 200000;
+    Impairment imp(c, 2);
+    for (int i = 0; i < FRAMES; ++i) {
+        auto v = imp.decide();
+        for (int k = 0; k < v.copies; ++k) {
+            ASSERT_GE(v.delay_ns[k], 1000000);
+            ASSERT_LT(v.delay_ns[k], 1200000);
+        }
+    }
+    EXPECT_EQ(imp.dropped(), 0u);
+    EXPECT_NEAR(static_cast<double>(imp.duplicated()) / FRAMES, 0.1, 0.01);
+}
+
+TEST(Impairment, SameSeedAndStreamRepeat) {
+    ImpairmentConfig c;
+    c.loss    = 0.3;
+    c.reorder = 0.3;
+    Impairment a(c, 5), b(c, 5), other(c, 6);
+    int differ = 0;
+    for (int i = 0; i < 1000; ++i) {
+        auto va = a.decide(), vb = b.decide(), vo = other.decide();
+        ASSERT_EQ(va.copies, vb.copies);
+        ASSERT_EQ(va.delay_ns[0], vb.delay_ns[0]);
+        differ += va.copies != vo.copies;
+    }
+    EXPECT_GT(differ, 0);
+}
@@ -0,0 +1,280 @@
+#include "lb_emulator.hpp"
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <vector>
+
+// ── LB header ────────────────────────────────────────────────────────────────
+
+TEST(LBHeader, RoundTrip) {
+    uint8_t frame[LB_HEADER_BYTES];
+    writeLBHeader(frame, {2, 0xbeef, 0x0123456789abcdefull});
+    EXPECT_EQ(frame[0], 'L');
+    EXPECT_EQ(frame[1], 'B');
+    EXPECT_EQ(frame[6], 0xbe);               // network byte order
+    EXPECT_EQ(frame[15], 0xef);
+
+    LBHeader h;
+    ASSERT_TRUE(parseLBHeader(frame, sizeof(frame), h));
+    EXPECT_EQ(h.version, 2);
+    EXPECT_EQ(h.entropy, 0xbeef);
+    EXPECT_EQ(h.event_num, 0x0123456789abcdefull);
+}
+
+TEST(LBHeader, AcceptsVersion3) {
+    uint8_t frame[LB_HEADER_BYTES];
+    writeLBHeader(frame, {2, 7, 42});
+    frame[2] = 3;
+    LBHeader h;
+    ASSERT_TRUE(parseLBHeader(frame, sizeof(frame), h));
+    EXPECT_EQ(h.version, 3);
+    EXPECT_EQ(h.event_num, 42u);
+}
+
+TEST(LBHeader, RejectsShortOrForeignFrames) {
+    uint8_t frame[LB_HEADER_BYTES];
+    writeLBHeader(frame, {2, 1, 1});
+    LBHeader h;
+    EXPECT_FALSE(parseLBHeader(frame, LB_HEADER_BYTES - 1, h));
+    frame[0] = 'R';
+    EXPECT_FALSE(parseLBHeader(frame, sizeof(frame), h));
+    frame[0] = 'L';
+    frame[2] = 9;
+    EXPECT_FALSE(parseLBHeader(frame, sizeof(frame), h));
+}
+
+// ── Workers ──────────────────────────────────────────────────────────────────
+
+TEST(LBWorker, ParsesOptions) {
+    LBWorker w;
+    ASSERT_TRUE(parseLBWorker("127.0.0.1:19600", w));
+    EXPECT_EQ(w.host, "127.0.0.1");
+    EXPECT_EQ(w.port, 19600);
+    EXPECT_EQ(w.ports, 1);
+    EXPECT_DOUBLE_EQ(w.weight, 1.0);
+
+    ASSERT_TRUE(parseLBWorker("[::1]:20000,ports=3,weight=2.5", w));
+    EXPECT_EQ(w.host, "::1");
+    EXPECT_EQ(w.ports, 4);                   // rounded up to a power of two
+    EXPECT_DOUBLE_EQ(w.weight, 2.5);
+}
+
+TEST(LBWorker, RejectsBadSpecs) {
+    LBWorker w;
+    EXPECT_FALSE(parseLBWorker("127.0.0.1", w));
+    EXPECT_FALSE(parseLBWorker("127.0.0.1:0", w));
+    EXPECT_FALSE(parseLBWorker("127.0.0.1:19600,weight=0", w));
+    EXPECT_FALSE(parseLBWorker("127.0.0.1:19600,colour=red", w));
+    EXPECT_FALSE(parseLBWorker("127.0.0.1:65535,ports=2", w));
+}
+
+// ── Calendar ─────────────────────────────────────────────────────────────────
+
+TEST(LBCalendar, SlotsFollowWeights) {
+    LBCalendar cal({2.0, 1.0, 1.0}, 512);
+    EXPECT_EQ(cal.slotsFor(0), 256u);
+    EXPECT_EQ(cal.slotsFor(1), 128u);
+    EXPECT_EQ(cal.slotsFor(2), 128u);
+}
+
+TEST(LBCalendar, EveryWorkerGetsASlot) {
+    LBCalendar cal({1000.0, 1.0}, 16);
+    EXPECT_EQ(cal.slotsFor(1), 1u);
+    EXPECT_EQ(cal.slotsFor(0) + cal.slotsFor(1), 16u);
+}
+
+TEST(LBCalendar, ConsecutiveEventsAreInterleaved) {
+    LBCalendar cal({1.0, 1.0, 1.0, 1.0}, 512);
+    for (uint64_t e = 0; e < 512; e += 4) {
+        std::set<size_t> seen;
+        for (uint64_t k = 0; k < 4; ++k)
+            seen.insert(cal.workerFor(e + k));
+        EXPECT_EQ(seen.size(), 4u) << "events " << e << ".." << e + 3;
+    }
+    EXPECT_EQ(cal.workerFor(5), cal.workerFor(5 + 512));
+}
+
+// ── Forwarding over loopback ─────────────────────────────────────────────────
+
+namespace {
+
+// UDP socket bound to an ephemeral loopback port, with a receive timeout.
+int boundSocket(uint16_t& port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+        return -1;
+    timeval tv{2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+} // namespace
+
+TEST(LBEmulator, ForwardsEachEventToItsCalendarWorker) {
+    uint16_t port_a = 0, port_b = 0, listen_port = 0;
+    int rx_a = boundSocket(port_a);
+    int rx_b = boundSocket(port_b);
+    int probe = boundSocket(listen_port);    // reserve a free port number
+    ASSERT_GE(rx_a, 0);
+    ASSERT_GE(rx_b, 0);
+    ASSERT_GE(probe, 0);
+    close(probe);
+
+    LBEmulatorConfig config;
+    config.listen_port = listen_port;
+    config.workers     = {{"127.0.0.1", port_a, 1, 1.0}, {"127.0.0.1", port_b, 1, 1.0}};
+    config.strip_lb_header = true;
+    LBEmulator emulator(config);
+    ASSERT_TRUE(emulator.start());
+
+    int tx = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in dest{};
+    dest.sin_family      = AF_INET;
+    dest.sin_port        = htons(listen_port);
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const uint64_t EVENTS = 8;
+    for (uint64_t e = 0; e < EVENTS; ++e) {
+        uint8_t frame[LB_HEADER_BYTES + sizeof(uint64_t)];
+        writeLBHeader(frame, {2, 0, e});
+        std::memcpy(frame + LB_HEADER_BYTES, &e, sizeof(e));
+        ASSERT_EQ(sendto(tx, frame, sizeof(frame), 0, reinterpret_cast<sockaddr*>(&dest), sizeof(dest)),
+                  static_cast<ssize_t>(sizeof(frame)));
+    }
+
+    std::vector<uint64_t> got[2];
+    int rx[2] = {rx_a, rx_b};
+    for (uint64_t n = 0; n < EVENTS; ++n) {
+        size_t w = emulator.calendar().workerFor(n);
+        uint64_t payload = 0;
+        ASSERT_EQ(recv(rx[w], &payload, sizeof(payload), 0), static_cast<ssize_t>(sizeof(payload)))
+            << "event " << n << " did not reach worker " << w;
+        got[w].push_back(payload);
+    }
+    emulator.stop();
+
+    for (size_t w = 0; w < 2; ++w)
+        for (uint64_t e : got[w])
+            EXPECT_EQ(emulator.calendar().workerFor(e), w);
+    EXPECT_EQ(got[0].size() + got[1].size(), EVENTS);
+    EXPECT_EQ(emulator.counters().frames_in.load(), EVENTS);
+    EXPECT_EQ(emulator.counters().dropped.load(), 0u);
+
+    close(tx);
+    close(rx_a);
+    close(rx_b);
+}
+
+TEST(LBEmulator, AppliesImpairment) {
+    uint16_t rx_port = 0, listen_port = 0;
+    int rx    = boundSocket(rx_port);
+    int probe = boundSocket(listen_port);
+    ASSERT_GE(rx, 0);
+    ASSERT_GE(probe, 0);
+    close(probe);
+
+    LBEmulatorConfig config;
+    config.listen_port = listen_port;
+    config.workers     = {{"127.0.0.1", rx_port, 1, 1.0}};
+    ASSERT_TRUE(parseImpairment("delay=20ms,dup=1", config.impairment));
+    LBEmulator emulator(config);
+    ASSERT_TRUE(emulator.start());
+
+    int tx = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in dest{};
+    dest.sin_family      = AF_INET;
+    dest.sin_port        = htons(listen_port);
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    uint8_t frame[LB_HEADER_BYTES + 4] = {};
+    writeLBHeader(frame, {2, 0, 1});
+
+    auto sent = std::chrono::steady_clock::now();
+    ASSERT_EQ(sendto(tx, frame, sizeof(frame), 0, reinterpret_cast<sockaddr*>(&dest), sizeof(dest)),
+              static_cast<ssize_t>(sizeof(frame)));
+    uint8_t got[64];
+    for (int copy = 0; copy < 2; ++copy)
+        ASSERT_EQ(recv(rx, got, sizeof(got), 0), static_cast<ssize_t>(sizeof(frame)));
+    auto elapsed = std::chrono::steady_clock::now() - sent;
+    EXPECT_GE(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 20);
+
+    emulator.stop();
+    EXPECT_EQ(emulator.counters().duplicated.load(), 1u);
+    EXPECT_EQ(emulator.workerCounters(0)->frames.load(), 2u);
+    close(tx);
+    close(rx);
+}
+
+TEST(LBEmulator, SetWorkersStartsANewEpoch) {
+    uint16_t port_a = 0, port_b = 0, listen_port = 0;
+    int rx_a  = boundSocket(port_a);
+    int rx_b  = boundSocket(port_b);
+    int probe = boundSocket(listen_port);
+    ASSERT_GE(rx_a, 0);
+    ASSERT_GE(rx_b, 0);
+    ASSERT_GE(probe, 0);
+    close(probe);
+
+    LBEmulatorConfig config;
+    config.listen_port = listen_port;
+    LBEmulator emulator(config);             // no workers yet: everything is dropped
+    ASSERT_TRUE(emulator.start());
+    EXPECT_EQ(emulator.epoch(), 1u);
+
+    int tx = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in dest{};
+    dest.sin_family      = AF_INET;
+    dest.sin_port        = htons(listen_port);
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    auto send = [&](uint64_t e) {
+        uint8_t frame[LB_HEADER_BYTES + sizeof(uint64_t)];
+        writeLBHeader(frame, {2, 0, e});
+        std::memcpy(frame + LB_HEADER_BYTES, &e, sizeof(e));
+        return sendto(tx, frame, sizeof(frame), 0, reinterpret_cast<sockaddr*>(&dest), sizeof(dest));
+    };
+
+    ASSERT_GT(send(0), 0);
+    for (int i = 0; i < 200 && emulator.counters().dropped.load() == 0; ++i)
+        usleep(10000);
+    EXPECT_EQ(emulator.counters().dropped.load(), 1u);
+
+    // Worker a only. The new calendar takes over a little past the highest
+    // event seen (0), so event 1 still belongs to the empty first epoch
+    LBWorker a{"127.0.0.1", port_a, 1, 1.0, true};
+    ASSERT_TRUE(emulator.setWorkers({a}));
+    EXPECT_EQ(emulator.epoch(), 2u);
+    ASSERT_GT(send(1), 0);
+    ASSERT_GT(send(1000), 0);
+    uint64_t payload = 0;
+    ASSERT_EQ(recv(rx_a, &payload, sizeof(payload), 0), static_cast<ssize_t>(sizeof(payload)));
+    EXPECT_EQ(payload, 1000u);
+
+    // Add worker b, carrying a's counters over
+    LBWorker b{"127.0.0.1", port_b, 1, 1.0, true};
+    ASSERT_TRUE(emulator.setWorkers({a, b}, {emulator.workerCounters(0)}));
+    const LBCalendar cal = emulator.calendar();
+    uint64_t to_b = 5000;
+    while (cal.workerFor(to_b) != 1) to_b++;
+    ASSERT_GT(send(to_b), 0);
+    ASSERT_EQ(recv(rx_b, &payload, sizeof(payload), 0), static_cast<ssize_t>(sizeof(payload)));
+    EXPECT_EQ(payload, to_b);
+
+    emulator.stop();
+    EXPECT_EQ(emulator.workerCounters(0)->frames.load(), 1u);
+    EXPECT_EQ(emulator.workerCounters(1)->frames.load(), 1u);
+    EXPECT_EQ(emulator.counters().dropped.load(), 2u);
+    close(tx);
+    close(rx_a);
+    close(rx_b);
+}
@@ -18,6 +18,8 @@
 #   --mtu N         MTU size (default: 9000)
 #   --files N       Number of times to process the test file (default: 2)
 #   --dataid N      Data ID passed to E2SAR Segmenter (default: 0)
+#   --workers N     Route through e2sar-lb-emu to N receivers (default: 0,
+#                   one receiver and no emulator)
 #   --help          Show this help message
 #
 
@@ -29,14 +31,19 @@ BUFSIZE_MB=1
 MTU=9000
 NUM_FILES=2
 DATAID=0
+WORKERS=0
 SCHEMA=toy   # toy | gluex
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
 BUILD_DIR="$PROJECT_ROOT/build"
 EXECUTABLE="$BUILD_DIR/bin/e2sar-root"
+LB_EXECUTABLE="$BUILD_DIR/bin/e2sar-lb-emu"
 OUTPUT_DIR=$(mktemp -d)
 RECV_LOG="$OUTPUT_DIR/receiver.log"
 SEND_LOG="$OUTPUT_DIR/sender.log"
+LB_LOG="$OUTPUT_DIR/lb_emu.log"
+# With --workers, receiver i listens on WORKER_BASE_PORT + 10*i
+WORKER_BASE_PORT=19600
 
 # EJFAT URI for loopback testing (no control plane)
 EJFAT_URI='ejfat://token@127.0.0.1:18347/lb/0?sync=127.0.0.1&data=127.0.0.1'
@@ -48,7 +55,7 @@ YELLOW='\033[1;33m'
 NC='\033[0m' # No Color
 
 usage() {
-    head -20 "$0" | tail -17
+    head -22 "$0" | tail -19
     exit 0
 }
 
@@ -67,14 +74,16 @@ log_error() {
 cleanup() {
     log_info "Cleaning up..."
 
-    # Kill receiver if still running
-    if [[ -n "$RECV_PID" ]] && kill -0 "$RECV_PID" 2>/dev/null; then
-        kill -INT "$RECV_PID" 2>/dev/null || true
-        wait "$RECV_PID" 2>/dev/null || true
-    fi
+    # Kill receivers and the LB emulator if still running
+    for pid in "${RECV_PIDS[@]}" "$LB_PID"; do
+        if [[ -n "$pid" ]] && kill -0 "$pid" 2>/dev/null; then
+            kill -INT "$pid" 2>/dev/null || true
+            wait "$pid" 2>/dev/null || true
+        fi
+    done
 
     # Remove event files
-    rm -f "$OUTPUT_DIR"/event_*.dat 2>/dev/null || true
+    find "$OUTPUT_DIR" -name 'event_*.dat' -delete 2>/dev/null || true
 
     # Keep logs on failure, remove on success
     if [[ "$TEST_PASSED" == "true" ]]; then
@@ -117,6 +126,10 @@ while [[ $# -gt 0 ]]; do
             DATAID="$2"
             shift 2
             ;;
+        --workers)
+            WORKERS="$2"
+            shift 2
+            ;;
         --help)
             usage
             ;;
@@ -147,7 +160,13 @@ fi
 
 if [[ ! -f "$TEST_DATA" ]]; then
     log_error "Test data not found: $TEST_DATA"
-    log_error "Expected $SCHEMA data at that path"
+    log_error "Expected $SCHEMA data at that path; generate it with:"
+    log_error "  $BUILD_DIR/bin/e2sar-gen-root --$SCHEMA -o $TEST_DATA"
+    exit 1
+fi
+
+if [[ "$WORKERS" -gt 0 ]] && [[ ! -x "$LB_EXECUTABLE" ]]; then
+    log_error "LB emulator not found: $LB_EXECUTABLE"
     exit 1
 fi
 
@@ -166,33 +185,63 @@ echo "  Files:       $NUM_FILES"
 echo "  Batch size:  $BUFSIZE_MB MB"
 echo "  MTU:         $MTU"
 echo "  Data ID:     $DATAID"
+echo "  Workers:     $([[ $WORKERS -gt 0 ]] && echo "$WORKERS via e2sar-lb-emu" || echo "1 (direct)")"
 echo "  Timeout:     $TIMEOUT seconds"
 echo "  Output dir:  $OUTPUT_DIR"
 echo ""
 
-# Start receiver in background
-log_info "Starting receiver..."
-cd "$OUTPUT_DIR"
+# Start receiver(s) in background
+RECV_PIDS=()
+RECV_DIRS=()
+if [[ "$WORKERS" -gt 0 ]]; then
+    # The sender's URI points at the emulator on the default data port;
+    # each receiver gets its own port and output directory
+    LB_ARGS=()
+    for ((i=0; i<WORKERS; i++)); do
+        LB_ARGS+=(-w "127.0.0.1:$((WORKER_BASE_PORT + 10 * i))")
+        RECV_DIRS+=("$OUTPUT_DIR/worker_$i")
+    done
+    log_info "Starting LB emulator for $WORKERS workers..."
+    "$LB_EXECUTABLE" "${LB_ARGS[@]}" --stats-interval-ms 0 > "$LB_LOG" 2>&1 &
+    LB_PID=$!
+else
+    RECV_DIRS=("$OUTPUT_DIR")
+fi
 
-"$EXECUTABLE" -r \
-    -u "$EJFAT_URI" \
-    --recv-ip 127.0.0.1 \
-    --dataid "$DATAID" \
-    -o "event_{:08d}.dat" \
-    > "$RECV_LOG" 2>&1 &
+for ((i=0; i<${#RECV_DIRS[@]}; i++)); do
+    log_info "Starting receiver $i..."
+    mkdir -p "${RECV_DIRS[$i]}"
+    cd "${RECV_DIRS[$i]}"
+    PORT_ARGS=()
+    LOG="$RECV_LOG"
+    if [[ "$WORKERS" -gt 0 ]]; then
+        PORT_ARGS=(--recv-port "$((WORKER_BASE_PORT + 10 * i))")
+        LOG="$OUTPUT_DIR/receiver_$i.log"
+    fi
+
+    "$EXECUTABLE" -r \
+        -u "$EJFAT_URI" \
+        --recv-ip 127.0.0.1 \
+        "${PORT_ARGS[@]}" \
+        --dataid "$DATAID" \
+        -o "event_{:08d}.dat" \
+        > "$LOG" 2>&1 &
 
-RECV_PID=$!
-log_info "Receiver started with PID: $RECV_PID"
+    RECV_PIDS+=($!)
+    log_info "Receiver $i started with PID: $!"
+done
 
-# Wait for receiver to initialize
+# Wait for receivers to initialize
 sleep 2
 
-# Verify receiver is running
-if ! kill -0 "$RECV_PID" 2>/dev/null; then
-    log_error "Receiver failed to start. Log:"
-    cat "$RECV_LOG"
-    exit 1
-fi
+# Verify receivers and the emulator are running
+for pid in "${RECV_PIDS[@]}" "$LB_PID"; do
+    if [[ -n "$pid" ]] && ! kill -0 "$pid" 2>/dev/null; then
+        log_error "Receiver or LB emulator failed to start. Logs:"
+        cat "$OUTPUT_DIR"/*.log
+        exit 1
+    fi
+done
 
 # Start sender
 log_info "Starting sender with $NUM_FILES file(s) in parallel..."
@@ -240,7 +289,7 @@ while true; do
     fi
 
     # Count received files
-    RECEIVED_FILES=$(ls "$OUTPUT_DIR"/event_*.dat 2>/dev/null | wc -l | tr -d ' ')
+    RECEIVED_FILES=$(find "$OUTPUT_DIR" -name 'event_*.dat' | wc -l | tr -d ' ')
 
     if [[ "$RECEIVED_FILES" -ge "$EXPECTED_FILES" ]]; then
         log_info "All $EXPECTED_FILES files received"
@@ -255,19 +304,27 @@ while true; do
     sleep 1
 done
 
-# Stop receiver gracefully
-log_info "Stopping receiver..."
-kill -INT "$RECV_PID" 2>/dev/null || true
-wait "$RECV_PID" 2>/dev/null || true
+# Stop receivers and the emulator gracefully
+log_info "Stopping receiver(s)..."
+for pid in "${RECV_PIDS[@]}" "$LB_PID"; do
+    [[ -n "$pid" ]] || continue
+    kill -INT "$pid" 2>/dev/null || true
+    wait "$pid" 2>/dev/null || true
+done
 
 # Count final results
-RECEIVED_FILES=$(ls "$OUTPUT_DIR"/event_*.dat 2>/dev/null | wc -l | tr -d ' ')
+RECEIVED_FILES=$(find "$OUTPUT_DIR" -name 'event_*.dat' | wc -l | tr -d ' ')
 
 echo ""
 log_info "========== Test Results =========="
 echo "  Buffers sent:     $BUFFERS_SENT"
 echo "  Files received:   $RECEIVED_FILES"
 echo "  Send errors:      $SEND_ERRORS"
+if [[ "$WORKERS" -gt 0 ]]; then
+    for ((i=0; i<WORKERS; i++)); do
+        echo "  Worker $i:         $(find "${RECV_DIRS[$i]}" -name 'event_*.dat' | wc -l | tr -d ' ') files"
+    done
+fi
 
 # Verify results
 if [[ "$RECEIVED_FILES" -eq "$BUFFERS_SENT" ]] && [[ "$SEND_ERRORS" -eq "0" ]]; then
@@ -286,7 +343,7 @@ else
     fi
 
     log_warn "Receiver log tail:"
-    tail -20 "$RECV_LOG"
+    tail -20 "$OUTPUT_DIR"/receiver*.log
 
     TEST_PASSED=false
     exit 1
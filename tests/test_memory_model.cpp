@@ -0,0 +1,56 @@
+#include "memory_model.hpp"
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr uint64_t MB = 1024 * 1024;
+
+// Peak RSS of a sender following base + per_thread × threads + in-flight bytes
+MemorySample sample(size_t threads, size_t bufsize_mb, double rate, uint64_t batches) {
+    MemorySample s;
+    s.threads               = threads;
+    s.bufsize_mb            = bufsize_mb;
+    s.rate_gbps             = rate;
+    s.inflight_peak_batches = batches;
+    s.inflight_peak_bytes   = batches * bufsize_mb * MB;
+    s.peak_rss_bytes        = 200 * MB + threads * 30 * MB + s.inflight_peak_bytes;
+    return s;
+}
+
+} // namespace
+
+TEST(MemoryModel, FitsBaseThreadsAndInflight) {
+    MemoryModel model;
+    model.add(sample(1, 10, 0, 2));
+    model.add(sample(2, 10, 0, 4));
+    model.add(sample(4, 1, 0, 8));
+    model.add(sample(2, 50, 1.0, 12));
+    ASSERT_TRUE(model.fit());
+
+    EXPECT_NEAR(model.baseBytes(), 200.0 * MB, 1e3);
+    EXPECT_NEAR(model.perThreadBytes(), 30.0 * MB, 1e3);
+    EXPECT_NEAR(model.perInflightByte(), 1.0, 1e-6);
+    EXPECT_NEAR(model.maxUnderPrediction(), 0.0, 1e-9);
+}
+
+TEST(MemoryModel, DepthIsDeepestPerThreadByRate) {
+    MemoryModel model;
+    model.add(sample(2, 10, 0, 4));        // 2 per thread
+    model.add(sample(4, 10, -1, 4));       // unlimited too: 1 per thread
+    model.add(sample(2, 10, 1.0, 12));     // 6 per thread at 1 Gbps
+    EXPECT_DOUBLE_EQ(model.depth(0), 2.0);
+    EXPECT_DOUBLE_EQ(model.depth(1.0), 6.0);
+    EXPECT_DOUBLE_EQ(model.depth(5.0), 6.0);   // unmeasured: deepest seen
+    EXPECT_EQ(model.depths().size(), 2u);
+}
+
+TEST(MemoryModel, ConstantTermsFallIntoBase) {
+    MemoryModel model;
+    EXPECT_FALSE(model.fit());
+    model.add(sample(2, 10, 0, 4));
+    model.add(sample(2, 10, 0, 4));
+    ASSERT_TRUE(model.fit());
+    EXPECT_DOUBLE_EQ(model.perThreadBytes(), 0.0);
+    EXPECT_DOUBLE_EQ(model.perInflightByte(), 0.0);
+    EXPECT_DOUBLE_EQ(model.predictBytes(2, 10, 0), static_cast<double>(model.samples()[0].peak_rss_bytes));
+}
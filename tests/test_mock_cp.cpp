@@ -0,0 +1,173 @@
+#include "mock_cp.hpp"
+#include <gtest/gtest.h>
+#include <grpcpp/grpcpp.h>
+#include <grpc/loadbalancer.grpc.pb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstring>
+
+// ── Steering ─────────────────────────────────────────────────────────────────
+
+TEST(MockCPSteering, ScalesByControlSignal) {
+    EXPECT_DOUBLE_EQ(steeringWeight(2.0, 0.0, 0, 0), 2.0);
+    EXPECT_DOUBLE_EQ(steeringWeight(2.0, 0.5, 0, 0), 3.0);
+    EXPECT_DOUBLE_EQ(steeringWeight(2.0, -0.25, 0, 0), 1.5);
+}
+
+TEST(MockCPSteering, ClampsToFactors) {
+    EXPECT_DOUBLE_EQ(steeringWeight(1.0, 3.0, 0.5, 2.0), 2.0);
+    EXPECT_DOUBLE_EQ(steeringWeight(1.0, -0.9, 0.5, 2.0), 0.5);
+    EXPECT_GT(steeringWeight(1.0, -5.0, 0, 0), 0.0);   // never drops out while ready
+}
+
+// ── Control plane over loopback ──────────────────────────────────────────────
+
+namespace {
+
+// Free port of the given socket type on loopback, released for the caller
+uint16_t freePort(int type) {
+    int fd = socket(AF_INET, type, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+int udpReceiver(uint16_t& port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    timeval tv{2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+class MockCPTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        config.cp_port               = freePort(SOCK_STREAM);
+        config.sync_port             = freePort(SOCK_DGRAM);
+        config.data_plane.listen_port = freePort(SOCK_DGRAM);
+        config.token                 = "secret";
+        config.epoch_ms              = 60000;     // rebalanced by hand
+        cp = std::make_unique<MockControlPlane>(config);
+        ASSERT_TRUE(cp->start());
+        stub = loadbalancer::LoadBalancer::NewStub(grpc::CreateChannel(
+            "127.0.0.1:" + std::to_string(config.cp_port), grpc::InsecureChannelCredentials()));
+    }
+
+    void TearDown() override { if (cp) cp->stop(); }
+
+    void authorize(grpc::ClientContext& context, const std::string& token) {
+        context.AddMetadata("authorization", "Bearer " + token);
+    }
+
+    MockCPConfig config;
+    std::unique_ptr<MockControlPlane> cp;
+    std::unique_ptr<loadbalancer::LoadBalancer::Stub> stub;
+};
+
+} // namespace
+
+TEST_F(MockCPTest, RejectsBadTokenAndUnknownLB) {
+    grpc::ClientContext bad_token;
+    authorize(bad_token, "wrong");
+    loadbalancer::AddSendersRequest req;
+    req.set_lbid("1");
+    loadbalancer::AddSendersReply rep;
+    EXPECT_EQ(stub->AddSenders(&bad_token, req, &rep).error_code(), grpc::StatusCode::UNAUTHENTICATED);
+
+    grpc::ClientContext bad_lb;
+    authorize(bad_lb, "secret");
+    req.set_lbid("7");
+    EXPECT_EQ(stub->AddSenders(&bad_lb, req, &rep).error_code(), grpc::StatusCode::NOT_FOUND);
+}
+
+TEST_F(MockCPTest, RegisterReportAndSteer) {
+    grpc::ClientContext add;
+    authorize(add, "secret");
+    loadbalancer::AddSendersRequest senders;
+    senders.set_lbid("1");
+    senders.add_senderaddresses("127.0.0.1");
+    loadbalancer::AddSendersReply added;
+    ASSERT_TRUE(stub->AddSenders(&add, senders, &added).ok());
+    EXPECT_EQ(cp->senders(), std::vector<std::string>{"127.0.0.1"});
+
+    uint16_t rx_port = 0;
+    int rx = udpReceiver(rx_port);
+    grpc::ClientContext reg;
+    authorize(reg, "secret");
+    loadbalancer::RegisterRequest request;
+    request.set_lbid("1");
+    request.set_name("node1");
+    request.set_weight(1.0f);
+    request.set_ipaddress("127.0.0.1");
+    request.set_udpport(rx_port);
+    request.set_portrange(0);
+    loadbalancer::RegisterReply registered;
+    ASSERT_TRUE(stub->Register(&reg, request, &registered).ok());
+    ASSERT_FALSE(registered.sessionid().empty());
+
+    // Not ready yet: no slots after a rebalance
+    EXPECT_FALSE(cp->rebalance());
+    ASSERT_EQ(cp->workers().size(), 1u);
+    EXPECT_EQ(cp->workers()[0].routed_ns, 0);
+
+    grpc::ClientContext state;
+    authorize(state, registered.token());            // the session token
+    loadbalancer::SendStateRequest report;
+    report.set_sessionid(registered.sessionid());
+    report.set_fillpercent(0.25f);
+    report.set_controlsignal(0.5f);
+    report.set_isready(true);
+    loadbalancer::SendStateReply reported;
+    ASSERT_TRUE(stub->SendState(&state, report, &reported).ok());
+    EXPECT_TRUE(cp->rebalance());
+
+    MockCPWorker w = cp->workers()[0];
+    EXPECT_EQ(w.reports, 1u);
+    EXPECT_FLOAT_EQ(w.fill_percent, 0.25);
+    EXPECT_DOUBLE_EQ(w.slot_weight, 1.5);
+    EXPECT_GT(w.routed_ns, 0);
+    EXPECT_EQ(cp->dataPlane().epoch(), 2u);
+
+    // An event through the data plane arrives with the LB header stripped
+    int tx = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in dest{};
+    dest.sin_family      = AF_INET;
+    dest.sin_port        = htons(config.data_plane.listen_port);
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    uint8_t frame[LB_HEADER_BYTES + 4] = {};
+    writeLBHeader(frame, {2, 0, 1000});
+    std::memcpy(frame + LB_HEADER_BYTES, "evt!", 4);
+    ASSERT_EQ(sendto(tx, frame, sizeof(frame), 0, reinterpret_cast<sockaddr*>(&dest), sizeof(dest)),
+              static_cast<ssize_t>(sizeof(frame)));
+    char payload[16] = {};
+    ASSERT_EQ(recv(rx, payload, sizeof(payload), 0), 4);
+    EXPECT_EQ(std::string(payload, 4), "evt!");
+
+    grpc::ClientContext dereg;
+    authorize(dereg, registered.token());
+    loadbalancer::DeregisterRequest gone;
+    gone.set_lbid("1");
+    gone.set_sessionid(registered.sessionid());
+    loadbalancer::DeregisterReply deregistered;
+    ASSERT_TRUE(stub->Deregister(&dereg, gone, &deregistered).ok());
+    EXPECT_TRUE(cp->workers().empty());
+    EXPECT_EQ(cp->dataPlane().workers().size(), 0u);
+
+    close(tx);
+    close(rx);
+}
@@ -0,0 +1,44 @@
+#include "scaling.hpp"
+#include <gtest/gtest.h>
+
+TEST(Scaling, ParsesModes) {
+    ScalingMode mode = ScalingMode::None;
+    EXPECT_TRUE(parseScalingMode("strong", mode));
+    EXPECT_EQ(mode, ScalingMode::Strong);
+    EXPECT_TRUE(parseScalingMode("weak", mode));
+    EXPECT_EQ(mode, ScalingMode::Weak);
+    EXPECT_FALSE(parseScalingMode("linear", mode));
+    EXPECT_STREQ(scalingModeName(ScalingMode::Strong), "strong");
+}
+
+TEST(Scaling, SpeedupAndEfficiencyRelativeToFewestThreads) {
+    ScalingCurve curve;
+    curve.add(4, 7.0);
+    curve.add(2, 3.8);
+    curve.add(2, 4.2);          // averaged with the 3.8
+    curve.add(8, 8.0);
+
+    auto points = curve.points();
+    ASSERT_EQ(points.size(), 3u);
+    EXPECT_EQ(points[0].threads, 2u);
+    EXPECT_EQ(points[0].trials, 2u);
+    EXPECT_DOUBLE_EQ(points[0].gbps, 4.0);
+    EXPECT_DOUBLE_EQ(points[0].efficiency, 1.0);
+    EXPECT_DOUBLE_EQ(points[1].speedup, 1.75);
+    EXPECT_DOUBLE_EQ(points[1].efficiency, 0.875);
+    EXPECT_DOUBLE_EQ(points[2].efficiency, 0.5);
+}
+
+TEST(Scaling, KneeIsFirstPointBelowThreshold) {
+    ScalingCurve curve;
+    EXPECT_TRUE(curve.points().empty());
+    EXPECT_EQ(curve.knee(), 0u);
+
+    curve.add(1, 1.0);
+    curve.add(2, 1.9);
+    EXPECT_EQ(curve.knee(), 0u);            // 95%: still scaling
+    curve.add(4, 2.4);
+    curve.add(8, 2.5);
+    EXPECT_EQ(curve.knee(), 4u);            // 60%
+    EXPECT_EQ(curve.knee(0.25), 0u);
+}